@@ -0,0 +1,73 @@
+#include "color_lut.h"
+#include <avr/eeprom.h>
+#include <util/atomic.h>
+#include <string.h>
+
+// Tables stored in EEPROM, only used if `flags` is exactly COLOR_LUT_ENABLE
+struct stored_color_lut_t {
+  uint8_t flags;
+  uint8_t tables[COLOR_LUT_SIZE];
+} __attribute__((packed));
+
+#define COLORLUT __attribute__((section(".colorlut"), used))
+static const struct stored_color_lut_t STORED_LUT COLORLUT;
+
+// Tables as uploaded over USB, written from the USB interrupt
+static uint8_t uploaded[COLOR_LUT_SIZE];
+static volatile bool uploaded_enabled;
+
+// Tables used by the display driver
+static uint8_t active[COLOR_LUT_SIZE];
+
+void init_color_lut() {
+  uploaded_enabled = eeprom_read_byte(&STORED_LUT.flags) == COLOR_LUT_ENABLE;
+  if (uploaded_enabled) {
+    eeprom_read_block(uploaded, STORED_LUT.tables, COLOR_LUT_SIZE);
+  }
+}
+
+bool write_color_lut(uint16_t offset, const uint8_t* data, uint16_t length, uint8_t flags) {
+  if (offset > COLOR_LUT_SIZE || length > COLOR_LUT_SIZE - offset) {
+    return false;
+  }
+
+  if (length) {
+    memcpy(uploaded + offset, data, length);
+  }
+  uploaded_enabled = flags & COLOR_LUT_ENABLE;
+
+  if (flags & COLOR_LUT_STORE) {
+    // Invalidate the stored tables while writing, so a reset never loads a partial update
+    eeprom_update_byte((uint8_t*) &STORED_LUT.flags, 0);
+    eeprom_update_block(uploaded, (void*) STORED_LUT.tables, COLOR_LUT_SIZE);
+    if (uploaded_enabled) {
+      eeprom_update_byte((uint8_t*) &STORED_LUT.flags, COLOR_LUT_ENABLE);
+    }
+  }
+
+  return true;
+}
+
+uint8_t get_color_lut_flags() {
+  uint8_t flags = 0;
+  if (uploaded_enabled) {
+    flags |= COLOR_LUT_ENABLE;
+  }
+  // Uploads without COLOR_LUT_STORE leave the stored tables in place
+  if (eeprom_read_byte(&STORED_LUT.flags) == COLOR_LUT_ENABLE) {
+    flags |= COLOR_LUT_STORE;
+  }
+  return flags;
+}
+
+const uint8_t* load_color_lut() {
+  bool enabled;
+  // The USB interrupt may be writing the uploaded tables
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    enabled = uploaded_enabled;
+    if (enabled) {
+      memcpy(active, uploaded, COLOR_LUT_SIZE);
+    }
+  }
+  return enabled ? active : NULL;
+}
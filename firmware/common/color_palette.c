@@ -0,0 +1,18 @@
+#include "color_palette.h"
+#include "display_properties.h"
+#include <stdlib.h>
+
+// Entries in the frame buffer's LED format, written from the USB interrupt
+static uint8_t* palette;
+
+void init_color_palette() {
+  palette = calloc(COLOR_PALETTE_LENGTH, get_led_size());
+}
+
+size_t get_color_palette_size() {
+  return palette ? COLOR_PALETTE_LENGTH*get_led_size() : 0;
+}
+
+uint8_t* get_color_palette() {
+  return palette;
+}
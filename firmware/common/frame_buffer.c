@@ -1,4 +1,5 @@
 #include "frame_buffer.h"
+#include "telemetry.h"
 #include <util/atomic.h>
 #include <stdlib.h>
 #include <string.h>
@@ -19,12 +20,21 @@ size_t get_frame_buffer_size() {
 
 void init_frame_buffers() {
   const size_t buffer_size = get_frame_buffer_size();
-  buffer_data = malloc(buffer_size*BUFFER_LIST_LENGTH);
-  if (buffer_data) {
-    for (uint8_t i = 0; i < BUFFER_LIST_LENGTH; ++i) {
-      buffer_list[i].buffer = buffer_data + i*buffer_size;
-    }
+  // Large frames, e.g. with 16 bit colors, may only leave room for fewer buffers
+  uint8_t buffer_count = BUFFER_LIST_LENGTH;
+  buffer_data = malloc(buffer_size*buffer_count);
+  while (!buffer_data && buffer_count > 1) {
+    --buffer_count;
+    buffer_data = malloc(buffer_size*buffer_count);
+  }
+  if (!buffer_data) {
+    buffer_count = 0;
+  }
+  for (uint8_t i = 0; i < buffer_count; ++i) {
+    buffer_list[i].buffer = buffer_data + i*buffer_size;
   }
+  // Buffers without memory are never handed out
+  buffer_taken = ((1<<BUFFER_LIST_LENGTH)-1) & ~((1<<buffer_count)-1);
 }
 
 // Frame memory management functions
@@ -48,6 +58,12 @@ struct frame_buffer_t* create_frame() {
       f = &(buffer_list[buffer]);
     }
   }
+  if (f) {
+    f->flags = 0;
+  }
+  else {
+    telemetry_count(TELEMETRY_ALLOC_FAILED);
+  }
   return f;
 }
 
@@ -1,47 +1,241 @@
 #include "frame_queue.h"
+#include "telemetry.h"
 #include <stdint.h>
+#include <stdatomic.h>
 #include <util/atomic.h>
 
+/* Lock-free bounded queue for multiple producers and a single consumer.
+ * Frames are pushed from the main loop (local renderers) and the USB interrupt (remote frames),
+ * and only popped by the main loop.
+ *
+ * `write` and `read` are free running counters, so the number of used slots is always
+ * `write-read`, and QUEUE_SIZE must be a power of two.
+ * Producers first reserve a slot by incrementing `write`, and then publish the frame by storing
+ * the pointer into the slot. A slot is empty when it contains NULL, so the consumer never
+ * returns a reserved slot that has not been published yet.
+ */
 #define QUEUE_SIZE 2
-static struct frame_buffer_t* frame_queue[QUEUE_SIZE];
-static uint8_t write;
-static bool write_wrapped;
-static uint8_t read;
-static bool read_wrapped;
+#define QUEUE_INDEX(counter) ((counter) & (QUEUE_SIZE-1))
+
+static volatile atomic_uint_least8_t write;
+static volatile atomic_uint_least8_t read;
+
+/* The mailbox holds at most one frame, pushed with push_latest_frame().
+ * A new frame replaces the frame in the mailbox, so producers never have to wait for the
+ * consumer. The mailbox is only checked by pop_due_frame() once the FIFO is empty.
+ */
+
+#if defined(__AVR__)
+/* Pointers are two bytes wide on AVR, and only single byte atomics are supported by the
+ * compiler. Slot accesses and slot reservation therefore disable interrupts, but only for the
+ * few instructions required for the access itself.
+ */
+static struct frame_buffer_t* volatile frame_queue[QUEUE_SIZE];
+
+static inline struct frame_buffer_t* load_slot(uint8_t index) {
+  struct frame_buffer_t* frame;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    frame = frame_queue[index];
+  }
+  return frame;
+}
+
+static inline void store_slot(uint8_t index, struct frame_buffer_t* frame) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    frame_queue[index] = frame;
+  }
+}
+
+static struct frame_buffer_t* volatile mailbox;
+
+static inline struct frame_buffer_t* load_mailbox() {
+  struct frame_buffer_t* frame;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    frame = mailbox;
+  }
+  return frame;
+}
+
+static inline struct frame_buffer_t* exchange_mailbox(struct frame_buffer_t* frame) {
+  struct frame_buffer_t* previous;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    previous = mailbox;
+    mailbox = frame;
+  }
+  return previous;
+}
+
+static inline bool restore_mailbox(struct frame_buffer_t* frame) {
+  bool restored = false;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if (!mailbox) {
+      mailbox = frame;
+      restored = true;
+    }
+  }
+  return restored;
+}
+
+static inline bool reserve_slot(uint8_t* index) {
+  bool reserved = false;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    const uint8_t w = atomic_load_explicit(&write, memory_order_relaxed);
+    if ((uint8_t) (w - atomic_load_explicit(&read, memory_order_relaxed)) < QUEUE_SIZE) {
+      atomic_store_explicit(&write, w+1, memory_order_relaxed);
+      *index = QUEUE_INDEX(w);
+      reserved = true;
+    }
+  }
+  return reserved;
+}
+#else
+/* Compiles to LDREX/STREX on Cortex-M4. Exception entry and return clear the exclusive monitor,
+ * so a producer that is interrupted by another producer will simply retry the reservation.
+ */
+static struct frame_buffer_t* _Atomic frame_queue[QUEUE_SIZE];
+
+static inline struct frame_buffer_t* load_slot(uint8_t index) {
+  return atomic_load_explicit(&frame_queue[index], memory_order_acquire);
+}
+
+static inline void store_slot(uint8_t index, struct frame_buffer_t* frame) {
+  atomic_store_explicit(&frame_queue[index], frame, memory_order_release);
+}
+
+static struct frame_buffer_t* _Atomic mailbox;
+
+static inline struct frame_buffer_t* load_mailbox() {
+  return atomic_load_explicit(&mailbox, memory_order_acquire);
+}
+
+static inline struct frame_buffer_t* exchange_mailbox(struct frame_buffer_t* frame) {
+  return atomic_exchange_explicit(&mailbox, frame, memory_order_acq_rel);
+}
+
+static inline bool restore_mailbox(struct frame_buffer_t* frame) {
+  struct frame_buffer_t* expected = NULL;
+  return atomic_compare_exchange_strong_explicit(
+      &mailbox, &expected, frame, memory_order_release, memory_order_relaxed
+  );
+}
+
+static inline bool reserve_slot(uint8_t* index) {
+  uint_least8_t w = atomic_load_explicit(&write, memory_order_relaxed);
+  do {
+    const uint8_t r = atomic_load_explicit(&read, memory_order_acquire);
+    if ((uint8_t) (w - r) >= QUEUE_SIZE) {
+      return false;
+    }
+  } while (!atomic_compare_exchange_weak_explicit(
+      &write, &w, (uint8_t) (w+1), memory_order_relaxed, memory_order_relaxed
+  ));
+  *index = QUEUE_INDEX(w);
+  return true;
+}
+#endif
+
+// Release a frame that is discarded without being drawn
+static inline void release_frame(struct frame_buffer_t* frame) {
+  if (frame && (frame->flags & FRAME_FREE_AFTER_DRAW)) {
+    destroy_frame(frame);
+  }
+}
+
+// Number of display frames until a frame is due, negative if the frame is late
+static inline int16_t frames_early(const struct frame_buffer_t* frame, uint16_t frame_counter) {
+  if (frame->flags & FRAME_PRESENTATION_TIME) {
+    // Frame counters wrap around, so compare the signed difference
+    return frame->display_frame_counter - frame_counter;
+  }
+  return 0;
+}
 
 bool frame_queue_full() {
-  return (write == read) && (read_wrapped != write_wrapped);
+  const uint8_t r = atomic_load_explicit(&read, memory_order_acquire);
+  return (uint8_t) (atomic_load_explicit(&write, memory_order_relaxed) - r) >= QUEUE_SIZE;
+}
+
+uint8_t frame_queue_free_slots() {
+  const uint8_t r = atomic_load_explicit(&read, memory_order_acquire);
+  const uint8_t used = atomic_load_explicit(&write, memory_order_relaxed) - r;
+  return used < QUEUE_SIZE ? QUEUE_SIZE - used : 0;
 }
 
 bool frame_queue_empty() {
-  return (write == read) && (read_wrapped == write_wrapped);
+  if (load_slot(QUEUE_INDEX(atomic_load_explicit(&read, memory_order_relaxed))) != NULL) {
+    return false;
+  }
+  return load_mailbox() == NULL;
 }
 
 bool push_frame(struct frame_buffer_t* frame) {
-  bool can_push = false;
-  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
-    can_push = !frame_queue_full();
-    if (can_push) {
-      frame_queue[write] = frame;
-      write = (write+1)%QUEUE_SIZE;
-      if (write == 0) {
-        write_wrapped = !write_wrapped;
-      }
-    }
+  uint8_t index;
+  if (!frame) {
+    return false;
+  }
+  if (!reserve_slot(&index)) {
+    telemetry_count(TELEMETRY_PUSH_REFUSED);
+    return false;
   }
-  return can_push;
+  store_slot(index, frame);
+  return true;
+}
+
+bool push_latest_frame(struct frame_buffer_t* frame) {
+  if (!frame) {
+    return false;
+  }
+  struct frame_buffer_t* replaced = exchange_mailbox(frame);
+  if (replaced) {
+    telemetry_count(TELEMETRY_FRAMES_REPLACED);
+    release_frame(replaced);
+  }
+  return true;
 }
 
 struct frame_buffer_t* pop_frame() {
-  struct frame_buffer_t* ptr = 0;
-  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
-    if (!frame_queue_empty()) {
-      ptr = frame_queue[read];
-      read = (read+1)%QUEUE_SIZE;
-      if (read == 0) {
-        read_wrapped = !read_wrapped;
+  const uint8_t r = atomic_load_explicit(&read, memory_order_relaxed);
+  struct frame_buffer_t* frame = load_slot(QUEUE_INDEX(r));
+  if (frame) {
+    // Clear the slot before releasing it to the producers
+    store_slot(QUEUE_INDEX(r), NULL);
+    atomic_store_explicit(&read, (uint8_t) (r+1), memory_order_release);
+  }
+  return frame;
+}
+
+struct frame_buffer_t* pop_due_frame(uint16_t display_frame_counter) {
+  struct frame_buffer_t* frame;
+  while ((frame = load_slot(QUEUE_INDEX(atomic_load_explicit(&read, memory_order_relaxed))))) {
+    const int16_t early = frames_early(frame, display_frame_counter);
+    if (early > 0) {
+      return NULL;
+    }
+    pop_frame();
+    if (early == 0) {
+      return frame;
+    }
+    telemetry_count(TELEMETRY_FRAMES_LATE);
+    release_frame(frame);
+  }
+
+  // Only take the mailbox frame once all older frames have been popped
+  while ((frame = exchange_mailbox(NULL))) {
+    const int16_t early = frames_early(frame, display_frame_counter);
+    if (early == 0) {
+      return frame;
+    }
+    else if (early > 0) {
+      // Put the frame back, unless a producer has pushed a newer frame in the mean time
+      if (restore_mailbox(frame)) {
+        return NULL;
       }
+      telemetry_count(TELEMETRY_FRAMES_REPLACED);
+    }
+    else {
+      telemetry_count(TELEMETRY_FRAMES_LATE);
     }
+    release_frame(frame);
   }
-  return ptr;
+  return NULL;
 }
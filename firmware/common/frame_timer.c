@@ -5,6 +5,7 @@
 #include <stddef.h>
 #include <string.h>
 #include <stdatomic.h>
+#include <util/atomic.h>
 
 /* FRAME COUNTER */
 static atomic_flag frame_counter_phase_lock;
@@ -36,9 +37,24 @@ bool correct_display_frame_counter(const int16_t frame_diff) {
 /* MAIN LOOP FRAME DISPLAY CONTROL */
 static void timer_rollover_callback();
 static volatile atomic_bool draw_frame;
+// Roll-overs since the current frame draw was flagged
+static volatile uint8_t missed_rollovers;
+
+// Frame budget statistics, updated by clear_draw_frame()
+static int32_t min_slack;
+static uint16_t frames_measured;
+static uint16_t ticks_missed;
+
+static void reset_frame_budget() {
+  min_slack = INT32_MAX;
+  frames_measured = 0;
+  ticks_missed = 0;
+}
 
 void init_frame_timer() {
   atomic_init(&draw_frame, false);
+  missed_rollovers = 0;
+  reset_frame_budget();
 
   frame_counter_phase.display_frame_counter = 0;
   frame_counter_phase.usb_frame_counter = 0xffff;
@@ -52,7 +68,45 @@ bool should_draw_frame() {
 }
 
 void clear_draw_frame() {
-  draw_frame = false;
+  timer_count_t count;
+  uint8_t missed;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    count = get_counts_current();
+    missed = missed_rollovers;
+    missed_rollovers = 0;
+    draw_frame = false;
+    // A roll-over of which the interrupt is still pending was missed as well
+    if (is_rollover_pending()) {
+      count = get_counts_current();
+      if (missed < UINT8_MAX) {
+        ++missed;
+      }
+    }
+
+    // Slack to the next roll-over
+    const int32_t interval = (int32_t) get_counts_max() + 1;
+    const int32_t elapsed = get_counter_direction() > 0 ? count : get_counts_max() - count;
+    const int32_t slack = interval - elapsed - missed*interval;
+
+    if (slack < min_slack) {
+      min_slack = slack;
+    }
+    ++frames_measured;
+    ticks_missed += missed;
+  }
+}
+
+void read_frame_budget(struct frame_budget_t* budget, bool clear) {
+  budget->interval_us = 1000000UL/DEVICE_FPS;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    budget->interval_counts = (uint32_t) get_counts_max() + 1;
+    budget->min_slack_counts = frames_measured ? min_slack : 0;
+    budget->frames_measured = frames_measured;
+    budget->ticks_missed = ticks_missed;
+    if (clear) {
+      reset_frame_budget();
+    }
+  }
 }
 
 
@@ -111,7 +165,6 @@ void correct_display_frame_phase(const int8_t ms_shift) {
 
 
 /* USB SOF TRACKING */
-#include <util/atomic.h>
 
 // Valid values are 0 - 0x7FF
 static uint16_t current_usb_frame_counter;
@@ -176,6 +229,10 @@ static void timer_rollover_callback() {
     frame_counter_phase.usb_frame_counter = current_usb_frame_counter;
     atomic_flag_clear(&frame_counter_phase_lock);
   }
+  // The main loop is still busy with the previous frame
+  if (draw_frame && missed_rollovers < UINT8_MAX) {
+    ++missed_rollovers;
+  }
   draw_frame = true;
 
   // Use a small state machine to implement SOF frequency tracking and phase shifting
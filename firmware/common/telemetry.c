@@ -0,0 +1,49 @@
+#include "telemetry.h"
+
+#if defined(__AVR__)
+#include <util/atomic.h>
+
+// Only single byte atomics are supported, so counter accesses disable interrupts
+static volatile uint16_t counters[TELEMETRY_COUNTER_COUNT];
+
+void telemetry_count(enum telemetry_counter_t counter) {
+  if (counter < TELEMETRY_COUNTER_COUNT) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      counters[counter]++;
+    }
+  }
+}
+
+void read_telemetry(uint16_t* values, bool clear) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    for (uint8_t i = 0; i < TELEMETRY_COUNTER_COUNT; ++i) {
+      values[i] = counters[i];
+      if (clear) {
+        counters[i] = 0;
+      }
+    }
+  }
+}
+#else
+#include <stdatomic.h>
+
+// Counters may be incremented by the frame queue, which should not disable interrupts
+static atomic_uint_least16_t counters[TELEMETRY_COUNTER_COUNT];
+
+void telemetry_count(enum telemetry_counter_t counter) {
+  if (counter < TELEMETRY_COUNTER_COUNT) {
+    atomic_fetch_add_explicit(&counters[counter], 1, memory_order_relaxed);
+  }
+}
+
+void read_telemetry(uint16_t* values, bool clear) {
+  for (unsigned int i = 0; i < TELEMETRY_COUNTER_COUNT; ++i) {
+    if (clear) {
+      values[i] = atomic_exchange_explicit(&counters[i], 0, memory_order_relaxed);
+    }
+    else {
+      values[i] = atomic_load_explicit(&counters[i], memory_order_relaxed);
+    }
+  }
+}
+#endif
@@ -0,0 +1,104 @@
+#include "trace.h"
+#include <string.h>
+
+#if (TRACE_BUFFER_LENGTH & (TRACE_BUFFER_LENGTH - 1)) != 0
+#error "TRACE_BUFFER_LENGTH must be a power of two"
+#endif
+
+#define TRACE_TIMESTAMP_MASK ((UINT32_C(1) << TRACE_TIMESTAMP_BITS) - 1)
+#define RECORD(event) \
+  ((get_trace_timestamp() & TRACE_TIMESTAMP_MASK) | ((uint32_t) (event) << TRACE_TIMESTAMP_BITS))
+
+static uint32_t records[TRACE_BUFFER_LENGTH];
+
+// Write the header, and copy count records starting from index
+static uint16_t copy_records(
+    uint8_t* buffer
+  , uint16_t length
+  , uint16_t index
+  , uint16_t count
+  , uint16_t lost
+) {
+  const uint16_t max_count = (length - sizeof(struct trace_header_t))/sizeof(uint32_t);
+  if (count > max_count) {
+    count = max_count;
+  }
+  const struct trace_header_t header = {TRACE_TIMESTAMP_FREQUENCY, count, lost};
+  memcpy(buffer, &header, sizeof(header));
+  buffer += sizeof(header);
+  for (uint16_t i = 0; i < count; ++i, ++index) {
+    memcpy(buffer, &records[index % TRACE_BUFFER_LENGTH], sizeof(uint32_t));
+    buffer += sizeof(uint32_t);
+  }
+  return count;
+}
+
+#if defined(__AVR__)
+#include <util/atomic.h>
+
+// Only single byte atomics are supported, so buffer accesses disable interrupts
+static uint16_t write_index;
+static uint16_t read_index;
+static uint16_t records_lost;
+
+void trace_record(uint8_t event) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    records[write_index % TRACE_BUFFER_LENGTH] = RECORD(event);
+    ++write_index;
+  }
+}
+
+uint16_t read_trace(uint8_t* buffer, uint16_t length, bool clear) {
+  if (length < sizeof(struct trace_header_t)) {
+    return 0;
+  }
+  uint16_t count;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    // Drop the records that have been overwritten
+    const uint16_t available = write_index - read_index;
+    if (available > TRACE_BUFFER_LENGTH) {
+      records_lost += available - TRACE_BUFFER_LENGTH;
+      read_index = write_index - TRACE_BUFFER_LENGTH;
+    }
+    count = copy_records(buffer, length, read_index, write_index - read_index, records_lost);
+    if (clear) {
+      read_index += count;
+      records_lost = 0;
+    }
+  }
+  return sizeof(struct trace_header_t) + count*sizeof(uint32_t);
+}
+#else
+#include <stdatomic.h>
+
+// Records may be appended by interrupts of any priority, which should not be delayed
+static atomic_uint_least32_t write_index;
+// Only changed by read_trace()
+static uint32_t read_index;
+static uint16_t records_lost;
+
+void trace_record(uint8_t event) {
+  const uint32_t index = atomic_fetch_add_explicit(&write_index, 1, memory_order_relaxed);
+  records[index % TRACE_BUFFER_LENGTH] = RECORD(event);
+}
+
+uint16_t read_trace(uint8_t* buffer, uint16_t length, bool clear) {
+  if (length < sizeof(struct trace_header_t)) {
+    return 0;
+  }
+  // Records appended while copying are left for the next read
+  const uint32_t end = atomic_load_explicit(&write_index, memory_order_relaxed);
+  const uint32_t available = end - read_index;
+  if (available > TRACE_BUFFER_LENGTH) {
+    const uint32_t lost = records_lost + available - TRACE_BUFFER_LENGTH;
+    records_lost = lost > UINT16_MAX ? UINT16_MAX : lost;
+    read_index = end - TRACE_BUFFER_LENGTH;
+  }
+  const uint16_t count = copy_records(buffer, length, read_index, end - read_index, records_lost);
+  if (clear) {
+    read_index += count;
+    records_lost = 0;
+  }
+  return sizeof(struct trace_header_t) + count*sizeof(uint32_t);
+}
+#endif
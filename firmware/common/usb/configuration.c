@@ -1,5 +1,6 @@
 #include "usb/configuration.h"
 #include "usb/endpoint.h"
+#include "usb/remote_status.h"
 #include "remote.h"
 #include <string.h>
 #include <avr/pgmspace.h>
@@ -11,6 +12,7 @@ static const struct ep_config_t CONFIG0_EP_LIST[] PROGMEM = {
 static const struct ep_config_t CONFIG1_EP_LIST[] PROGMEM = {
     {0, EP_TYPE_CONTROL, EP_DIRECTION_BIDIR, 64, NULL}
   , {1, EP_TYPE_BULK, EP_DIRECTION_OUT, 64, ep1_init}
+  , {REMOTE_STATUS_ENDPOINT, EP_TYPE_INTERRUPT, EP_DIRECTION_IN, REMOTE_STATUS_ENDPOINT_SIZE, ep2_init}
 };
 
 #define CONFIG(config_list) {sizeof(config_list)/sizeof(config_list[0]), &config_list[0]}
@@ -6,9 +6,24 @@
 #include "usb/address.h"
 #include "usb/endpoint.h"
 #include "usb/configuration.h"
+#include "usb/remote_renderer.h"
 #include "frame_queue.h"
 #include "display_properties.h"
+#include "display_driver.h"
 #include "frame_timer.h"
+#include "telemetry.h"
+#if defined(DEVICE_HAS_COLOR_LUT) && DEVICE_HAS_COLOR_LUT
+#include "color_lut.h"
+#endif
+#if defined(DEVICE_HAS_TRACE) && DEVICE_HAS_TRACE
+#include "trace.h"
+#endif
+#if defined(DEVICE_HAS_COLOR_PALETTE) && DEVICE_HAS_COLOR_PALETTE
+#include "color_palette.h"
+#endif
+#if defined(DEVICE_HAS_EVENT_PLAYBACK) && DEVICE_HAS_EVENT_PLAYBACK
+#include "render/event_playback.h"
+#endif
 
 // Descriptor transaction definitions
 #include "usb/descriptor.h"
@@ -233,6 +248,8 @@ static void callback_set_address(struct control_transfer_t* transfer) {
 }
 
 static void callback_set_configuration(struct control_transfer_t* transfer) {
+  // Hosts that don't select an encoding expect raw frames
+  remote_renderer_set_frame_encoding(REMOTE_FRAME_ENCODING_RAW);
   set_configuration_index(transfer->req->wValue);
   if (transfer->req->wValue == 0) {
     set_device_state(DEFAULT);
@@ -245,6 +262,9 @@ static void callback_set_configuration(struct control_transfer_t* transfer) {
   }
 }
 
+// Finish the data stage once all data is received, for requests that write to a buffer
+static void callback_data_write(struct control_transfer_t* transfer);
+
 // Remote frame transfer
 static struct frame_buffer_t* usb_frame;
 static uint8_t* usb_frame_buffer;
@@ -259,12 +279,32 @@ extern uint8_t __eeprom_start[];
 static uint8_t* const __eeprom_start = (uint8_t*) 0x810000;
 #endif
 const uint16_t EEPROM_SIZE = E2END + 1;
-static void callback_data_eeprom_write(struct control_transfer_t* transfer);
 static void callback_handshake_eeprom_write(struct control_transfer_t* transfer);
 
 // Frame draw status/sync
 #define FRAME_DRAW_STATUS_SIZE (sizeof(struct display_frame_usb_phase_t))
 
+// Telemetry counters
+#define TELEMETRY_SIZE (TELEMETRY_COUNTER_COUNT*sizeof(uint16_t))
+#define TELEMETRY_CLEAR 1
+
+// Timing trace
+#define TRACE_CLEAR 1
+
+// Frame budget
+#define FRAME_BUDGET_SIZE (sizeof(struct frame_budget_t))
+#define FRAME_BUDGET_CLEAR 1
+
+#if defined(DEVICE_HAS_COLOR_LUT) && DEVICE_HAS_COLOR_LUT
+// Color correction tables
+static void callback_handshake_color_lut(struct control_transfer_t* transfer);
+#endif
+
+#if defined(DEVICE_HAS_EVENT_PLAYBACK) && DEVICE_HAS_EVENT_PLAYBACK
+// Event playback
+static void callback_handshake_event_playback(struct control_transfer_t* transfer);
+#endif
+
 static inline void process_vendor_request(struct control_transfer_t* transfer) {
   if (transfer->req->bmRequestType == (REQ_DIR_OUT | REQ_TYPE_VENDOR | REQ_REC_DEVICE)) {
     if (transfer->req->bRequest == VENDOR_REQUEST_PUSH_FRAME) {
@@ -293,7 +333,7 @@ static inline void process_vendor_request(struct control_transfer_t* transfer) {
       if (transfer->data) {
         transfer->data_length = transfer->req->wLength;
         transfer->data_done = 0;
-        transfer->callback_data = callback_data_eeprom_write;
+        transfer->callback_data = callback_data_write;
         transfer->callback_handshake = callback_handshake_eeprom_write;
         transfer->callback_cancel = callback_default_cancel;
         transfer->stage = CTRL_DATA_OUT;
@@ -317,6 +357,100 @@ static inline void process_vendor_request(struct control_transfer_t* transfer) {
         transfer->stage = CTRL_STALL;
       }
     }
+    else if (transfer->req->bRequest == VENDOR_REQUEST_FRAME_PRESENTATION_TIME
+          && transfer->req->wLength == 0)
+    {
+      remote_renderer_set_presentation_time(transfer->req->wValue);
+      transfer->stage = CTRL_HANDSHAKE_OUT;
+    }
+    else if (transfer->req->bRequest == VENDOR_REQUEST_REMOTE_FRAME_MODE
+          && transfer->req->wLength == 0)
+    {
+      if (remote_renderer_set_frame_mode((enum remote_frame_mode_t) transfer->req->wValue)) {
+        transfer->stage = CTRL_HANDSHAKE_OUT;
+      }
+    }
+    else if (transfer->req->bRequest == VENDOR_REQUEST_REMOTE_FRAME_ENCODING
+          && transfer->req->wLength == 0)
+    {
+      if (remote_renderer_set_frame_encoding(
+            (enum remote_frame_encoding_t) transfer->req->wValue)
+      ) {
+        transfer->stage = CTRL_HANDSHAKE_OUT;
+      }
+    }
+#if defined(DEVICE_HAS_COLOR_PALETTE) && DEVICE_HAS_COLOR_PALETTE
+    else if (transfer->req->bRequest == VENDOR_REQUEST_COLOR_PALETTE
+          && transfer->req->wLength > 0
+          && transfer->req->wIndex <= get_color_palette_size()
+          && transfer->req->wLength <= get_color_palette_size() - transfer->req->wIndex)
+    {
+      // Write the entries in place, they're only used for frames received afterwards
+      transfer->data = get_color_palette() + transfer->req->wIndex;
+      transfer->data_length = transfer->req->wLength;
+      transfer->data_done = 0;
+      transfer->callback_data = callback_data_write;
+      transfer->stage = CTRL_DATA_OUT;
+    }
+#endif
+#if defined(DEVICE_HAS_EVENT_PLAYBACK) && DEVICE_HAS_EVENT_PLAYBACK
+    else if (transfer->req->bRequest == VENDOR_REQUEST_EVENT_PULSES
+          && transfer->req->wLength > 0
+          && transfer->req->wLength % sizeof(struct event_pulse_t) == 0)
+    {
+      // Pulses are written in place, the playback is stopped until the host restarts it
+      struct event_pulse_t* pulses = get_event_pulse_upload(
+          transfer->req->wIndex
+        , transfer->req->wLength/sizeof(struct event_pulse_t)
+      );
+      if (pulses) {
+        transfer->data = pulses;
+        transfer->data_length = transfer->req->wLength;
+        transfer->data_done = 0;
+        transfer->callback_data = callback_data_write;
+        transfer->stage = CTRL_DATA_OUT;
+      }
+    }
+    else if (transfer->req->bRequest == VENDOR_REQUEST_EVENT_PLAYBACK) {
+      if (transfer->req->wLength == 0) {
+        stop_event_playback();
+        transfer->stage = CTRL_HANDSHAKE_OUT;
+      }
+      else if (transfer->req->wLength == sizeof(struct event_playback_t)) {
+        transfer->data = malloc(sizeof(struct event_playback_t));
+        if (transfer->data) {
+          transfer->data_length = sizeof(struct event_playback_t);
+          transfer->data_done = 0;
+          transfer->callback_data = callback_data_write;
+          transfer->callback_handshake = callback_handshake_event_playback;
+          transfer->callback_cancel = callback_default_cancel;
+          transfer->stage = CTRL_DATA_OUT;
+        }
+      }
+    }
+#endif
+#if defined(DEVICE_HAS_COLOR_LUT) && DEVICE_HAS_COLOR_LUT
+    else if (transfer->req->bRequest == VENDOR_REQUEST_COLOR_LUT
+          && transfer->req->wIndex <= COLOR_LUT_SIZE
+          && transfer->req->wLength <= COLOR_LUT_SIZE - transfer->req->wIndex)
+    {
+      if (transfer->req->wLength == 0) {
+        transfer->stage = CTRL_HANDSHAKE_OUT;
+        transfer->callback_handshake = callback_handshake_color_lut;
+      }
+      else {
+        transfer->data = malloc(transfer->req->wLength);
+        if (transfer->data) {
+          transfer->data_length = transfer->req->wLength;
+          transfer->data_done = 0;
+          transfer->callback_data = callback_data_write;
+          transfer->callback_handshake = callback_handshake_color_lut;
+          transfer->callback_cancel = callback_default_cancel;
+          transfer->stage = CTRL_DATA_OUT;
+        }
+      }
+    }
+#endif
   }
   else if (transfer->req->bmRequestType == (REQ_DIR_IN | REQ_TYPE_VENDOR | REQ_REC_DEVICE)) {
     if (transfer->req->bRequest == VENDOR_REQUEST_DISPLAY_PROPERTIES) {
@@ -379,6 +513,43 @@ static inline void process_vendor_request(struct control_transfer_t* transfer) {
         }
       }
     }
+    else if (transfer->req->bRequest == VENDOR_REQUEST_TELEMETRY) {
+      const uint16_t length = min(TELEMETRY_SIZE, transfer->req->wLength);
+      uint8_t* buffer = length ? init_data_in(transfer, length) : NULL;
+      if (buffer) {
+        uint16_t counters[TELEMETRY_COUNTER_COUNT];
+        read_telemetry(counters, transfer->req->wValue & TELEMETRY_CLEAR);
+        memcpy(buffer, counters, length);
+      }
+    }
+    else if (transfer->req->bRequest == VENDOR_REQUEST_FRAME_BUDGET) {
+      const uint16_t length = min(FRAME_BUDGET_SIZE, transfer->req->wLength);
+      uint8_t* buffer = length ? init_data_in(transfer, length) : NULL;
+      if (buffer) {
+        struct frame_budget_t budget;
+        read_frame_budget(&budget, transfer->req->wValue & FRAME_BUDGET_CLEAR);
+        memcpy(buffer, &budget, length);
+      }
+    }
+#if defined(DEVICE_HAS_COLOR_LUT) && DEVICE_HAS_COLOR_LUT
+    else if (transfer->req->bRequest == VENDOR_REQUEST_COLOR_LUT) {
+      if (transfer->req->wLength >= 1 && init_data_in(transfer, 1)) {
+        *((uint8_t*) transfer->data) = get_color_lut_flags();
+      }
+    }
+#endif
+#if defined(DEVICE_HAS_TRACE) && DEVICE_HAS_TRACE
+    else if (transfer->req->bRequest == VENDOR_REQUEST_TRACE) {
+      const uint16_t length = min(TRACE_READOUT_SIZE, transfer->req->wLength);
+      uint8_t* buffer = length >= sizeof(struct trace_header_t)
+        ? init_data_in(transfer, length)
+        : NULL;
+      if (buffer) {
+        // Only send the records that were actually copied
+        transfer->data_length = read_trace(buffer, length, transfer->req->wValue & TRACE_CLEAR);
+      }
+    }
+#endif
   }
 }
 
@@ -409,7 +580,7 @@ static void callback_cancel_usb_frame() {
   }
 }
 
-static void callback_data_eeprom_write(struct control_transfer_t *transfer) {
+static void callback_data_write(struct control_transfer_t *transfer) {
   if (transfer->data_done == transfer->data_length) {
     transfer->stage = CTRL_HANDSHAKE_OUT;
   }
@@ -421,8 +592,35 @@ static void callback_handshake_eeprom_write(struct control_transfer_t *transfer)
     eeprom_update_block(transfer->data, dest, transfer->data_length);
     free(transfer->data);
     transfer->data = 0;
+    reload_display_configuration();
+  }
+}
+
+#if defined(DEVICE_HAS_COLOR_LUT) && DEVICE_HAS_COLOR_LUT
+static void callback_handshake_color_lut(struct control_transfer_t *transfer) {
+  write_color_lut(
+      transfer->req->wIndex
+    , transfer->data
+    , transfer->data_length
+    , (uint8_t) transfer->req->wValue
+  );
+  if (transfer->data) {
+    free(transfer->data);
+    transfer->data = 0;
   }
+  reload_display_configuration();
 }
+#endif
+
+#if defined(DEVICE_HAS_EVENT_PLAYBACK) && DEVICE_HAS_EVENT_PLAYBACK
+static void callback_handshake_event_playback(struct control_transfer_t *transfer) {
+  if (transfer->data) {
+    start_event_playback(transfer->data);
+    free(transfer->data);
+    transfer->data = 0;
+  }
+}
+#endif
 
 void process_setup(struct control_transfer_t* transfer) {
   switch (GET_REQUEST_TYPE(transfer->req->bmRequestType)) {
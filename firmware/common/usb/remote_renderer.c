@@ -3,22 +3,64 @@
 
 #include "frame_buffer.h"
 #include "frame_queue.h"
+#include "telemetry.h"
+#if defined(DEVICE_HAS_COLOR_PALETTE) && DEVICE_HAS_COLOR_PALETTE
+#include "color_palette.h"
+#endif
 
 #include <stddef.h>
+#include <string.h>
 
 static struct frame_buffer_t* frame = NULL;
 static struct frame_transfer_state_t state;
 
+// Presentation time of the next completed frame
+static bool presentation_time_valid = false;
+static uint16_t presentation_time;
+
+// Kept when the endpoint is reinitialised, only changed on request of the host
+static volatile enum remote_frame_mode_t frame_mode = REMOTE_FRAME_MODE_QUEUE;
+// Applied to the transfer state when the endpoint is reinitialised
+static volatile enum remote_frame_encoding_t frame_encoding = REMOTE_FRAME_ENCODING_RAW;
+
+// Header bit of literal runs, and the run length mask
+#define ZERO_RUN_LITERAL 0x80
+#define ZERO_RUN_LENGTH 0x7f
+// Literal bytes of the current run that haven't been received yet
+static uint8_t literal_remaining;
+
+// Frame types of REMOTE_FRAME_ENCODING_DELTA
+#define DELTA_FRAME_FULL 0
+#define DELTA_FRAME_CHANGES 1
+// The frame type byte hasn't been received yet
+static bool frame_type_pending;
+// The frame buffer holds a copy of the previous frame
+static bool previous_copied;
+// Runs without data keep the previous frame's values, instead of clearing them
+static bool keep_skipped;
+
 static void inline clear_frame_state() {
+  state.frame = NULL;
   state.write_pos = NULL;
   state.buffer_end = NULL;
 }
 
-static void init_frame_state() {
+// Start a new frame, which may be based on the previously received frame
+static void init_frame_state(const struct frame_buffer_t* previous) {
+  literal_remaining = 0;
+  frame_type_pending = state.encoding == REMOTE_FRAME_ENCODING_DELTA;
+  previous_copied = false;
+  keep_skipped = false;
   if (frame) {
     frame->flags = FRAME_FREE_AFTER_DRAW;
+    state.frame = frame;
     state.write_pos = frame->buffer;
     state.buffer_end = frame->buffer + get_frame_buffer_size();
+    // The previous frame may be released once it's drawn, so copy it before that can happen
+    if (frame_type_pending && previous) {
+      memcpy(frame->buffer, previous->buffer, get_frame_buffer_size());
+      previous_copied = true;
+    }
   }
   else {
     clear_frame_state();
@@ -26,16 +68,21 @@ static void init_frame_state() {
 }
 
 void remote_renderer_init() {
+  presentation_time_valid = false;
+  state.encoding = frame_encoding;
+
   // If a frame is already allocated, just reset the internal state
   if (!frame) {
     frame = create_frame();
   }
 
-  init_frame_state();
+  init_frame_state(NULL);
 }
 
 void remote_renderer_halt() {
+  telemetry_count(TELEMETRY_REMOTE_HALTED);
   endpoint_stall(1);
+  presentation_time_valid = false;
   if (frame) {
     destroy_frame(frame);
     frame = NULL;
@@ -44,6 +91,7 @@ void remote_renderer_halt() {
 }
 
 void remote_renderer_stop() {
+  presentation_time_valid = false;
   if (frame) {
     destroy_frame(frame);
     frame = NULL;
@@ -56,11 +104,127 @@ struct frame_transfer_state_t* remote_renderer_get_transfer_state() {
 }
 
 void remote_renderer_transfer_done() {
-  if (push_frame(frame)) {
+  if (presentation_time_valid) {
+    frame->flags |= FRAME_PRESENTATION_TIME;
+    frame->display_frame_counter = presentation_time;
+    presentation_time_valid = false;
+  }
+
+  const struct frame_buffer_t* previous = frame;
+  bool submitted;
+  if (frame_mode == REMOTE_FRAME_MODE_LATEST) {
+    submitted = push_latest_frame(frame);
+  }
+  else {
+    submitted = push_frame(frame);
+  }
+
+  if (submitted) {
     frame = create_frame();
-    init_frame_state();
+    init_frame_state(previous);
   }
   else {
     remote_renderer_halt();
   }
 }
+
+void remote_renderer_set_presentation_time(uint16_t display_frame_counter) {
+  presentation_time = display_frame_counter;
+  presentation_time_valid = true;
+}
+
+bool remote_renderer_set_frame_mode(enum remote_frame_mode_t mode) {
+  if (mode == REMOTE_FRAME_MODE_QUEUE || mode == REMOTE_FRAME_MODE_LATEST) {
+    frame_mode = mode;
+    return true;
+  }
+  return false;
+}
+
+bool remote_renderer_set_frame_encoding(enum remote_frame_encoding_t encoding) {
+  if (encoding < 8*sizeof(uint8_t) && (REMOTE_FRAME_ENCODINGS & (1 << encoding))) {
+#if defined(DEVICE_HAS_COLOR_PALETTE) && DEVICE_HAS_COLOR_PALETTE
+    if (encoding == REMOTE_FRAME_ENCODING_INDEXED && !get_color_palette()) {
+      return false;
+    }
+#endif
+    frame_encoding = encoding;
+    return true;
+  }
+  return false;
+}
+
+#if defined(DEVICE_HAS_COLOR_PALETTE) && DEVICE_HAS_COLOR_PALETTE
+static bool expand_indices(const uint8_t* data, uint16_t length) {
+  const uint8_t* palette = get_color_palette();
+  const uint8_t led_size = get_led_size();
+  uint8_t* pos = state.write_pos;
+
+  if (length > (state.buffer_end - pos)/led_size) {
+    return false;
+  }
+  for (const uint8_t* data_end = data + length; data != data_end; ++data) {
+    memcpy(pos, palette + (*data)*led_size, led_size);
+    pos += led_size;
+  }
+
+  state.write_pos = pos;
+  return true;
+}
+#endif
+
+bool remote_renderer_decode(const uint8_t* data, uint16_t length) {
+#if defined(DEVICE_HAS_COLOR_PALETTE) && DEVICE_HAS_COLOR_PALETTE
+  if (state.encoding == REMOTE_FRAME_ENCODING_INDEXED) {
+    return expand_indices(data, length);
+  }
+#endif
+
+  uint8_t* pos = state.write_pos;
+  const uint8_t* const data_end = data + length;
+
+  while (data != data_end) {
+    if (frame_type_pending) {
+      const uint8_t type = *data++;
+      frame_type_pending = false;
+      if (type == DELTA_FRAME_CHANGES && previous_copied) {
+        keep_skipped = true;
+      }
+      else if (type != DELTA_FRAME_FULL) {
+        state.write_pos = pos;
+        return false;
+      }
+    }
+    else if (literal_remaining) {
+      uint16_t count = data_end - data;
+      if (count > literal_remaining) {
+        count = literal_remaining;
+      }
+      memcpy(pos, data, count);
+      pos += count;
+      data += count;
+      literal_remaining -= count;
+    }
+    else {
+      const uint8_t header = *data++;
+      const uint8_t count = (header & ZERO_RUN_LENGTH) + 1;
+      // Runs may not extend past the end of the frame
+      if (count > state.buffer_end - pos) {
+        state.write_pos = pos;
+        return false;
+      }
+      if (header & ZERO_RUN_LITERAL) {
+        literal_remaining = count;
+      }
+      else {
+        if (!keep_skipped) {
+          memset(pos, 0, count);
+        }
+        pos += count;
+      }
+    }
+  }
+
+  state.write_pos = pos;
+  return true;
+}
@@ -0,0 +1,39 @@
+#include "usb/remote_status.h"
+#include "usb/endpoint.h"
+#include "usb/remote_renderer.h"
+
+#include "frame_queue.h"
+#include "frame_timer.h"
+
+// Display frame counter of the last report
+static uint16_t reported_frame_counter;
+static bool report_requested = true;
+
+void remote_status_init() {
+  report_requested = true;
+}
+
+bool remote_status_poll(struct remote_status_t* status) {
+  struct display_frame_usb_phase_t phase;
+  if (!get_display_frame_usb_phase(&phase)) {
+    return false;
+  }
+  if (!report_requested && phase.display_frame_counter == reported_frame_counter) {
+    return false;
+  }
+  report_requested = false;
+  reported_frame_counter = phase.display_frame_counter;
+
+  status->queue_free = frame_queue_free_slots();
+  status->flags = 0;
+  if (remote_renderer_get_transfer_state()->write_pos) {
+    status->flags |= REMOTE_STATUS_READY;
+  }
+  if (endpoint_is_stalled(1)) {
+    status->flags |= REMOTE_STATUS_HALTED;
+  }
+  status->display_frame_counter = phase.display_frame_counter;
+  status->usb_frame_counter = phase.usb_frame_counter;
+  read_telemetry(status->telemetry, false);
+  return true;
+}
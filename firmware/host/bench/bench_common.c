@@ -0,0 +1,244 @@
+/* Microbenchmarks for the platform independent firmware code in firmware/common.
+ * Most of the measured functions are called from ISR context on the microcontrollers, so their
+ * run time directly adds to the interrupt latency of the display.
+ * Absolute numbers are only meaningful relative to other runs on the same host.
+ */
+#include "host/bench.h"
+#include "host/frame_timer_mock.h"
+
+#include "display_properties.h"
+#include "frame_buffer.h"
+#include "frame_queue.h"
+#include "frame_timer.h"
+#include "remote.h"
+#include "usb/std.h"
+#include "usb/descriptor.h"
+#include "usb/endpoint_0.h"
+
+#include <util/atomic.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#define DEFAULT_ITERATIONS 1000000
+#define RUNS 5
+
+// Number of timer counts per ms, for the Teensy's PIT running at F_BUS
+#define COUNTS_PER_MS (48000000/1000)
+
+static uint32_t iterations = DEFAULT_ITERATIONS;
+
+typedef void (*bench_function_t)(uint32_t iterations);
+
+// Run a benchmark RUNS times and report the fastest run, as this is the least disturbed one.
+static void run_bench(const char* name, bench_function_t bench) {
+  uint64_t best_ns = UINT64_MAX;
+  uint64_t best_cycles = UINT64_MAX;
+  for (unsigned run = 0; run < RUNS; ++run) {
+    const uint64_t start_ns = bench_time_ns();
+    const uint64_t start_cycles = bench_cycles();
+    bench(iterations);
+    const uint64_t cycles = bench_cycles() - start_cycles;
+    const uint64_t ns = bench_time_ns() - start_ns;
+    if (ns < best_ns) {
+      best_ns = ns;
+      best_cycles = cycles;
+    }
+  }
+  printf(
+        "%-40s %10u %10.2f %10.1f\n"
+      , name
+      , iterations
+      , (double) best_ns/iterations
+      , (double) best_cycles/iterations
+  );
+}
+
+
+/* FRAME BUFFERS */
+static void bench_create_destroy(uint32_t n) {
+  while (n--) {
+    struct frame_buffer_t* f = create_frame();
+    BENCH_KEEP(f);
+    destroy_frame(f);
+  }
+}
+
+// Allocate from an almost exhausted pool: create_frame() has to scan past the taken buffers.
+static void bench_create_destroy_last(uint32_t n) {
+  struct frame_buffer_t* f0 = create_frame();
+  struct frame_buffer_t* f1 = create_frame();
+  while (n--) {
+    struct frame_buffer_t* f = create_frame();
+    BENCH_KEEP(f);
+    destroy_frame(f);
+  }
+  destroy_frame(f1);
+  destroy_frame(f0);
+}
+
+static void bench_create_failure(uint32_t n) {
+  struct frame_buffer_t* frames[3];
+  for (unsigned i = 0; i < 3; ++i) {
+    frames[i] = create_frame();
+  }
+  while (n--) {
+    struct frame_buffer_t* f = create_frame();
+    BENCH_KEEP(f);
+  }
+  for (unsigned i = 0; i < 3; ++i) {
+    destroy_frame(frames[i]);
+  }
+}
+
+
+/* FRAME QUEUE */
+static void bench_push_pop(uint32_t n) {
+  struct frame_buffer_t* f = create_frame();
+  while (n--) {
+    push_frame(f);
+    BENCH_KEEP(pop_frame());
+  }
+  destroy_frame(f);
+}
+
+static void bench_pop_empty(uint32_t n) {
+  while (n--) {
+    BENCH_KEEP(pop_frame());
+  }
+}
+
+static void bench_push_full(uint32_t n) {
+  struct frame_buffer_t* f = create_frame();
+  while (push_frame(f)) {}
+  while (n--) {
+    BENCH_KEEP(push_frame(f));
+  }
+  while (pop_frame()) {}
+  destroy_frame(f);
+}
+
+
+/* FRAME TIMER */
+static uint16_t usb_frame_counter;
+
+static void bench_timer_baseline(uint32_t n) {
+  while (n--) {
+    frame_timer_mock_advance(COUNTS_PER_MS);
+  }
+}
+
+static void bench_new_sof_received(uint32_t n) {
+  while (n--) {
+    frame_timer_mock_advance(COUNTS_PER_MS);
+    usb_frame_counter = (usb_frame_counter + 1) & 0x7FF;
+    new_sof_received(usb_frame_counter);
+  }
+}
+
+
+/* CONTROL ENDPOINT */
+static void run_setup(const struct usb_setup_packet_t* setup, uint32_t n) {
+  struct control_transfer_t transfer;
+  while (n--) {
+    init_control_transfer(&transfer, setup);
+    process_setup(&transfer);
+    BENCH_KEEP(transfer.stage);
+    // Release any data buffer that was allocated for the reply
+    cancel_control_transfer(&transfer);
+  }
+}
+
+static void bench_setup_descriptor_device(uint32_t n) {
+  const struct usb_setup_packet_t setup = {
+      .bmRequestType = REQ_DIR_IN | REQ_TYPE_STANDARD | REQ_REC_DEVICE
+    , .bRequest = GET_DESCRIPTOR
+    , .wValue = DESC_TYPE_DEVICE << 8
+    , .wIndex = 0
+    , .wLength = 18
+  };
+  run_setup(&setup, n);
+}
+
+static void bench_setup_descriptor_config(uint32_t n) {
+  const struct usb_setup_packet_t setup = {
+      .bmRequestType = REQ_DIR_IN | REQ_TYPE_STANDARD | REQ_REC_DEVICE
+    , .bRequest = GET_DESCRIPTOR
+    , .wValue = DESC_TYPE_CONFIGURATION << 8
+    , .wIndex = 0
+    , .wLength = 255
+  };
+  run_setup(&setup, n);
+}
+
+static void bench_setup_display_properties(uint32_t n) {
+  const struct usb_setup_packet_t setup = {
+      .bmRequestType = REQ_DIR_IN | REQ_TYPE_VENDOR | REQ_REC_DEVICE
+    , .bRequest = VENDOR_REQUEST_DISPLAY_PROPERTIES
+    , .wValue = 0
+    , .wIndex = 0
+    , .wLength = 256
+  };
+  run_setup(&setup, n);
+}
+
+static void bench_setup_frame_draw_status(uint32_t n) {
+  const struct usb_setup_packet_t setup = {
+      .bmRequestType = REQ_DIR_IN | REQ_TYPE_VENDOR | REQ_REC_DEVICE
+    , .bRequest = VENDOR_REQUEST_FRAME_DRAW_STATUS
+    , .wValue = 0
+    , .wIndex = 0
+    , .wLength = sizeof(struct display_frame_usb_phase_t)
+  };
+  run_setup(&setup, n);
+}
+
+static void bench_setup_frame_draw_sync(uint32_t n) {
+  const struct usb_setup_packet_t setup = {
+      .bmRequestType = REQ_DIR_OUT | REQ_TYPE_VENDOR | REQ_REC_DEVICE
+    , .bRequest = VENDOR_REQUEST_FRAME_DRAW_SYNC
+    , .wValue = 0
+    , .wIndex = 0
+    , .wLength = 0
+  };
+  run_setup(&setup, n);
+}
+
+
+int main(int argc, char** argv) {
+  if (argc > 1) {
+    iterations = strtoul(argv[1], NULL, 0);
+    if (iterations == 0) {
+      fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+      return 1;
+    }
+  }
+
+  // Same initialisation order as the firmware's main()
+  init_display_properties();
+  init_frame_buffers();
+  init_remote();
+  frame_timer_mock_configure(-1, 40*COUNTS_PER_MS - 1);
+  init_frame_timer();
+
+  printf("Frame buffer size: %zu bytes\n", get_frame_buffer_size());
+  printf("%-40s %10s %10s %10s\n", "benchmark", "iterations", "ns/op", "cycles/op");
+
+  run_bench("create_frame+destroy_frame", bench_create_destroy);
+  run_bench("create_frame+destroy_frame (last free)", bench_create_destroy_last);
+  run_bench("create_frame (pool exhausted)", bench_create_failure);
+  run_bench("push_frame+pop_frame", bench_push_pop);
+  run_bench("pop_frame (queue empty)", bench_pop_empty);
+  run_bench("push_frame (queue full)", bench_push_full);
+  run_bench("frame timer advance (baseline)", bench_timer_baseline);
+  run_bench("new_sof_received+frame timer advance", bench_new_sof_received);
+  run_bench("process_setup GET_DESCRIPTOR device", bench_setup_descriptor_device);
+  run_bench("process_setup GET_DESCRIPTOR config", bench_setup_descriptor_config);
+  run_bench("process_setup DISPLAY_PROPERTIES", bench_setup_display_properties);
+  run_bench("process_setup FRAME_DRAW_STATUS", bench_setup_frame_draw_status);
+  run_bench("process_setup FRAME_DRAW_SYNC", bench_setup_frame_draw_sync);
+
+  printf("Emulated interrupt masks: %u\n", host_interrupts_disable_count());
+
+  return 0;
+}
@@ -0,0 +1,895 @@
+/* Golden output check and benchmark of the Teensy's frame buffer to port data conversion.
+ * encode_frame() is verified bit-exactly against a straightforward reference implementation,
+ * for all color orders, both strip orientations, and a number of port maps.
+ * encode_frame_changes() is verified by updating the port data of one frame to a next frame.
+ * encode_stream_update() is verified by converting frames in USB packet sized increments.
+ * Alternating conversion into two port data buffers is verified with a sequence of frames.
+ * Conversion with color correction tables is verified for full frames and streams.
+ * Dithering of 16 bit frames is verified per refresh, and by the average over a full period.
+ * Built with PORT_BANK_COUNT=2, the same checks are performed for port maps of up to 16 ports.
+ * Run with `--check` to only perform the verification, e.g. from ctest.
+ */
+#include "host/bench.h"
+
+#include "port_encoder.h"
+#include "color_lut.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdalign.h>
+
+#define DEFAULT_ITERATIONS 2000
+#define RUNS 5
+
+// Largest string index used by any of the port maps, plus one
+#define SOURCE_STRING_COUNT 32
+#define SOURCE_SIZE (SOURCE_STRING_COUNT*STRING_LENGTH*sizeof(struct led_t))
+#define SOURCE_SIZE_16 (SOURCE_STRING_COUNT*STRING_SIZE_16)
+
+// Number of refreshes after which the dithered LED values add up to the 16 bit frame values
+#define DITHER_PERIOD 256
+
+// Output buffer fill value, to detect bytes that are (not) written
+#define OUTPUT_FILL 0xA5
+
+// Frame data received per USB packet by the Teensy
+#define PACKET_SIZE 64
+
+static uint32_t iterations = DEFAULT_ITERATIONS;
+
+/* PORT MAPS */
+// Strings per port, in the order they are connected, as in the configurations/*.json files
+struct port_layout_t {
+  const char* name;
+  uint8_t port_count;
+  uint8_t strings[MAX_PORT_COUNT][SEGMENT_COUNT];
+};
+
+// String number 0 indicates an unconnected segment
+#if PORT_BANK_COUNT > 1
+static const struct port_layout_t LAYOUTS[] = {
+    {"ugent front", 15, {
+        {8, 2}, {1, 7}, {16, 24}, {25, 17}, {15, 23}, {22, 14}, {9, 3}, {4, 10}
+      , {12, 6}, {5, 11}, {20, 28}, {29, 30}, {19, 27}, {26, 18}, {13, 21}
+    }}
+  , {"all ports", 16, {
+        {1, 2}, {3, 4}, {5, 6}, {7, 8}, {9, 10}, {11, 12}, {13, 14}, {15, 16}
+      , {17, 18}, {19, 20}, {21, 22}, {23, 24}, {25, 26}, {27, 28}, {29, 30}, {31, 32}
+    }}
+  , {"single port", 1, {
+        {1, 2}
+    }}
+  , {"uneven ports", 12, {
+        {1, 2}, {3, 4}, {5, 6}, {7, 8}, {9, 10}, {11, 12}, {13, 14}, {15, 16}
+      , {17, 18}, {19}, {20}, {21}
+    }}
+  , {"first bank", 5, {
+        {1, 2}, {3, 4}, {5}, {6}, {7}
+    }}
+};
+#else
+static const struct port_layout_t LAYOUTS[] = {
+    {"ugent front", 8, {
+        {8, 2, 1, 7}, {16, 24, 25, 17}, {15, 23, 22, 14}, {9, 3, 4, 10}
+      , {12, 6, 5, 11}, {20, 28, 29, 30}, {19, 27, 26, 18}, {13, 21}
+    }}
+  , {"ugent center", 5, {
+        {34, 33, 32, 31}, {35, 45, 46, 36}, {44, 43, 42, 41}, {37, 38, 39, 40}, {47, 48, 49, 50}
+    }}
+  , {"ugent back", 7, {
+        {61, 52, 51, 60}, {70, 71, 78, 77}, {69, 68, 75, 76}, {62, 53, 54, 63}
+      , {64, 55, 56, 65}, {66, 74, 73, 72}, {67, 59, 58, 57}
+    }}
+  , {"single port", 1, {
+        {1, 2, 3, 4}
+    }}
+  , {"uneven ports", 6, {
+        {1, 2, 3, 4}, {5, 6, 7}, {8, 9}, {10, 11}, {12}, {13}
+    }}
+};
+#endif
+#define LAYOUT_COUNT (sizeof(LAYOUTS)/sizeof(LAYOUTS[0]))
+
+static int compare_strings(const void* a, const void* b) {
+  return *((const uint8_t*) a) - *((const uint8_t*) b);
+}
+
+/* Convert a port layout to an EEPROM port map, as done by update_eeprom.py: strings are stored
+ * in the frame buffer in order of increasing string number.
+ */
+static void build_port_map(const struct port_layout_t* layout, struct port_map_t* map) {
+  uint8_t sorted[MAX_PORT_COUNT*SEGMENT_COUNT];
+  unsigned int string_count = 0;
+  for (unsigned int port = 0; port < layout->port_count; ++port) {
+    for (unsigned int segment = 0; segment < SEGMENT_COUNT; ++segment) {
+      if (layout->strings[port][segment]) {
+        sorted[string_count++] = layout->strings[port][segment];
+      }
+    }
+  }
+  qsort(sorted, string_count, sizeof(sorted[0]), compare_strings);
+
+  memset(map, 0, SEGMENT_COUNT*sizeof(*map));
+  for (unsigned int segment = 0; segment < SEGMENT_COUNT; ++segment) {
+    uint8_t port_count = layout->port_count;
+    while (port_count > 0 && layout->strings[port_count-1][segment] == 0) {
+      --port_count;
+    }
+    map[segment].ports_length = port_count;
+    for (unsigned int port = 0; port < port_count; ++port) {
+      const uint8_t* offset = bsearch(
+          &layout->strings[port][segment], sorted, string_count, sizeof(sorted[0])
+        , compare_strings
+      );
+      map[segment].ports[port] = offset - sorted;
+    }
+  }
+}
+
+
+/* REFERENCE IMPLEMENTATION */
+static const char* const ORDER_NAMES[] = {"RGB", "BRG", "GBR", "BGR", "RBG", "GRB"};
+#define ORDER_COUNT (sizeof(ORDER_NAMES)/sizeof(ORDER_NAMES[0]))
+
+// Byte offsets in struct led_t of the colors, in output order
+static void color_offsets(enum display_led_color_order_t order, unsigned int* offsets) {
+  const char* name = ORDER_NAMES[order];
+  for (unsigned int i = 0; i < sizeof(struct led_t); ++i) {
+    switch (name[i]) {
+      case 'R':
+        offsets[i] = offsetof(struct led_t, red);
+        break;
+      case 'G':
+        offsets[i] = offsetof(struct led_t, green);
+        break;
+      case 'B':
+        offsets[i] = offsetof(struct led_t, blue);
+        break;
+    }
+  }
+}
+
+/* Color correction tables passed to init_port_encoder(), or NULL.
+ * The tables are applied by the reference implementation as well.
+ */
+static const uint8_t* encoder_lut;
+
+/* Output byte `bit` of every group of 8 bytes is written to the GPIO port during the `bit`-th
+ * WS2811 bit period, so it contains bit `7-bit` (MSB first) of each port's color byte on GPIO pin
+ * `port`. Unused ports are kept low. The output of the ports of every next port bank follows that
+ * of the previous bank, and is not written for the segments that don't use the bank.
+ */
+static void reference_encode_frame(
+    const uint8_t* src
+  , uint8_t* dest
+  , enum display_led_color_order_t order
+  , bool reverse_first
+  , const struct port_map_t* map
+) {
+  unsigned int offsets[sizeof(struct led_t)];
+  color_offsets(order, offsets);
+  // With struct led_t in RGB order, the color offsets are also the table channels
+  const uint8_t* luts[sizeof(struct led_t)];
+  for (unsigned int color = 0; color < sizeof(struct led_t); ++color) {
+    luts[color] = encoder_lut ? encoder_lut + COLOR_LUT_LENGTH*offsets[color] : NULL;
+  }
+
+  for (unsigned int segment = 0; segment < SEGMENT_COUNT; ++segment) {
+    const uint8_t port_count = map[segment].ports_length;
+    if (port_count == 0 || port_count > MAX_PORT_COUNT) {
+      break;
+    }
+    const bool is_reversed = reverse_first == (segment % 2 == 0);
+
+    for (unsigned int bank = 0; PORT_BANK_SIZE*bank < port_count; ++bank) {
+      uint8_t* bank_dest = dest + PORT_BANK_DATA_SIZE*bank + 8*STRING_SIZE*segment;
+      const unsigned int first_port = PORT_BANK_SIZE*bank;
+      const unsigned int end_port = port_count < first_port + PORT_BANK_SIZE
+        ? port_count
+        : first_port + PORT_BANK_SIZE;
+
+      for (unsigned int led = 0; led < STRING_LENGTH; ++led) {
+        const unsigned int dom = is_reversed ? STRING_LENGTH-1 - led : led;
+        for (unsigned int color = 0; color < sizeof(struct led_t); ++color) {
+          for (unsigned int bit = 0; bit < 8; ++bit) {
+            uint8_t value = 0;
+            for (unsigned int port = first_port; port < end_port; ++port) {
+              const size_t led_index = map[segment].ports[port]*STRING_LENGTH + dom;
+              uint8_t byte = src[led_index*sizeof(struct led_t) + offsets[color]];
+              if (luts[color]) {
+                byte = luts[color][byte];
+              }
+              value |= ((byte >> (7-bit)) & 1) << (port - first_port);
+            }
+            *bank_dest++ = value;
+          }
+        }
+      }
+    }
+  }
+}
+
+
+// Color byte of `port` at LED position `led` of a strip in the port data
+static uint8_t decode_port_value(
+    const uint8_t* port_data
+  , size_t led
+  , unsigned int color
+  , unsigned int port
+) {
+  const uint8_t* bits = port_data + 8*(sizeof(struct led_t)*led + color);
+  uint8_t value = 0;
+  for (unsigned int bit = 0; bit < 8; ++bit) {
+    value |= ((bits[bit] >> port) & 1) << (7-bit);
+  }
+  return value;
+}
+
+
+/* SYNTHETIC FRAMES */
+static uint32_t random_state = 0x1CEC0BE;
+
+static uint32_t xorshift32() {
+  random_state ^= random_state << 13;
+  random_state ^= random_state >> 17;
+  random_state ^= random_state << 5;
+  return random_state;
+}
+
+static void fill_random(uint8_t* frame) {
+  for (size_t i = 0; i < SOURCE_SIZE; ++i) {
+    frame[i] = xorshift32();
+  }
+}
+
+// A typical event: most DOMs off, a few bright ones
+static void fill_sparse(uint8_t* frame) {
+  memset(frame, 0, SOURCE_SIZE);
+  for (unsigned int i = 0; i < 64; ++i) {
+    frame[xorshift32() % SOURCE_SIZE] = xorshift32();
+  }
+}
+
+// Every LED gets a unique, recognisable value
+static void fill_indexed(uint8_t* frame) {
+  for (size_t i = 0; i < SOURCE_SIZE; ++i) {
+    frame[i] = (i/sizeof(struct led_t)) ^ (i % sizeof(struct led_t) << 6);
+  }
+}
+
+static void fill_ones(uint8_t* frame) {
+  memset(frame, 0xFF, SOURCE_SIZE);
+}
+
+// Random 16 bit colors, many of them dim, and some in the saturated top range
+static void fill_random_16(uint8_t* frame) {
+  for (size_t i = 0; i < SOURCE_SIZE_16; i += sizeof(uint16_t)) {
+    uint16_t value = xorshift32();
+    const uint32_t kind = xorshift32() % 8;
+    if (kind < 4) {
+      value >>= 6;
+    }
+    else if (kind == 4) {
+      value |= 0xFF00;
+    }
+    frame[i] = value & 0xFF;
+    frame[i+1] = value >> 8;
+  }
+}
+
+// Different tables per channel, which don't map zero to zero
+static void fill_test_lut(uint8_t* lut) {
+  for (unsigned int channel = 0; channel < COLOR_LUT_CHANNEL_COUNT; ++channel) {
+    for (unsigned int value = 0; value < COLOR_LUT_LENGTH; ++value) {
+      lut[channel*COLOR_LUT_LENGTH + value] = ((value*value) >> 8) ^ (0x11*(channel+1));
+    }
+  }
+}
+
+typedef void (*fill_function_t)(uint8_t* frame);
+
+static const struct {
+  const char* name;
+  fill_function_t fill;
+} PATTERNS[] = {
+    {"random", fill_random}
+  , {"sparse", fill_sparse}
+  , {"indexed", fill_indexed}
+  , {"ones", fill_ones}
+};
+#define PATTERN_COUNT (sizeof(PATTERNS)/sizeof(PATTERNS[0]))
+
+
+// A typical IceCube event: a few strings with a number of consecutive DOMs lit
+static void fill_event(uint8_t* frame) {
+  memset(frame, 0, SOURCE_SIZE);
+  for (unsigned int i = 0; i < 4; ++i) {
+    const unsigned int string = xorshift32() % SOURCE_STRING_COUNT;
+    const unsigned int first_dom = xorshift32() % (STRING_LENGTH-12);
+    for (unsigned int dom = first_dom; dom < first_dom+12; ++dom) {
+      uint8_t* led = frame + string*STRING_SIZE + dom*sizeof(struct led_t);
+      led[0] = xorshift32();
+      led[1] = xorshift32();
+      led[2] = xorshift32();
+    }
+  }
+}
+
+// A different event: change a few LEDs
+static void change_sparse(uint8_t* frame) {
+  for (unsigned int i = 0; i < 16; ++i) {
+    const size_t offset = xorshift32() % SOURCE_SIZE;
+    frame[offset] = ~frame[offset];
+  }
+}
+
+
+/* VERIFICATION */
+static uint8_t source[SOURCE_SIZE];
+static uint8_t output[LED_DATA_SIZE];
+static uint8_t back_output[LED_DATA_SIZE];
+static uint8_t* const outputs[] = {output, back_output};
+static uint8_t expected[LED_DATA_SIZE];
+static uint8_t encoded_source[ENCODED_SOURCE_SIZE];
+static uint8_t source_16[SOURCE_SIZE_16];
+static alignas(4) uint8_t dither_state[DITHER_STATE_SIZE];
+static uint8_t previous_source[SOURCE_SIZE];
+static uint8_t blended_source[SOURCE_SIZE];
+static alignas(4) uint8_t interpolation_state[INTERPOLATION_STATE_SIZE];
+
+static bool compare_output(
+    const uint8_t* actual
+  , const char* layout_name
+  , const char* pattern_name
+  , enum display_led_color_order_t order
+  , bool reverse_first
+) {
+  for (size_t i = 0; i < LED_DATA_SIZE; ++i) {
+    if (actual[i] != expected[i]) {
+      fprintf(
+            stderr
+          , "MISMATCH %s, %s, %s, reverse_first=%d: byte %zu is 0x%02x, expected 0x%02x\n"
+          , layout_name, pattern_name, ORDER_NAMES[order], reverse_first, i, actual[i], expected[i]
+      );
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool check_frame(
+    const char* layout_name
+  , const char* pattern_name
+  , enum display_led_color_order_t order
+  , bool reverse_first
+  , const struct port_map_t* map
+) {
+  memset(output, OUTPUT_FILL, sizeof(output));
+  memset(expected, OUTPUT_FILL, sizeof(expected));
+
+  init_port_encoder(order, encoder_lut, reverse_first, map, encoded_source, outputs, 1);
+  encode_frame(source, 0);
+  reference_encode_frame(source, expected, order, reverse_first, map);
+
+  return compare_output(output, layout_name, pattern_name, order, reverse_first);
+}
+
+/* Convert a sequence of frames with encode_frame_changes(): the first frame without previous
+ * data, then frames with sparse changes and with all LEDs changed, and finally the same frame.
+ */
+static bool check_frame_changes(
+    const char* layout_name
+  , enum display_led_color_order_t order
+  , bool reverse_first
+  , const struct port_map_t* map
+) {
+  memset(output, OUTPUT_FILL, sizeof(output));
+  memset(expected, OUTPUT_FILL, sizeof(expected));
+  init_port_encoder(order, encoder_lut, reverse_first, map, encoded_source, outputs, 1);
+
+  fill_random(source);
+  encode_frame_changes(source, 0);
+  reference_encode_frame(source, expected, order, reverse_first, map);
+  if (!compare_output(output, layout_name, "changes: initial", order, reverse_first)) {
+    return false;
+  }
+
+  change_sparse(source);
+  encode_frame_changes(source, 0);
+  reference_encode_frame(source, expected, order, reverse_first, map);
+  if (!compare_output(output, layout_name, "changes: sparse", order, reverse_first)) {
+    return false;
+  }
+
+  fill_random(source);
+  encode_frame_changes(source, 0);
+  reference_encode_frame(source, expected, order, reverse_first, map);
+  if (!compare_output(output, layout_name, "changes: all", order, reverse_first)) {
+    return false;
+  }
+
+  encode_frame_changes(source, 0);
+  return compare_output(output, layout_name, "changes: none", order, reverse_first);
+}
+
+// Convert `src` with encode_stream_update(), as if it were received up to `length` bytes
+static bool stream_frame(const uint8_t* src, size_t length) {
+  bool done = false;
+  for (size_t received = 0; received < length;) {
+    received = received + PACKET_SIZE < length ? received + PACKET_SIZE : length;
+    done = encode_stream_update(src, received);
+  }
+  return done;
+}
+
+/* Convert a sequence of frames while they are received: the first frame without previous data,
+ * then a frame with sparse changes, and finally a stream that is abandoned halfway, after which
+ * a different frame is converted with encode_frame_changes().
+ */
+static bool check_frame_stream(
+    const char* layout_name
+  , enum display_led_color_order_t order
+  , bool reverse_first
+  , const struct port_map_t* map
+) {
+  static uint8_t abandoned[SOURCE_SIZE];
+
+  memset(output, OUTPUT_FILL, sizeof(output));
+  memset(expected, OUTPUT_FILL, sizeof(expected));
+  init_port_encoder(order, encoder_lut, reverse_first, map, encoded_source, outputs, 1);
+
+  fill_random(source);
+  encode_stream_start(0);
+  const bool initial_done = stream_frame(source, SOURCE_SIZE);
+  reference_encode_frame(source, expected, order, reverse_first, map);
+  if (!initial_done || !compare_output(output, layout_name, "stream: initial", order, reverse_first)) {
+    return false;
+  }
+
+  change_sparse(source);
+  encode_stream_start(0);
+  const bool changed_done = stream_frame(source, SOURCE_SIZE);
+  reference_encode_frame(source, expected, order, reverse_first, map);
+  if (!changed_done || !compare_output(output, layout_name, "stream: changed", order, reverse_first)) {
+    return false;
+  }
+
+  memcpy(abandoned, source, SOURCE_SIZE);
+  change_sparse(abandoned);
+  fill_random(abandoned + SOURCE_SIZE/2);
+  encode_stream_start(0);
+  stream_frame(abandoned, SOURCE_SIZE/2);
+  change_sparse(source);
+  encode_frame_changes(source, 0);
+  reference_encode_frame(source, expected, order, reverse_first, map);
+  return compare_output(output, layout_name, "stream: abandoned", order, reverse_first);
+}
+
+/* Convert a sequence of frames alternately into two port data buffers, as done by the display
+ * driver: with encode_frame_changes(), while streaming, and after an abandoned stream.
+ * Every buffer must hold the complete frame that was last converted into it.
+ */
+static bool check_double_buffer(
+    const char* layout_name
+  , enum display_led_color_order_t order
+  , bool reverse_first
+  , const struct port_map_t* map
+) {
+  static uint8_t abandoned[SOURCE_SIZE];
+
+  memset(output, OUTPUT_FILL, sizeof(output));
+  memset(back_output, OUTPUT_FILL, sizeof(back_output));
+  init_port_encoder(order, encoder_lut, reverse_first, map, encoded_source, outputs, 2);
+
+  fill_random(source);
+  for (unsigned int frame = 0; frame < 8; ++frame) {
+    const unsigned int buffer = frame % 2;
+    const char* step;
+    if (frame == 5) {
+      memcpy(abandoned, source, SOURCE_SIZE);
+      change_sparse(abandoned);
+      encode_stream_start(buffer);
+      stream_frame(abandoned, SOURCE_SIZE/2);
+    }
+    change_sparse(source);
+    if (frame % 3 == 2) {
+      encode_stream_start(buffer);
+      if (!stream_frame(source, SOURCE_SIZE)) {
+        fprintf(stderr, "Stream of frame %u did not complete\n", frame);
+        return false;
+      }
+      step = "double buffer: stream";
+    }
+    else {
+      encode_frame_changes(source, buffer);
+      step = "double buffer: changes";
+    }
+    reference_encode_frame(source, expected, order, reverse_first, map);
+    if (!compare_output(outputs[buffer], layout_name, step, order, reverse_first)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Refresh the loaded 16 bit frame for a full dithering period. Every refresh must show the 8 most
+ * significant bits of every color, or one more, and the values must add up to the 16 bit color
+ * over the period, independent of the errors accumulated before. Unused ports are kept low.
+ */
+static bool check_dither_period(
+    const char* layout_name
+  , const char* step
+  , enum display_led_color_order_t order
+  , bool reverse_first
+  , const struct port_map_t* map
+) {
+  static uint32_t sums[SEGMENT_COUNT*STRING_LENGTH][sizeof(struct led_t)][MAX_PORT_COUNT];
+  memset(sums, 0, sizeof(sums));
+  unsigned int offsets[sizeof(struct led_t)];
+  color_offsets(order, offsets);
+
+  for (unsigned int refresh = 0; refresh <= DITHER_PERIOD; ++refresh) {
+    if (refresh < DITHER_PERIOD) {
+      encode_dither_refresh(0);
+    }
+    for (unsigned int segment = 0; segment < SEGMENT_COUNT; ++segment) {
+      const uint8_t port_count = map[segment].ports_length;
+      if (port_count == 0 || port_count > MAX_PORT_COUNT) {
+        break;
+      }
+      const bool is_reversed = reverse_first == (segment % 2 == 0);
+
+      for (unsigned int led = 0; led < STRING_LENGTH; ++led) {
+        const size_t position = segment*STRING_LENGTH + led;
+        const unsigned int dom = is_reversed ? STRING_LENGTH-1 - led : led;
+        for (unsigned int color = 0; color < sizeof(struct led_t); ++color) {
+          for (unsigned int port = 0; port < MAX_PORT_COUNT; ++port) {
+            // Banks without used ports are not written
+            const unsigned int bank = port/PORT_BANK_SIZE;
+            if (PORT_BANK_SIZE*bank >= port_count) {
+              break;
+            }
+            uint16_t color_16 = 0;
+            if (port < port_count) {
+              const size_t led_index = map[segment].ports[port]*STRING_LENGTH + dom;
+              const uint8_t* value = source_16
+                + led_index*sizeof(struct led16_t) + sizeof(uint16_t)*offsets[color];
+              color_16 = value[0] | (value[1] << 8);
+            }
+            const uint8_t low = color_16 >> 8;
+            const uint8_t high = low < 0xFF ? low + 1 : low;
+
+            if (refresh < DITHER_PERIOD) {
+              const uint8_t actual = decode_port_value(
+                  output + PORT_BANK_DATA_SIZE*bank, position, color, port % PORT_BANK_SIZE
+              );
+              sums[position][color][port] += actual;
+              if (actual == low || actual == high) {
+                continue;
+              }
+              fprintf(
+                    stderr
+                  , "MISMATCH %s, %s, %s, reverse_first=%d: refresh %u, position %zu, "
+                    "color %u, port %u is 0x%02x, expected 0x%02x or 0x%02x\n"
+                  , layout_name, step, ORDER_NAMES[order], reverse_first
+                  , refresh, position, color, port, actual, low, high
+              );
+              return false;
+            }
+
+            const uint32_t expected_sum = low < 0xFF ? color_16 : DITHER_PERIOD*low;
+            if (sums[position][color][port] != expected_sum) {
+              fprintf(
+                    stderr
+                  , "MISMATCH %s, %s, %s, reverse_first=%d: position %zu, color %u, port %u "
+                    "adds up to %u over a period, expected %u\n"
+                  , layout_name, step, ORDER_NAMES[order], reverse_first
+                  , position, color, port, sums[position][color][port], expected_sum
+              );
+              return false;
+            }
+          }
+        }
+      }
+    }
+  }
+  return true;
+}
+
+/* Dither a 16 bit frame, and then a different frame that is loaded partway through a period, so
+ * the accumulated errors of the first frame are carried over.
+ */
+static bool check_dither(
+    const char* layout_name
+  , enum display_led_color_order_t order
+  , bool reverse_first
+  , const struct port_map_t* map
+) {
+  memset(output, OUTPUT_FILL, sizeof(output));
+  init_port_encoder(order, NULL, reverse_first, map, NULL, outputs, 1);
+  init_port_dither(dither_state);
+
+  fill_random_16(source_16);
+  load_dither_frame(source_16);
+  if (!check_dither_period(layout_name, "dither: initial", order, reverse_first, map)) {
+    return false;
+  }
+
+  for (unsigned int refresh = 0; refresh < DITHER_PERIOD/3; ++refresh) {
+    encode_dither_refresh(0);
+  }
+  fill_random_16(source_16);
+  load_dither_frame(source_16);
+  return check_dither_period(layout_name, "dither: next frame", order, reverse_first, map);
+}
+
+/* Interpolate between two random frames, and compare every weight with the reference conversion
+ * of the blended frame.
+ */
+static bool check_interpolation(
+    const char* layout_name
+  , enum display_led_color_order_t order
+  , bool reverse_first
+  , const struct port_map_t* map
+) {
+  static const unsigned int WEIGHTS[] = {0, 1, 64, 127, 128, 255, 256, 1000};
+
+  init_port_encoder(order, encoder_lut, reverse_first, map, NULL, outputs, 1);
+  init_port_interpolation(interpolation_state);
+  fill_random(previous_source);
+  load_interpolated_frame(previous_source);
+  fill_random(source);
+  load_interpolated_frame(source);
+
+  for (unsigned int i = 0; i < sizeof(WEIGHTS)/sizeof(WEIGHTS[0]); ++i) {
+    const unsigned int weight = WEIGHTS[i] < 256 ? WEIGHTS[i] : 256;
+    for (size_t byte = 0; byte < SOURCE_SIZE; ++byte) {
+      blended_source[byte] = (previous_source[byte]*(256-weight) + source[byte]*weight + 128) >> 8;
+    }
+
+    memset(output, OUTPUT_FILL, sizeof(output));
+    memset(expected, OUTPUT_FILL, sizeof(expected));
+    encode_interpolated_refresh(WEIGHTS[i], 0);
+    reference_encode_frame(blended_source, expected, order, reverse_first, map);
+
+    char name[32];
+    snprintf(name, sizeof(name), "interpolation %u", WEIGHTS[i]);
+    if (!compare_output(output, layout_name, name, order, reverse_first)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static unsigned int check_all() {
+  struct port_map_t map[SEGMENT_COUNT];
+  unsigned int failures = 0;
+  unsigned int checks = 0;
+
+  for (unsigned int layout = 0; layout < LAYOUT_COUNT; ++layout) {
+    build_port_map(&LAYOUTS[layout], map);
+    for (unsigned int pattern = 0; pattern < PATTERN_COUNT; ++pattern) {
+      PATTERNS[pattern].fill(source);
+      for (unsigned int order = 0; order < ORDER_COUNT; ++order) {
+        for (unsigned int reverse = 0; reverse < 2; ++reverse) {
+          checks++;
+          if (!check_frame(LAYOUTS[layout].name, PATTERNS[pattern].name, order, reverse, map)) {
+            failures++;
+          }
+        }
+      }
+    }
+    for (unsigned int order = 0; order < ORDER_COUNT; ++order) {
+      for (unsigned int reverse = 0; reverse < 2; ++reverse) {
+        checks++;
+        if (!check_frame_changes(LAYOUTS[layout].name, order, reverse, map)) {
+          failures++;
+        }
+        checks++;
+        if (!check_frame_stream(LAYOUTS[layout].name, order, reverse, map)) {
+          failures++;
+        }
+        checks++;
+        if (!check_double_buffer(LAYOUTS[layout].name, order, reverse, map)) {
+          failures++;
+        }
+      }
+    }
+  }
+
+  // Color correction
+  static uint8_t lut[COLOR_LUT_SIZE];
+  fill_test_lut(lut);
+  encoder_lut = lut;
+  for (unsigned int layout = 0; layout < LAYOUT_COUNT; ++layout) {
+    char name[64];
+    snprintf(name, sizeof(name), "%s, color lut", LAYOUTS[layout].name);
+    build_port_map(&LAYOUTS[layout], map);
+    for (unsigned int order = 0; order < ORDER_COUNT; ++order) {
+      for (unsigned int reverse = 0; reverse < 2; ++reverse) {
+        fill_random(source);
+        checks++;
+        if (!check_frame(name, "random", order, reverse, map)) {
+          failures++;
+        }
+        checks++;
+        if (!check_frame_stream(name, order, reverse, map)) {
+          failures++;
+        }
+        checks++;
+        if (!check_interpolation(name, order, reverse, map)) {
+          failures++;
+        }
+      }
+    }
+  }
+  encoder_lut = NULL;
+
+  // Temporal dithering
+  for (unsigned int layout = 0; layout < LAYOUT_COUNT; ++layout) {
+    build_port_map(&LAYOUTS[layout], map);
+    for (unsigned int order = 0; order < ORDER_COUNT; ++order) {
+      checks++;
+      if (!check_dither(LAYOUTS[layout].name, order, order % 2, map)) {
+        failures++;
+      }
+      checks++;
+      if (!check_interpolation(LAYOUTS[layout].name, order, order % 2, map)) {
+        failures++;
+      }
+    }
+  }
+
+  // Invalid port counts are treated as unused segments, ending the conversion
+  build_port_map(&LAYOUTS[0], map);
+  map[SEGMENT_COUNT-1].ports_length = MAX_PORT_COUNT + 1;
+  fill_random(source);
+  checks++;
+  if (!check_frame("invalid last segment", "random", LED_ORDER_GRB, true, map)) {
+    failures++;
+  }
+
+  printf("Golden output checks: %u/%u passed\n", checks - failures, checks);
+  return failures;
+}
+
+
+/* BENCHMARK */
+enum bench_mode_t {
+    BENCH_FULL ///< encode_frame() of a random frame
+  , BENCH_EVENTS ///< encode_frame_changes() alternating between two events
+  , BENCH_UNCHANGED ///< encode_frame_changes() of the same frame
+  , BENCH_STREAM ///< encode_stream_update() per packet, alternating between two events
+  , BENCH_FULL_LUT ///< encode_frame() of a random frame, with color correction
+  , BENCH_DITHER ///< encode_dither_refresh() of a random 16 bit frame
+  , BENCH_INTERPOLATE ///< encode_interpolated_refresh() of two random frames, with color correction
+};
+static const char* const MODE_NAMES[] = {
+  "full", "events", "same", "stream", "lut", "dither", "interp"
+};
+
+static uint8_t event_frames[2][SOURCE_SIZE];
+
+static void run_bench(
+    const char* name
+  , enum display_led_color_order_t order
+  , bool reverse
+  , enum bench_mode_t mode
+) {
+  uint64_t best_ns = UINT64_MAX;
+  uint64_t best_cycles = UINT64_MAX;
+  for (unsigned int run = 0; run < RUNS; ++run) {
+    const uint64_t start_ns = bench_time_ns();
+    const uint64_t start_cycles = bench_cycles();
+    for (uint32_t i = 0; i < iterations; ++i) {
+      switch (mode) {
+        case BENCH_FULL:
+        case BENCH_FULL_LUT:
+          encode_frame(source, 0);
+          break;
+        case BENCH_EVENTS:
+          encode_frame_changes(event_frames[i % 2], 0);
+          break;
+        case BENCH_UNCHANGED:
+          encode_frame_changes(source, 0);
+          break;
+        case BENCH_STREAM:
+          encode_stream_start(0);
+          stream_frame(event_frames[i % 2], SOURCE_SIZE);
+          break;
+        case BENCH_DITHER:
+          encode_dither_refresh(0);
+          break;
+        case BENCH_INTERPOLATE:
+          encode_interpolated_refresh(i % INTERPOLATION_WEIGHT_MAX, 0);
+          break;
+      }
+      BENCH_KEEP(output);
+    }
+    const uint64_t cycles = bench_cycles() - start_cycles;
+    const uint64_t ns = bench_time_ns() - start_ns;
+    if (ns < best_ns) {
+      best_ns = ns;
+      best_cycles = cycles;
+    }
+  }
+  printf(
+        "%-16s %-4s %7d %-6s %10u %12.1f %12.1f\n"
+      , name
+      , ORDER_NAMES[order]
+      , reverse
+      , MODE_NAMES[mode]
+      , iterations
+      , (double) best_ns/iterations
+      , (double) best_cycles/iterations
+  );
+}
+
+static void bench_all() {
+  struct port_map_t map[SEGMENT_COUNT];
+  static uint8_t lut[COLOR_LUT_SIZE];
+  fill_test_lut(lut);
+
+  printf(
+        "%-16s %-4s %7s %-6s %10s %12s %12s\n"
+      , "port map", "order", "reverse", "mode", "frames", "ns/frame", "cycles/frame"
+  );
+  fill_random(source);
+  fill_random_16(source_16);
+  fill_event(event_frames[0]);
+  fill_event(event_frames[1]);
+  for (unsigned int layout = 0; layout < LAYOUT_COUNT; ++layout) {
+    build_port_map(&LAYOUTS[layout], map);
+    for (unsigned int order = 0; order < ORDER_COUNT; ++order) {
+      for (unsigned int reverse = 0; reverse < 2; ++reverse) {
+        init_port_encoder(order, encoder_lut, reverse, map, encoded_source, outputs, 1);
+        run_bench(LAYOUTS[layout].name, order, reverse, BENCH_FULL);
+      }
+    }
+    // Change tracking does not depend on the color order or orientation
+    init_port_encoder(LED_ORDER_GRB, encoder_lut, true, map, encoded_source, outputs, 1);
+    run_bench(LAYOUTS[layout].name, LED_ORDER_GRB, true, BENCH_EVENTS);
+    encode_frame(source, 0);
+    run_bench(LAYOUTS[layout].name, LED_ORDER_GRB, true, BENCH_UNCHANGED);
+    run_bench(LAYOUTS[layout].name, LED_ORDER_GRB, true, BENCH_STREAM);
+    init_port_encoder(LED_ORDER_GRB, lut, true, map, encoded_source, outputs, 1);
+    run_bench(LAYOUTS[layout].name, LED_ORDER_GRB, true, BENCH_FULL_LUT);
+    init_port_encoder(LED_ORDER_GRB, NULL, true, map, NULL, outputs, 1);
+    init_port_dither(dither_state);
+    load_dither_frame(source_16);
+    run_bench(LAYOUTS[layout].name, LED_ORDER_GRB, true, BENCH_DITHER);
+    init_port_encoder(LED_ORDER_GRB, lut, true, map, NULL, outputs, 1);
+    init_port_interpolation(interpolation_state);
+    load_interpolated_frame(event_frames[0]);
+    load_interpolated_frame(source);
+    run_bench(LAYOUTS[layout].name, LED_ORDER_GRB, true, BENCH_INTERPOLATE);
+  }
+}
+
+
+int main(int argc, char** argv) {
+  bool check_only = false;
+  for (int arg = 1; arg < argc; ++arg) {
+    if (strcmp(argv[arg], "--check") == 0) {
+      check_only = true;
+    }
+    else {
+      iterations = strtoul(argv[arg], NULL, 0);
+      if (iterations == 0) {
+        fprintf(stderr, "usage: %s [--check] [iterations]\n", argv[0]);
+        return 1;
+      }
+    }
+  }
+
+  if (check_all() > 0) {
+    return 1;
+  }
+
+  if (!check_only) {
+    bench_all();
+  }
+
+  return 0;
+}
@@ -0,0 +1,30 @@
+#ifndef HOST_AVR_EEPROM_H
+#define HOST_AVR_EEPROM_H
+
+/** \file
+  * \brief Host implementation of the avr-libc EEPROM access functions.
+  * \details The EEPROM is emulated by a RAM array starting at `__eeprom_start`, sized like the
+  *   Teensy 3.2's 2kB EEPROM. Variables placed in the EEPROM sections (e.g. `.displayprop`) are
+  *   regular host variables, so all reads are plain memory reads.
+  * \author Sander Vanheule (Universiteit Gent)
+  */
+
+#include <stdint.h>
+
+#define E2END 0x7FF
+
+/// Start of the emulated EEPROM memory.
+extern uint8_t __eeprom_start[];
+
+uint8_t eeprom_read_byte(const uint8_t* addr);
+uint16_t eeprom_read_word(const uint16_t* addr);
+uint32_t eeprom_read_dword(const uint32_t* addr);
+void eeprom_read_block(void* buf, const void* addr, uint32_t len);
+
+void eeprom_write_byte(uint8_t* addr, uint8_t value);
+void eeprom_write_block(const void* buf, void* addr, uint32_t len);
+
+#define eeprom_update_byte eeprom_write_byte
+#define eeprom_update_block eeprom_write_block
+
+#endif // HOST_AVR_EEPROM_H
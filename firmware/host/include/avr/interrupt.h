@@ -0,0 +1,13 @@
+#ifndef HOST_AVR_INTERRUPT_H
+#define HOST_AVR_INTERRUPT_H
+
+/** \file
+  * \brief Host implementation of the avr-libc interrupt handler definitions.
+  * \details An interrupt handler becomes a regular function named after its vector, which a test
+  *   calls to emulate the interrupt.
+  * \author Sander Vanheule (Universiteit Gent)
+  */
+
+#define ISR(vector) void vector(void)
+
+#endif // HOST_AVR_INTERRUPT_H
@@ -0,0 +1,34 @@
+#ifndef HOST_AVR_IO_H
+#define HOST_AVR_IO_H
+
+/** \file
+  * \brief Host emulation of the ATmega32u4 Timer1 registers.
+  * \details Only the registers used by the IceTop frame timer backend are provided. They are
+  *   plain variables, so a test takes the role of the timer hardware by writing to them.
+  * \author Sander Vanheule (Universiteit Gent)
+  */
+
+#include <stdint.h>
+
+#define _BV(bit) (1 << (bit))
+
+// TCCR1A
+#define WGM10 0
+#define WGM11 1
+// TCCR1B
+#define CS10 0
+#define WGM12 3
+#define WGM13 4
+// TIMSK1
+#define OCIE1A 1
+// TIFR1
+#define OCF1A 1
+
+extern volatile uint8_t TCCR1A;
+extern volatile uint8_t TCCR1B;
+extern volatile uint8_t TIMSK1;
+extern volatile uint8_t TIFR1;
+extern volatile uint16_t TCNT1;
+extern volatile uint16_t OCR1A;
+
+#endif // HOST_AVR_IO_H
@@ -0,0 +1,24 @@
+#ifndef HOST_AVR_PGMSPACE_H
+#define HOST_AVR_PGMSPACE_H
+
+/** \file
+  * \brief Host implementation of the avr-libc program memory access functions.
+  * \details Like on the ARM microcontrollers, program memory is just part of the flat address
+  *   space, so all accessors reduce to plain memory reads.
+  * \author Sander Vanheule (Universiteit Gent)
+  */
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+
+#define pgm_read_byte(addr) (*(const uint8_t*) (addr))
+#define pgm_read_word(addr) (*(const uint16_t*) (addr))
+#define pgm_read_dword(addr) (*(const uint32_t*) (addr))
+#define pgm_read_ptr(addr) (*(const void* const*) (addr))
+
+#define memcpy_P memcpy
+#define strlen_P strlen
+
+#endif // HOST_AVR_PGMSPACE_H
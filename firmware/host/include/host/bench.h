@@ -0,0 +1,35 @@
+#ifndef HOST_BENCH_H
+#define HOST_BENCH_H
+
+/** \file
+  * \brief Timing helpers for the host benchmarks.
+  * \author Sander Vanheule (Universiteit Gent)
+  */
+
+#include <stdint.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/// Monotonic time stamp in nanoseconds.
+static inline uint64_t bench_time_ns() {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t) t.tv_sec*1000000000ULL + t.tv_nsec;
+}
+
+/// CPU time stamp counter value, or 0 if not supported on the host.
+static inline uint64_t bench_cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+/// Prevent the compiler from optimising away \a value.
+#define BENCH_KEEP(value) __asm__ volatile("" : : "g"(value) : "memory")
+
+#endif // HOST_BENCH_H
@@ -0,0 +1,31 @@
+#ifndef HOST_CHECK_H
+#define HOST_CHECK_H
+
+/** \file
+  * \brief Assertion helpers for the host tests.
+  * \author Sander Vanheule (Universiteit Gent)
+  */
+
+#include <stdio.h>
+
+/// Number of failed checks of the test.
+static unsigned int errors;
+
+/// Count a failed check, and print the formatted message for the first ten failures.
+#define CHECK(condition, ...) \
+  do { \
+    if (!(condition)) { \
+      if (errors++ < 10) { \
+        fprintf(stderr, __VA_ARGS__); \
+        fputc('\n', stderr); \
+      } \
+    } \
+  } while (0)
+
+/// Print the test result, and return the exit status of the test.
+static inline int check_report() {
+  printf("%s: %u errors\n", errors ? "FAIL" : "PASS", errors);
+  return errors ? 1 : 0;
+}
+
+#endif // HOST_CHECK_H
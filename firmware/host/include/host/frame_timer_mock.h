@@ -0,0 +1,48 @@
+#ifndef HOST_FRAME_TIMER_MOCK_H
+#define HOST_FRAME_TIMER_MOCK_H
+
+/** \file
+  * \brief Simulated frame timer backend.
+  * \details The host build replaces the hardware timer (PIT on the Teensy, Timer1 on the ATmega)
+  *   by a counter that is advanced explicitly by the caller.
+  *   Like the hardware, corrections made with correct_counts_max() only take effect after the
+  *   next counter roll-over, at which point the timer callback is also called.
+  * \author Sander Vanheule (Universiteit Gent)
+  */
+
+#include "frame_timer_backend.h"
+
+/** \brief Configure the simulated counter.
+  * \details Should be called before init_frame_timer().
+  * \param direction 1 for an up-counter (ATmega Timer1), -1 for a down-counter (Teensy PIT).
+  * \param counts_max Initial roll-over value. A timer period consists of `counts_max+1` counts.
+  */
+void frame_timer_mock_configure(int8_t direction, timer_count_t counts_max);
+
+/// Advance the counter by \a counts clock ticks, calling the timer callback on every roll-over.
+void frame_timer_mock_advance(uint32_t counts);
+
+/// Number of counts remaining until the next roll-over.
+uint32_t frame_timer_mock_counts_to_rollover();
+
+/// Roll-over value currently in use, i.e. not including pending corrections.
+timer_count_t frame_timer_mock_active_counts_max();
+
+/// Total number of counts the timer has been advanced since frame_timer_mock_configure().
+uint64_t frame_timer_mock_total_counts();
+
+/** \brief Mask the timer interrupt, e.g. to emulate an atomic block.
+  * \details A roll-over while the interrupt is masked leaves it pending, and the timer callback
+  *   is only called when the interrupt is unmasked again. Like on the hardware, further
+  *   roll-overs while the interrupt is pending are lost.
+  */
+void frame_timer_mock_mask_interrupt(bool masked);
+
+/** \brief Observe timer roll-overs.
+  * \details \a hook is called after the timer callback, with the total number of counts at
+  *   which the roll-over occurred, and the length of the timer period that just ended.
+  *   Pass `NULL` to remove the hook.
+  */
+void frame_timer_mock_set_rollover_hook(void (*hook)(uint64_t total_counts, uint32_t period));
+
+#endif // HOST_FRAME_TIMER_MOCK_H
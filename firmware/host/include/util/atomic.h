@@ -0,0 +1,36 @@
+#ifndef HOST_UTIL_ATOMIC_H
+#define HOST_UTIL_ATOMIC_H
+
+/** \file
+  * \brief Host implementation of the avr-libc `ATOMIC_BLOCK` macros.
+  * \details On the microcontrollers, an atomic block disables all interrupts for its duration.
+  *   The host build emulates this with a single, global, recursive spin lock. Code running in
+  *   another thread (standing in for an ISR) that enters an atomic block will therefore wait
+  *   until the current atomic block is left, mimicking the masked interrupt.
+  * \author Sander Vanheule (Universiteit Gent)
+  */
+
+#include <stdint.h>
+
+/// Emulate disabling interrupts. Returns the previous nesting depth.
+uint8_t host_interrupts_disable();
+
+/// Emulate restoring the interrupt state to the provided nesting depth.
+void host_interrupts_restore(const uint8_t* depth);
+
+/// Number of times the emulated interrupt mask was acquired since start-up.
+uint32_t host_interrupts_disable_count();
+
+static inline uint8_t __iCliRetVal() {
+  return 1;
+}
+
+#define ATOMIC_RESTORESTATE \
+  uint8_t __host_irq_depth __attribute__((__cleanup__(host_interrupts_restore))) = \
+      host_interrupts_disable()
+
+#define ATOMIC_FORCEON ATOMIC_RESTORESTATE
+
+#define ATOMIC_BLOCK(type) for (type, __ToDo = __iCliRetVal(); __ToDo; __ToDo = 0)
+
+#endif // HOST_UTIL_ATOMIC_H
@@ -0,0 +1,470 @@
+/* Closed-loop simulation of the SOF-slaved frame timer in firmware/common/frame_timer.c.
+ * The simulated device clock runs with a configurable offset from the USB host's 1kHz SOF clock.
+ * SOF tokens arrive with jittered interrupt latency, and can be dropped. The frame timer's
+ * roll-overs are recorded in host time, to determine how quickly the timer locks on to the
+ * nominal frame period, and how much phase error remains afterwards.
+ *
+ * The timer frequency, direction and resolution are fixed at compile time, to match either the
+ * Teensy's PIT or the ATmega's Timer1.
+ */
+#include "host/frame_timer_mock.h"
+
+#include "frame_timer.h"
+
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef SIM_TIMER_FREQUENCY
+#error SIM_TIMER_FREQUENCY not defined
+#endif
+#ifndef SIM_COUNTER_DIRECTION
+#error SIM_COUNTER_DIRECTION not defined
+#endif
+
+// Nominal frame period in host time
+#define FRAME_PERIOD_S (MS_PER_FRAME*1e-3)
+#define SOF_PERIOD_S 1e-3
+
+#define HISTOGRAM_WIDTH 50
+
+struct sim_config_t {
+  double duration_s;
+  double crystal_ppm;
+  double jitter_us;
+  double drop_probability;
+  unsigned int drop_burst;
+  double lock_threshold_us;
+  unsigned int lock_window;
+  unsigned int histogram_bins;
+  unsigned long seed;
+  const char* trace_path;
+  // Regression limits, negative if unused
+  double max_lock_s;
+  double max_phase_us;
+};
+
+static struct sim_config_t config = {
+    .duration_s = 60
+  , .crystal_ppm = 0
+  , .jitter_us = 0
+  , .drop_probability = 0
+  , .drop_burst = 1
+  , .lock_threshold_us = -1
+  , .lock_window = DEVICE_FPS/5
+  , .histogram_bins = 21
+  , .seed = 1
+  , .trace_path = NULL
+  , .max_lock_s = -1
+  , .max_phase_us = -1
+};
+
+static double device_frequency;
+
+
+/* RANDOM NUMBERS */
+static uint64_t random_state;
+
+static double random_uniform() {
+  // xorshift64*
+  random_state ^= random_state >> 12;
+  random_state ^= random_state << 25;
+  random_state ^= random_state >> 27;
+  return ((random_state * 0x2545F4914F6CDD1DULL) >> 11) * (1.0/(1ULL << 53));
+}
+
+static double random_gauss() {
+  // Box-Muller
+  double u;
+  do {
+    u = random_uniform();
+  } while (u == 0);
+  return sqrt(-2*log(u)) * cos(2*M_PI*random_uniform());
+}
+
+
+/* ROLL-OVER RECORDING */
+struct frame_record_t {
+  double time_s;
+  uint32_t period_counts;
+  timer_count_t counts_max;
+};
+
+static struct frame_record_t* frames;
+static size_t frame_count;
+static size_t frame_capacity;
+
+static void record_rollover(uint64_t total_counts, uint32_t period) {
+  if (frame_count == frame_capacity) {
+    frame_capacity = frame_capacity ? 2*frame_capacity : 1024;
+    frames = realloc(frames, frame_capacity*sizeof(*frames));
+    if (!frames) {
+      perror("realloc");
+      exit(2);
+    }
+  }
+  frames[frame_count].time_s = total_counts/device_frequency;
+  frames[frame_count].period_counts = period;
+  frames[frame_count].counts_max = get_counts_max();
+  frame_count++;
+}
+
+
+/* SIMULATION */
+static void simulate() {
+  const uint64_t sof_count = config.duration_s/SOF_PERIOD_S;
+  const double sof_offset_s = random_uniform()*SOF_PERIOD_S;
+  uint16_t usb_frame_counter = random_uniform()*(1<<11);
+  unsigned int drops_remaining = 0;
+  double previous_latch_s = 0;
+
+  for (uint64_t sof = 0; sof < sof_count; ++sof) {
+    usb_frame_counter = (usb_frame_counter + 1) & 0x7FF;
+
+    if (drops_remaining == 0 && random_uniform() < config.drop_probability) {
+      drops_remaining = config.drop_burst;
+    }
+    if (drops_remaining > 0) {
+      drops_remaining--;
+      continue;
+    }
+
+    // Time at which the SOF interrupt latches the counter, kept monotonic
+    double latch_s = sof_offset_s + sof*SOF_PERIOD_S + config.jitter_us*1e-6*random_gauss();
+    if (latch_s < previous_latch_s) {
+      latch_s = previous_latch_s;
+    }
+    previous_latch_s = latch_s;
+
+    const uint64_t latch_counts = latch_s*device_frequency;
+    const uint64_t total_counts = frame_timer_mock_total_counts();
+    if (latch_counts > total_counts) {
+      frame_timer_mock_advance(latch_counts - total_counts);
+    }
+    new_sof_received(usb_frame_counter);
+  }
+}
+
+
+/* ANALYSIS */
+struct statistics_t {
+  size_t count;
+  double mean;
+  double rms;
+  double min;
+  double max;
+};
+
+static struct statistics_t get_statistics(const double* values, size_t count) {
+  struct statistics_t stats = {.count = count, .min = INFINITY, .max = -INFINITY};
+  for (size_t i = 0; i < count; ++i) {
+    stats.mean += values[i];
+    stats.rms += values[i]*values[i];
+    stats.min = fmin(stats.min, values[i]);
+    stats.max = fmax(stats.max, values[i]);
+  }
+  if (count) {
+    stats.mean /= count;
+    stats.rms = sqrt(stats.rms/count);
+  }
+  return stats;
+}
+
+static void print_statistics(const char* name, const struct statistics_t* stats) {
+  printf(
+        "%-28s mean %10.3f  rms %10.3f  min %10.3f  max %10.3f\n"
+      , name, stats->mean, stats->rms, stats->min, stats->max
+  );
+}
+
+static void print_histogram(const char* name, const double* values, size_t count) {
+  const struct statistics_t stats = get_statistics(values, count);
+  const unsigned int bins = config.histogram_bins;
+  // Keep the bins centered around zero error, with a minimal width to avoid a single huge bin
+  double range = fmax(fmax(fabs(stats.min), fabs(stats.max)), 1e-3);
+  const double width = 2*range/bins;
+
+  size_t* histogram = calloc(bins, sizeof(*histogram));
+  size_t peak = 0;
+  for (size_t i = 0; i < count; ++i) {
+    int bin = floor((values[i] + range)/width);
+    if (bin < 0) {
+      bin = 0;
+    }
+    else if (bin >= (int) bins) {
+      bin = bins - 1;
+    }
+    histogram[bin]++;
+    if (histogram[bin] > peak) {
+      peak = histogram[bin];
+    }
+  }
+
+  printf("\n%s (µs)\n", name);
+  for (unsigned int bin = 0; bin < bins; ++bin) {
+    const unsigned int bar = peak ? (histogram[bin]*HISTOGRAM_WIDTH + peak - 1)/peak : 0;
+    printf("  [%9.3f, %9.3f) %8zu ", -range + bin*width, -range + (bin+1)*width, histogram[bin]);
+    for (unsigned int i = 0; i < bar; ++i) {
+      putchar('#');
+    }
+    putchar('\n');
+  }
+  free(histogram);
+}
+
+// Return true if the simulation met the regression limits
+static bool analyse() {
+  if (frame_count < 2) {
+    printf("Too few frames recorded\n");
+    return false;
+  }
+
+  // Period and phase errors for every frame, starting from the second roll-over
+  const size_t error_count = frame_count - 1;
+  double* period_error = malloc(error_count*sizeof(double));
+  double* phase_error = malloc(error_count*sizeof(double));
+
+  for (size_t i = 0; i < error_count; ++i) {
+    period_error[i] = (frames[i+1].time_s - frames[i].time_s - FRAME_PERIOD_S)*1e6;
+  }
+
+  /* Locked after the last window with a mean period error exceeding the threshold.
+   * Individual periods can't be used, as the controller also tracks the SOF jitter.
+   */
+  const size_t window = config.lock_window;
+  size_t lock_index = 0;
+  bool locked = false;
+  if (frame_count > window) {
+    for (size_t i = 0; i + window < frame_count; ++i) {
+      const double window_s = frames[i+window].time_s - frames[i].time_s;
+      const double mean_error_us = (window_s/window - FRAME_PERIOD_S)*1e6;
+      if (fabs(mean_error_us) > config.lock_threshold_us) {
+        lock_index = i + 1;
+      }
+    }
+    locked = lock_index + window < frame_count;
+  }
+  if (!locked) {
+    lock_index = error_count;
+  }
+
+  // Phase error with respect to the roll-over phase at lock time
+  const double lock_time_s = frames[lock_index].time_s;
+  const size_t steady_count = error_count - lock_index;
+  for (size_t i = 0; i < steady_count; ++i) {
+    const size_t frame = lock_index + 1 + i;
+    const double ideal_s = lock_time_s + (frame - lock_index)*FRAME_PERIOD_S;
+    phase_error[i] = (frames[frame].time_s - ideal_s)*1e6;
+  }
+
+  printf("Frames recorded:             %zu\n", frame_count);
+  printf(
+        "Lock threshold:              %.3f µs mean period error over %zu frames\n"
+      , config.lock_threshold_us, window
+  );
+  if (locked) {
+    printf("Lock time:                   %.3f s (frame %zu)\n", lock_time_s, lock_index);
+  }
+  else {
+    printf("Lock time:                   not locked\n");
+  }
+
+  const struct statistics_t initial_period = get_statistics(period_error, lock_index);
+  const struct statistics_t steady_period = get_statistics(
+      period_error + lock_index, steady_count
+  );
+  const struct statistics_t steady_phase = get_statistics(phase_error, steady_count);
+  print_statistics("Period error, lock-in (µs)", &initial_period);
+  print_statistics("Period error, locked (µs)", &steady_period);
+  print_statistics("Phase error, locked (µs)", &steady_phase);
+  if (steady_count > 0) {
+    // Residual frequency error, and the phase error that remains after removing it
+    const double locked_s = frames[frame_count-1].time_s - lock_time_s;
+    const double drift_ppm = phase_error[steady_count-1]/locked_s;
+    double* detrended = malloc(steady_count*sizeof(double));
+    for (size_t i = 0; i < steady_count; ++i) {
+      const double frame_s = frames[lock_index + 1 + i].time_s - lock_time_s;
+      detrended[i] = phase_error[i] - drift_ppm*frame_s;
+    }
+    const struct statistics_t detrended_phase = get_statistics(detrended, steady_count);
+    print_statistics("Phase error, detrended (µs)", &detrended_phase);
+    printf("Phase drift, locked:         %.3f ppm\n", drift_ppm);
+    free(detrended);
+  }
+
+  print_histogram("Period error, all frames", period_error, error_count);
+  if (steady_count > 0) {
+    print_histogram("Phase error, locked", phase_error, steady_count);
+  }
+
+  if (config.trace_path) {
+    FILE* trace = fopen(config.trace_path, "w");
+    if (trace) {
+      fprintf(trace, "frame,time_s,period_counts,counts_max,period_error_us,phase_error_us\n");
+      for (size_t frame = 1; frame < frame_count; ++frame) {
+        fprintf(
+              trace, "%zu,%.9f,%u,%lu,%.6f,"
+            , frame, frames[frame].time_s, frames[frame].period_counts
+            , (unsigned long) frames[frame].counts_max, period_error[frame-1]
+        );
+        if (frame > lock_index) {
+          fprintf(trace, "%.6f\n", phase_error[frame - lock_index - 1]);
+        }
+        else {
+          fprintf(trace, "\n");
+        }
+      }
+      fclose(trace);
+    }
+    else {
+      perror(config.trace_path);
+    }
+  }
+
+  bool passed = true;
+  if (config.max_lock_s >= 0 && (!locked || lock_time_s > config.max_lock_s)) {
+    printf("FAIL: lock time exceeds %.3f s\n", config.max_lock_s);
+    passed = false;
+  }
+  if (
+    config.max_phase_us >= 0
+    && (!locked || fmax(-steady_phase.min, steady_phase.max) > config.max_phase_us)
+  ) {
+    printf("FAIL: locked phase error exceeds %.3f µs\n", config.max_phase_us);
+    passed = false;
+  }
+
+  free(period_error);
+  free(phase_error);
+
+  return passed;
+}
+
+
+/* COMMAND LINE */
+static void usage(const char* name) {
+  fprintf(stderr,
+      "usage: %s [options]\n"
+      "  --duration S       simulated time in seconds (default %.0f)\n"
+      "  --ppm P            device clock offset from the SOF clock in ppm (default 0)\n"
+      "  --jitter US        SOF latch time standard deviation in µs (default 0)\n"
+      "  --drop P           probability of a dropped SOF (default 0)\n"
+      "  --drop-burst N     number of consecutive SOFs lost per drop (default 1)\n"
+      "  --lock US          mean period error lock threshold in µs\n"
+      "                     (default: 1 µs or 2 timer counts, whichever is larger)\n"
+      "  --window N         number of frames to average for lock detection (default %u)\n"
+      "  --bins N           number of histogram bins (default %u)\n"
+      "  --seed N           random seed (default %lu)\n"
+      "  --trace FILE       write per-frame CSV data to FILE\n"
+      "  --max-lock S       fail if not locked within S seconds\n"
+      "  --max-phase US     fail if the locked phase error exceeds US µs\n"
+    , name, config.duration_s, config.lock_window, config.histogram_bins, config.seed
+  );
+}
+
+static bool parse_arguments(int argc, char** argv) {
+  static const struct option options[] = {
+      {"duration", required_argument, NULL, 'd'}
+    , {"ppm", required_argument, NULL, 'p'}
+    , {"jitter", required_argument, NULL, 'j'}
+    , {"drop", required_argument, NULL, 'x'}
+    , {"drop-burst", required_argument, NULL, 'X'}
+    , {"lock", required_argument, NULL, 'l'}
+    , {"window", required_argument, NULL, 'w'}
+    , {"bins", required_argument, NULL, 'b'}
+    , {"seed", required_argument, NULL, 's'}
+    , {"trace", required_argument, NULL, 't'}
+    , {"max-lock", required_argument, NULL, 'L'}
+    , {"max-phase", required_argument, NULL, 'P'}
+    , {"help", no_argument, NULL, 'h'}
+    , {NULL, 0, NULL, 0}
+  };
+
+  int option;
+  while ((option = getopt_long(argc, argv, "", options, NULL)) != -1) {
+    switch (option) {
+      case 'd':
+        config.duration_s = atof(optarg);
+        break;
+      case 'p':
+        config.crystal_ppm = atof(optarg);
+        break;
+      case 'j':
+        config.jitter_us = atof(optarg);
+        break;
+      case 'x':
+        config.drop_probability = atof(optarg);
+        break;
+      case 'X':
+        config.drop_burst = strtoul(optarg, NULL, 0);
+        break;
+      case 'l':
+        config.lock_threshold_us = atof(optarg);
+        break;
+      case 'w':
+        config.lock_window = strtoul(optarg, NULL, 0);
+        break;
+      case 'b':
+        config.histogram_bins = strtoul(optarg, NULL, 0);
+        break;
+      case 's':
+        config.seed = strtoul(optarg, NULL, 0);
+        break;
+      case 't':
+        config.trace_path = optarg;
+        break;
+      case 'L':
+        config.max_lock_s = atof(optarg);
+        break;
+      case 'P':
+        config.max_phase_us = atof(optarg);
+        break;
+      default:
+        return false;
+    }
+  }
+
+  return optind == argc
+    && config.duration_s > 0
+    && config.drop_burst > 0
+    && config.lock_window > 0
+    && config.histogram_bins > 0;
+}
+
+
+int main(int argc, char** argv) {
+  if (!parse_arguments(argc, argv)) {
+    usage(argv[0]);
+    return 1;
+  }
+
+  device_frequency = SIM_TIMER_FREQUENCY*(1 + config.crystal_ppm*1e-6);
+  if (config.lock_threshold_us < 0) {
+    config.lock_threshold_us = fmax(1, 2e6/SIM_TIMER_FREQUENCY);
+  }
+  random_state = config.seed ? config.seed : 1;
+
+  printf(
+        "Timer: %.0f Hz, %d-bit %s-counter, %d FPS\n"
+      , (double) SIM_TIMER_FREQUENCY, FRAME_TIMER_RESOLUTION
+      , SIM_COUNTER_DIRECTION > 0 ? "up" : "down", DEVICE_FPS
+  );
+  printf(
+        "SOF: %.1f ppm offset, %.3f µs jitter, %g drop probability (burst %u), %.0f s\n"
+      , config.crystal_ppm, config.jitter_us, config.drop_probability, config.drop_burst
+      , config.duration_s
+  );
+
+  frame_timer_mock_configure(SIM_COUNTER_DIRECTION, SIM_TIMER_FREQUENCY/DEVICE_FPS - 1);
+  frame_timer_mock_set_rollover_hook(record_rollover);
+  init_frame_timer();
+
+  simulate();
+
+  const bool passed = analyse();
+  free(frames);
+
+  return passed ? 0 : 1;
+}
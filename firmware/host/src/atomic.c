@@ -0,0 +1,28 @@
+#include <util/atomic.h>
+#include <stdatomic.h>
+
+// A single lock stands in for the global interrupt enable flag.
+static atomic_flag interrupt_lock = ATOMIC_FLAG_INIT;
+static _Thread_local uint8_t interrupt_depth;
+static atomic_uint_least32_t disable_count;
+
+uint8_t host_interrupts_disable() {
+  const uint8_t previous_depth = interrupt_depth;
+  if (previous_depth == 0) {
+    while (atomic_flag_test_and_set_explicit(&interrupt_lock, memory_order_acquire)) {}
+  }
+  interrupt_depth = previous_depth + 1;
+  atomic_fetch_add_explicit(&disable_count, 1, memory_order_relaxed);
+  return previous_depth;
+}
+
+void host_interrupts_restore(const uint8_t* depth) {
+  interrupt_depth = *depth;
+  if (interrupt_depth == 0) {
+    atomic_flag_clear_explicit(&interrupt_lock, memory_order_release);
+  }
+}
+
+uint32_t host_interrupts_disable_count() {
+  return atomic_load_explicit(&disable_count, memory_order_relaxed);
+}
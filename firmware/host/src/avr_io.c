@@ -0,0 +1,8 @@
+#include <avr/io.h>
+
+volatile uint8_t TCCR1A;
+volatile uint8_t TCCR1B;
+volatile uint8_t TIMSK1;
+volatile uint8_t TIFR1;
+volatile uint16_t TCNT1;
+volatile uint16_t OCR1A;
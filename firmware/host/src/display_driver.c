@@ -0,0 +1,8 @@
+#include "display_driver.h"
+
+/* The host build has no LEDs to drive, but the control endpoint notifies the display driver
+ * of EEPROM writes.
+ */
+
+void reload_display_configuration() {
+}
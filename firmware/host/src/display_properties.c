@@ -0,0 +1,77 @@
+#include "display_properties.h"
+#include "device_properties.h"
+#include "display_types.h"
+#include "frame_buffer.h"
+#include "usb/remote_renderer.h"
+#include "render/event_playback.h"
+#include <stdbool.h>
+
+/* The host build emulates an IceCube display segment, as driven by the Teensy firmware.
+ * Since there is no EEPROM image to read the display configuration from, the compile time
+ * defaults are used directly.
+ */
+
+struct dp_information_range_t {
+  uint8_t start;
+  uint8_t end;
+} __attribute__((packed));
+
+static const struct dp_information_range_t dp_info_range_icecube = {
+    DEVICE_ICECUBE_STRING_START
+  , DEVICE_ICECUBE_STRING_END
+};
+static const struct dp_information_range_t dp_info_range_deepcore = {79, 86};
+
+static const enum display_led_type_t DP_INFO_LED_TYPE = LED_TYPE_WS2811;
+static const enum display_information_type_t DP_INFO_TYPE = INFORMATION_IC_STRING;
+static const uint8_t DP_INFO_FRAME_ENCODINGS = REMOTE_FRAME_ENCODINGS;
+static const uint16_t DP_INFO_EVENT_PULSE_CAPACITY = EVENT_PULSE_CAPACITY;
+static const uint8_t DP_INFO_GROUP[16];
+
+static uint16_t led_count;
+static uint16_t dp_buffer_size;
+
+static const struct dp_tlv_item_t PROPERTIES_TLV_LIST[] = {
+    TLV_ENTRY(DP_INFORMATION_RANGE, MEMSPACE_PROGMEM, &dp_info_range_deepcore)
+  , TLV_ENTRY(DP_LED_TYPE, MEMSPACE_PROGMEM, &DP_INFO_LED_TYPE)
+  , TLV_ENTRY(DP_INFORMATION_TYPE, MEMSPACE_PROGMEM, &DP_INFO_TYPE)
+  , TLV_ENTRY(DP_BUFFER_SIZE, MEMSPACE_RAM, &dp_buffer_size)
+  , TLV_ENTRY(DP_INFORMATION_RANGE, MEMSPACE_PROGMEM, &dp_info_range_icecube)
+  , TLV_ENTRY(DP_GROUP_ID, MEMSPACE_PROGMEM, &DP_INFO_GROUP)
+  , TLV_ENTRY(DP_FRAME_ENCODINGS, MEMSPACE_PROGMEM, &DP_INFO_FRAME_ENCODINGS)
+  , TLV_ENTRY(DP_EVENT_PULSE_CAPACITY, MEMSPACE_PROGMEM, &DP_INFO_EVENT_PULSE_CAPACITY)
+  , TLV_END
+};
+
+void init_display_properties() {
+  led_count = 60*(dp_info_range_icecube.end-dp_info_range_icecube.start+1);
+  if (DEVICE_HAS_DEEPCORE) {
+    led_count += 60*(dp_info_range_deepcore.end-dp_info_range_deepcore.start+1);
+  }
+  dp_buffer_size = get_frame_buffer_size();
+}
+
+uint16_t get_led_count() {
+  return led_count;
+}
+
+uint8_t get_led_size() {
+  return sizeof(struct led_t);
+}
+
+enum display_led_color_order_t get_color_order() {
+  return LED_ORDER_GRB;
+}
+
+bool get_reverse_first_strip_segment() {
+  return DEVICE_REVERSE_FIRST_STRIP_SEGMENT;
+}
+
+const struct dp_tlv_item_t* get_display_properties_P() {
+  if (DEVICE_HAS_DEEPCORE) {
+    return &(PROPERTIES_TLV_LIST[0]);
+  }
+  else {
+    return &(PROPERTIES_TLV_LIST[1]);
+  }
+}
@@ -0,0 +1,37 @@
+#include <avr/eeprom.h>
+#include <string.h>
+
+uint8_t __eeprom_start[E2END+1];
+
+// Initialise the emulated EEPROM like an unprogrammed device
+__attribute__((constructor)) static void init_eeprom() {
+  memset(__eeprom_start, 0xFF, sizeof(__eeprom_start));
+}
+
+uint8_t eeprom_read_byte(const uint8_t* addr) {
+  return *addr;
+}
+
+uint16_t eeprom_read_word(const uint16_t* addr) {
+  uint16_t value;
+  memcpy(&value, addr, sizeof(value));
+  return value;
+}
+
+uint32_t eeprom_read_dword(const uint32_t* addr) {
+  uint32_t value;
+  memcpy(&value, addr, sizeof(value));
+  return value;
+}
+
+void eeprom_read_block(void* buf, const void* addr, uint32_t len) {
+  memcpy(buf, addr, len);
+}
+
+void eeprom_write_byte(uint8_t* addr, uint8_t value) {
+  *addr = value;
+}
+
+void eeprom_write_block(const void* buf, void* addr, uint32_t len) {
+  memcpy(addr, buf, len);
+}
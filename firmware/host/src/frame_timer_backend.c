@@ -0,0 +1,123 @@
+#include "host/frame_timer_mock.h"
+#include "trace.h"
+
+static void (*callback)();
+static void (*rollover_hook)(uint64_t, uint32_t);
+
+static int8_t direction = 1;
+// Value returned by get_counts_max(), includes pending corrections
+static timer_count_t counts_max = 0xFFFF;
+// Roll-over value of the current timer period
+static timer_count_t active_counts_max = 0xFFFF;
+// Number of counts elapsed in the current period
+static timer_count_t counts_elapsed;
+static uint64_t total_counts;
+static bool interrupt_masked;
+static bool interrupt_pending;
+// Roll-over of the pending interrupt, for the roll-over hook
+static uint64_t pending_total_counts;
+static uint32_t pending_period;
+
+static void rollover_interrupt(uint64_t at_total_counts, uint32_t period) {
+  if (callback) {
+    callback();
+  }
+  if (rollover_hook) {
+    rollover_hook(at_total_counts, period);
+  }
+}
+
+void frame_timer_mock_configure(int8_t counter_direction, timer_count_t max) {
+  direction = counter_direction < 0 ? -1 : 1;
+  counts_max = max;
+  active_counts_max = max;
+  counts_elapsed = 0;
+  total_counts = 0;
+  interrupt_masked = false;
+  interrupt_pending = false;
+}
+
+void frame_timer_mock_advance(uint32_t counts) {
+  while (counts) {
+    const uint32_t remaining = frame_timer_mock_counts_to_rollover();
+    if (counts < remaining) {
+      counts_elapsed += counts;
+      total_counts += counts;
+      counts = 0;
+    }
+    else {
+      // Reload the counter with the latest roll-over value
+      counts -= remaining;
+      total_counts += remaining;
+      const uint32_t period = (uint32_t) active_counts_max + 1;
+      counts_elapsed = 0;
+      active_counts_max = counts_max;
+      if (!interrupt_masked) {
+        rollover_interrupt(total_counts, period);
+      }
+      else if (!interrupt_pending) {
+        interrupt_pending = true;
+        pending_total_counts = total_counts;
+        pending_period = period;
+      }
+    }
+  }
+}
+
+uint32_t frame_timer_mock_counts_to_rollover() {
+  return (uint32_t) active_counts_max + 1 - counts_elapsed;
+}
+
+timer_count_t frame_timer_mock_active_counts_max() {
+  return active_counts_max;
+}
+
+uint64_t frame_timer_mock_total_counts() {
+  return total_counts;
+}
+
+void frame_timer_mock_mask_interrupt(bool masked) {
+  interrupt_masked = masked;
+  if (!masked && interrupt_pending) {
+    interrupt_pending = false;
+    rollover_interrupt(pending_total_counts, pending_period);
+  }
+}
+
+void frame_timer_mock_set_rollover_hook(void (*hook)(uint64_t, uint32_t)) {
+  rollover_hook = hook;
+}
+
+void init_frame_timer_backend(void (*timer_callback)()) {
+  callback = timer_callback;
+  counts_elapsed = 0;
+}
+
+int8_t get_counter_direction() {
+  return direction;
+}
+
+timer_count_t get_counts_max() {
+  return counts_max;
+}
+
+timer_count_t get_counts_current() {
+  if (direction > 0) {
+    return counts_elapsed;
+  }
+  else {
+    return active_counts_max - counts_elapsed;
+  }
+}
+
+bool is_rollover_pending() {
+  return interrupt_pending;
+}
+
+void correct_counts_max(timer_diff_t diff) {
+  counts_max += diff;
+}
+
+uint32_t get_trace_timestamp() {
+  return (uint32_t) total_counts;
+}
@@ -0,0 +1,26 @@
+#include "remote.h"
+#include "usb/device.h"
+#include "usb/led.h"
+#include "usb/remote_renderer.h"
+#include "usb/remote_status.h"
+
+/* The host has no USB hardware. Test code drives the USB state machines directly, e.g. by
+ * calling process_setup() or writing into the remote renderer's transfer state.
+ */
+
+void init_remote() {
+  init_led();
+  set_device_state(ATTACHED);
+}
+
+bool is_remote_connected() {
+  return get_device_state() == CONFIGURED;
+}
+
+void ep1_init() {
+  remote_renderer_init();
+}
+
+void ep2_init() {
+  remote_status_init();
+}
@@ -0,0 +1,11 @@
+#include "usb/address.h"
+
+static uint8_t address;
+
+uint8_t usb_get_address() {
+  return address;
+}
+
+void usb_set_address(uint8_t new_address) {
+  address = new_address & 0x7F;
+}
@@ -0,0 +1,77 @@
+#include "usb/endpoint.h"
+
+/* Host endpoint bookkeeping.
+ * No data is actually moved, but the endpoint state is tracked such that the common USB code
+ * (endpoint_0.c, remote_renderer.c) behaves as it would on the microcontroller.
+ */
+
+#define MAX_ENDPOINTS 4
+
+struct ep_state_t {
+  uint16_t size;
+  bool configured;
+  bool stalled;
+};
+
+static struct ep_state_t ep_state[MAX_ENDPOINTS];
+
+bool endpoint_configure(const struct ep_config_t* config) {
+  if (config->num >= MAX_ENDPOINTS) {
+    return false;
+  }
+
+  struct ep_state_t* ep = &ep_state[config->num];
+  ep->size = config->size;
+  ep->configured = true;
+  ep->stalled = false;
+
+  if (config->init) {
+    config->init();
+  }
+  else {
+    endpoint_init_default(config->num);
+  }
+
+  return true;
+}
+
+void endpoint_init_default(const uint8_t ep_num) {
+  (void) ep_num;
+}
+
+void endpoint_deconfigure(const uint8_t ep_num) {
+  if (ep_num < MAX_ENDPOINTS) {
+    ep_state[ep_num].configured = false;
+  }
+}
+
+uint16_t endpoint_get_size(const uint8_t ep_num) {
+  if (ep_num < MAX_ENDPOINTS) {
+    return ep_state[ep_num].size;
+  }
+  return 0;
+}
+
+bool endpoint_stall(const uint8_t ep_num) {
+  if (ep_num < MAX_ENDPOINTS && ep_state[ep_num].configured) {
+    ep_state[ep_num].stalled = true;
+    return true;
+  }
+  return false;
+}
+
+bool endpoint_clear_stall(const uint8_t ep_num) {
+  if (ep_num < MAX_ENDPOINTS && ep_state[ep_num].configured) {
+    ep_state[ep_num].stalled = false;
+    return true;
+  }
+  return false;
+}
+
+bool endpoint_is_stalled(const uint8_t ep_num) {
+  return ep_num < MAX_ENDPOINTS && ep_state[ep_num].stalled;
+}
+
+void endpoint_reset_data_toggle(const uint8_t ep_num) {
+  (void) ep_num;
+}
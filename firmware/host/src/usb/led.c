@@ -0,0 +1,16 @@
+#include "usb/led.h"
+
+// There is no activity LED on the host, so only the mode is tracked
+static enum led_mode_t led_mode;
+
+void init_led() {
+  set_led_state(LED_OFF);
+}
+
+void set_led_state(const enum led_mode_t mode) {
+  led_mode = mode;
+}
+
+void trip_led() {
+  (void) led_mode;
+}
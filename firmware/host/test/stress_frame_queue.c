@@ -0,0 +1,150 @@
+/* Multi-threaded stress test of the lock-free frame queue in firmware/common/frame_queue.c.
+ * One or more producer threads push tagged pointers as fast as possible, while a consumer thread
+ * pops them and verifies that no frame is lost, duplicated or reordered.
+ * The pointers are never dereferenced, so they only have to be unique and non-NULL.
+ */
+#include "host/bench.h"
+
+#include "frame_queue.h"
+
+#include <util/atomic.h>
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define DEFAULT_ITEMS 2000000
+#define MAX_PRODUCERS 4
+#define PRODUCER_BITS 4
+
+static uint32_t item_count = DEFAULT_ITEMS;
+static unsigned int producer_count = 1;
+
+static atomic_bool start;
+
+#define SPIN_COUNT 256
+
+/* Spin for a while, to maximise contention on multi-core hosts, but then let the other threads
+ * run, also on single core hosts where yielding does not necessarily reschedule.
+ */
+static void back_off(uint64_t retries) {
+  if (retries % SPIN_COUNT == 0) {
+    const struct timespec delay = {.tv_sec = 0, .tv_nsec = 1000};
+    nanosleep(&delay, NULL);
+  }
+}
+
+struct producer_t {
+  pthread_t thread;
+  uintptr_t id;
+  uint64_t full_retries;
+};
+
+static inline struct frame_buffer_t* make_item(uintptr_t producer, uintptr_t sequence) {
+  return (struct frame_buffer_t*) (((sequence + 1) << PRODUCER_BITS) | producer);
+}
+
+static void* produce(void* arg) {
+  struct producer_t* producer = arg;
+  while (!atomic_load(&start)) {}
+
+  for (uint32_t sequence = 0; sequence < item_count; ++sequence) {
+    struct frame_buffer_t* item = make_item(producer->id, sequence);
+    while (!push_frame(item)) {
+      back_off(++producer->full_retries);
+    }
+  }
+  return NULL;
+}
+
+int main(int argc, char** argv) {
+  if (argc > 1) {
+    item_count = strtoul(argv[1], NULL, 0);
+  }
+  if (argc > 2) {
+    producer_count = strtoul(argv[2], NULL, 0);
+  }
+  if (item_count == 0 || producer_count == 0 || producer_count > MAX_PRODUCERS) {
+    fprintf(stderr, "usage: %s [items per producer] [producers (1-%d)]\n", argv[0], MAX_PRODUCERS);
+    return 1;
+  }
+
+  const unsigned int masks_before = host_interrupts_disable_count();
+
+  struct producer_t producers[MAX_PRODUCERS] = {{0}};
+  for (unsigned int i = 0; i < producer_count; ++i) {
+    producers[i].id = i;
+    if (pthread_create(&producers[i].thread, NULL, produce, &producers[i])) {
+      perror("pthread_create");
+      return 2;
+    }
+  }
+
+  // Consume on the main thread
+  uint32_t next_sequence[MAX_PRODUCERS] = {0};
+  uint64_t received = 0;
+  uint64_t empty_retries = 0;
+  unsigned int errors = 0;
+  const uint64_t total = (uint64_t) item_count*producer_count;
+
+  const uint64_t start_ns = bench_time_ns();
+  atomic_store(&start, true);
+
+  while (received < total) {
+    struct frame_buffer_t* item = pop_frame();
+    if (!item) {
+      back_off(++empty_retries);
+      continue;
+    }
+
+    const uintptr_t value = (uintptr_t) item;
+    const uintptr_t producer = value & ((1 << PRODUCER_BITS) - 1);
+    const uintptr_t sequence = (value >> PRODUCER_BITS) - 1;
+    if (producer >= producer_count || sequence != next_sequence[producer]) {
+      if (errors++ < 10) {
+        fprintf(
+              stderr, "Unexpected item %#lx after %lu items, expected sequence %u of producer %lu\n"
+            , (unsigned long) value, (unsigned long) received
+            , producer < producer_count ? next_sequence[producer] : 0, (unsigned long) producer
+        );
+      }
+      if (producer < producer_count) {
+        next_sequence[producer] = sequence;
+      }
+    }
+    if (producer < producer_count) {
+      next_sequence[producer]++;
+    }
+    received++;
+  }
+
+  const uint64_t ns = bench_time_ns() - start_ns;
+
+  uint64_t full_retries = 0;
+  for (unsigned int i = 0; i < producer_count; ++i) {
+    pthread_join(producers[i].thread, NULL);
+    full_retries += producers[i].full_retries;
+  }
+
+  if (!frame_queue_empty() || pop_frame() != NULL) {
+    fprintf(stderr, "Queue not empty after all items were received\n");
+    errors++;
+  }
+
+  const unsigned int masks = host_interrupts_disable_count() - masks_before;
+  if (masks != 0) {
+    fprintf(stderr, "Queue operations masked interrupts %u times\n", masks);
+    errors++;
+  }
+
+  printf(
+        "%lu items from %u producer(s) in %.3f s (%.1f ns/item), %lu full, %lu empty retries\n"
+      , (unsigned long) received, producer_count, ns*1e-9, (double) ns/received
+      , (unsigned long) full_retries, (unsigned long) empty_retries
+  );
+  printf("%s: %u errors\n", errors ? "FAIL" : "PASS", errors);
+
+  return errors ? 1 : 0;
+}
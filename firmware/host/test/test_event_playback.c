@@ -0,0 +1,98 @@
+/* Check of the event playback renderer in firmware/icecube-teensy32/src/render/event_playback.c.
+ * A few pulses are uploaded and played back, and the rendered LED values are compared with the
+ * expected rise and decay of the pulses' brightness.
+ */
+#include "host/check.h"
+
+#include "render/event_playback.h"
+#include "display_properties.h"
+#include "frame_buffer.h"
+
+#define RISE 4
+#define DECAY 10
+
+// Red value of an LED in a rendered frame, or -1 if no frame was rendered
+static int render_red(const struct renderer_t* renderer, uint16_t led) {
+  struct frame_buffer_t* frame = renderer->render_frame();
+  if (!frame) {
+    return -1;
+  }
+  const int red = frame->buffer[led*get_led_size()];
+  destroy_frame(frame);
+  return red;
+}
+
+int main() {
+  init_display_properties();
+  init_frame_buffers();
+  const struct renderer_t* renderer = get_event_playback_renderer();
+
+  CHECK(get_event_pulse_upload(EVENT_PULSE_CAPACITY, 1) == NULL, "Upload past the capacity accepted");
+  struct event_pulse_t* pulses = get_event_pulse_upload(0, 3);
+  CHECK(pulses != NULL, "Upload refused");
+  if (!pulses) {
+    return 1;
+  }
+  // Two overlapping pulses on LED 1, which saturate, and a pulse on LED 2
+  pulses[0] = (struct event_pulse_t) {0, 1, {200, 0, 0}, 255};
+  pulses[1] = (struct event_pulse_t) {2, 2, {255, 0, 0}, 51};
+  pulses[2] = (struct event_pulse_t) {3, 1, {200, 0, 0}, 255};
+
+  struct event_playback_t playback = {3, 20, RISE, DECAY, 0, 0};
+  CHECK(!is_event_playback_enabled(), "Playback enabled after upload");
+  playback.pulse_count = EVENT_PULSE_CAPACITY + 1;
+  CHECK(!start_event_playback(&playback), "Too many pulses accepted");
+  playback.pulse_count = 3;
+  CHECK(start_event_playback(&playback), "Playback refused");
+  CHECK(is_event_playback_enabled(), "Playback not enabled");
+  renderer->start();
+
+  // Expected red value of LED 2: rise to 51, then decay to 0
+  const int expected_led2[] = {0, 0, 12, 25, 38, 51, 45, 40, 35, 30, 25, 20, 15, 10, 5, 0};
+  for (unsigned int frame = 0; frame < 20; ++frame) {
+    struct frame_buffer_t* f = renderer->render_frame();
+    CHECK(f != NULL, "Frame %u not rendered", frame);
+    if (!f) {
+      continue;
+    }
+    const uint8_t led_size = get_led_size();
+    const int led1 = f->buffer[led_size];
+    const int led2 = f->buffer[2*led_size];
+    const int expected2 = frame < sizeof(expected_led2)/sizeof(int) ? expected_led2[frame] : 0;
+    CHECK(led2 == expected2, "Frame %u: LED 2 is %d instead of %d", frame, led2, expected2);
+    if (frame == 0) {
+      CHECK(led1 == 49, "Frame 0: LED 1 is %d while rising", led1);
+    }
+    else if (frame >= 4 && frame <= 6) {
+      CHECK(led1 == 255, "Frame %u: LED 1 is %d instead of saturating", frame, led1);
+    }
+    else if (frame >= 17) {
+      CHECK(led1 == 0, "Frame %u: LED 1 is %d after decaying", frame, led1);
+    }
+    CHECK(f->buffer[led_size + 1] == 0, "Frame %u: green is lit", frame);
+    destroy_frame(f);
+  }
+  CHECK(render_red(renderer, 1) == -1, "Frame rendered after the end of the playback");
+
+  // Pulses without decay stay lit, and a looping playback restarts
+  playback.decay_frames = 0;
+  playback.duration = 8;
+  playback.flags = EVENT_PLAYBACK_LOOP;
+  start_event_playback(&playback);
+  int last = -1;
+  for (unsigned int frame = 0; frame < 8; ++frame) {
+    last = render_red(renderer, 2);
+  }
+  CHECK(last == 51, "LED 2 is %d at the end of the playback, instead of staying lit", last);
+  last = render_red(renderer, 2);
+  CHECK(last == 0, "LED 2 is %d after looping", last);
+
+  // Uploads and stopping disable the playback
+  renderer->stop();
+  CHECK(!is_event_playback_enabled(), "Playback still enabled after stopping the renderer");
+  start_event_playback(&playback);
+  get_event_pulse_upload(0, 1);
+  CHECK(!is_event_playback_enabled(), "Playback still enabled after an upload");
+
+  return check_report();
+}
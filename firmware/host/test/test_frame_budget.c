@@ -0,0 +1,68 @@
+/* Check of the frame budget measurement in firmware/common/frame_timer.c.
+ * The main loop's work on a frame is emulated by advancing the frame timer between the roll-over
+ * that flags a frame draw and the call to clear_draw_frame(), for up- and down-counting timers.
+ * A roll-over of which the interrupt is still pending when the frame is finished is checked too.
+ */
+#include "host/check.h"
+#include "host/frame_timer_mock.h"
+
+#include "frame_timer.h"
+
+#define INTERVAL 10000
+
+// Start the work on a frame at the next roll-over, and finish it after work counts
+static void work_on_frame(uint32_t work) {
+  frame_timer_mock_advance(frame_timer_mock_counts_to_rollover());
+  CHECK(should_draw_frame(), "Frame draw not flagged");
+  frame_timer_mock_advance(work);
+  clear_draw_frame();
+}
+
+static void check_counter(int8_t direction) {
+  frame_timer_mock_configure(direction, INTERVAL - 1);
+  init_frame_timer();
+
+  struct frame_budget_t budget;
+  read_frame_budget(&budget, false);
+  CHECK(budget.frames_measured == 0, "Direction %d: frames measured before start", direction);
+  CHECK(budget.interval_us == 1000000/DEVICE_FPS, "Direction %d: interval %u us", direction, budget.interval_us);
+  CHECK(budget.interval_counts == INTERVAL, "Direction %d: interval %u counts", direction, budget.interval_counts);
+
+  work_on_frame(1000);
+  work_on_frame(3000);
+  work_on_frame(2000);
+  read_frame_budget(&budget, true);
+  CHECK(budget.frames_measured == 3, "Direction %d: %u frames measured", direction, budget.frames_measured);
+  CHECK(budget.min_slack_counts == INTERVAL - 3000, "Direction %d: slack %d", direction, budget.min_slack_counts);
+  CHECK(budget.ticks_missed == 0, "Direction %d: %u ticks missed", direction, budget.ticks_missed);
+
+  // Finish after the next roll-over, and then after two roll-overs
+  work_on_frame(INTERVAL + 500);
+  work_on_frame(2*INTERVAL + 100);
+  read_frame_budget(&budget, true);
+  CHECK(budget.frames_measured == 2, "Direction %d: %u overrun frames measured", direction, budget.frames_measured);
+  CHECK(budget.min_slack_counts == -INTERVAL - 100, "Direction %d: overrun slack %d", direction, budget.min_slack_counts);
+  CHECK(budget.ticks_missed == 3, "Direction %d: %u overrun ticks missed", direction, budget.ticks_missed);
+
+  read_frame_budget(&budget, false);
+  CHECK(budget.frames_measured == 0 && budget.ticks_missed == 0, "Direction %d: not cleared", direction);
+
+  // Finish just after a roll-over, before its interrupt is handled
+  frame_timer_mock_advance(frame_timer_mock_counts_to_rollover());
+  frame_timer_mock_mask_interrupt(true);
+  frame_timer_mock_advance(INTERVAL + 200);
+  CHECK(is_rollover_pending(), "Direction %d: roll-over not pending", direction);
+  clear_draw_frame();
+  frame_timer_mock_mask_interrupt(false);
+  CHECK(should_draw_frame(), "Direction %d: pending frame draw not flagged", direction);
+  read_frame_budget(&budget, true);
+  CHECK(budget.min_slack_counts == -200, "Direction %d: pending slack %d", direction, budget.min_slack_counts);
+  CHECK(budget.ticks_missed == 1, "Direction %d: %u pending ticks missed", direction, budget.ticks_missed);
+}
+
+int main() {
+  check_counter(1);
+  check_counter(-1);
+
+  return check_report();
+}
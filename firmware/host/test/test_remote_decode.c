@@ -0,0 +1,206 @@
+/* Check of the frame encoding decoders in firmware/common/usb/remote_renderer.c.
+ * Sparse frames are encoded with a reference encoder, fed to remote_renderer_decode() in
+ * endpoint sized packets, and compared with the frames that are pushed to the frame queue.
+ */
+#include "host/check.h"
+
+#include "usb/remote_renderer.h"
+#include "color_palette.h"
+#include "display_properties.h"
+#include "frame_buffer.h"
+#include "frame_queue.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PACKET_SIZE 64
+#define MAX_FRAME_SIZE 16384
+
+static uint8_t frame_data[MAX_FRAME_SIZE];
+static uint8_t previous_data[MAX_FRAME_SIZE];
+// Worst case: a frame type byte, and one header byte per 128 literal bytes
+static uint8_t encoded[1 + MAX_FRAME_SIZE + MAX_FRAME_SIZE/128 + 1];
+
+// Reference encoder, skipping runs of three or more bytes that are zero, or equal to the byte in
+// the previous frame if it is given. The runs are appended to the encoded data at offset out.
+static size_t encode_runs(const uint8_t* data, const uint8_t* previous, size_t length, size_t out) {
+#define SKIPPED(p) (data[p] == (previous ? previous[p] : 0))
+  size_t pos = 0;
+  while (pos < length) {
+    size_t skipped = 0;
+    while (pos + skipped < length && SKIPPED(pos + skipped) && skipped < 128) {
+      ++skipped;
+    }
+    if (skipped >= 3 || pos + skipped == length) {
+      encoded[out++] = skipped - 1;
+      pos += skipped;
+      continue;
+    }
+    // Literal run up to the next run of three skipped bytes
+    size_t literal = 0;
+    while (pos + literal < length && literal < 128) {
+      const size_t next = pos + literal;
+      if (next + 3 <= length && SKIPPED(next) && SKIPPED(next + 1) && SKIPPED(next + 2)) {
+        break;
+      }
+      ++literal;
+    }
+    encoded[out++] = 0x80 | (literal - 1);
+    memcpy(encoded + out, data + pos, literal);
+    out += literal;
+    pos += literal;
+  }
+  return out;
+#undef SKIPPED
+}
+
+static size_t encode_zero_runs(const uint8_t* data, size_t length) {
+  return encode_runs(data, NULL, length, 0);
+}
+
+// Send encoded data in packets, like the endpoint's ISR does
+static bool send_packets(size_t length) {
+  struct frame_transfer_state_t* state = remote_renderer_get_transfer_state();
+  for (size_t offset = 0; offset < length; offset += PACKET_SIZE) {
+    const size_t packet = length - offset < PACKET_SIZE ? length - offset : PACKET_SIZE;
+    if (!remote_renderer_decode(encoded + offset, packet)) {
+      return false;
+    }
+    if (state->write_pos == state->buffer_end) {
+      remote_renderer_transfer_done();
+      return offset + packet == length;
+    }
+  }
+  return false;
+}
+
+int main() {
+  init_display_properties();
+  init_color_palette();
+  init_frame_buffers();
+  const size_t frame_size = get_frame_buffer_size();
+  if (frame_size > MAX_FRAME_SIZE) {
+    fprintf(stderr, "Frame size %zu too large\n", frame_size);
+    return 1;
+  }
+
+  CHECK(!remote_renderer_set_frame_encoding(7), "Unsupported encoding accepted");
+  CHECK(remote_renderer_set_frame_encoding(REMOTE_FRAME_ENCODING_ZERO_RUN), "Encoding refused");
+  remote_renderer_init();
+  CHECK(
+      remote_renderer_get_transfer_state()->encoding == REMOTE_FRAME_ENCODING_ZERO_RUN
+    , "Encoding not applied"
+  );
+
+  // Frames with an increasing fraction of lit bytes, up to completely filled
+  srand(1);
+  const unsigned int densities[] = {0, 1, 5, 10, 50, 100};
+  for (unsigned int i = 0; i < sizeof(densities)/sizeof(densities[0]); ++i) {
+    for (size_t b = 0; b < frame_size; ++b) {
+      frame_data[b] = (unsigned int) rand() % 100 < densities[i] ? 1 + rand() % 255 : 0;
+    }
+    const size_t length = encode_zero_runs(frame_data, frame_size);
+    CHECK(send_packets(length), "Density %u%%: frame not completed", densities[i]);
+    struct frame_buffer_t* frame = pop_frame();
+    CHECK(frame != NULL, "Density %u%%: no frame pushed", densities[i]);
+    if (frame) {
+      CHECK(
+          memcmp(frame->buffer, frame_data, frame_size) == 0
+        , "Density %u%%: decoded frame differs", densities[i]
+      );
+      printf("%3u%% lit: %5zu of %zu bytes\n", densities[i], length, frame_size);
+      destroy_frame(frame);
+    }
+  }
+
+  // Runs past the end of the frame
+  memset(frame_data, 0, frame_size);
+  size_t length = encode_zero_runs(frame_data, frame_size);
+  encoded[length++] = 0;
+  CHECK(!send_packets(length), "Trailing zero run accepted");
+  remote_renderer_init();
+  length = encode_zero_runs(frame_data, frame_size - 1);
+  encoded[length++] = 0x81;
+  encoded[length++] = 1;
+  encoded[length++] = 2;
+  CHECK(!send_packets(length), "Literal run past the end of the frame accepted");
+  CHECK(pop_frame() == NULL, "Invalid frame pushed");
+
+  // Delta frames require a previous frame, which is not available after a reset
+  CHECK(remote_renderer_set_frame_encoding(REMOTE_FRAME_ENCODING_DELTA), "Delta encoding refused");
+  remote_renderer_init();
+  encoded[0] = 1;
+  length = encode_runs(frame_data, frame_data, frame_size, 1);
+  CHECK(!send_packets(length), "Delta frame accepted without a previous frame");
+  remote_renderer_init();
+  encoded[0] = 2;
+  length = encode_runs(frame_data, NULL, frame_size, 1);
+  CHECK(!send_packets(length), "Unknown frame type accepted");
+  CHECK(pop_frame() == NULL, "Invalid delta frame pushed");
+  remote_renderer_init();
+
+  // Full frames, each followed by frames with a few changed bytes
+  for (unsigned int i = 0; i < 6; ++i) {
+    const bool full = i % 3 == 0;
+    memcpy(previous_data, frame_data, frame_size);
+    for (size_t b = 0; b < frame_size; ++b) {
+      if (full) {
+        frame_data[b] = rand() % 100 < 5 ? 1 + rand() % 255 : 0;
+      }
+      else if (rand() % 100 == 0) {
+        frame_data[b] = rand();
+      }
+    }
+    encoded[0] = full ? 0 : 1;
+    length = encode_runs(frame_data, full ? NULL : previous_data, frame_size, 1);
+    CHECK(send_packets(length), "Delta %u: frame not completed", i);
+    struct frame_buffer_t* frame = pop_frame();
+    CHECK(frame != NULL, "Delta %u: no frame pushed", i);
+    if (frame) {
+      CHECK(memcmp(frame->buffer, frame_data, frame_size) == 0, "Delta %u: decoded frame differs", i);
+      printf("%s frame: %5zu of %zu bytes\n", full ? " full" : "delta", length, frame_size);
+      destroy_frame(frame);
+    }
+  }
+
+  // Palette indexed frames, with one byte per LED
+  uint8_t* palette = get_color_palette();
+  CHECK(palette != NULL, "No color palette");
+  if (palette) {
+    const uint8_t led_size = get_led_size();
+    const size_t led_count = frame_size/led_size;
+    for (size_t b = 0; b < get_color_palette_size(); ++b) {
+      palette[b] = rand();
+    }
+    CHECK(remote_renderer_set_frame_encoding(REMOTE_FRAME_ENCODING_INDEXED), "Indexed encoding refused");
+    remote_renderer_init();
+    for (size_t led = 0; led < led_count; ++led) {
+      encoded[led] = rand();
+      memcpy(frame_data + led*led_size, palette + encoded[led]*led_size, led_size);
+    }
+    CHECK(send_packets(led_count), "Indexed frame not completed");
+    struct frame_buffer_t* frame = pop_frame();
+    CHECK(frame != NULL, "No indexed frame pushed");
+    if (frame) {
+      CHECK(memcmp(frame->buffer, frame_data, frame_size) == 0, "Indexed frame differs");
+      printf("indexed: %5zu of %zu bytes\n", led_count, frame_size);
+      destroy_frame(frame);
+    }
+
+    // Indices past the end of the frame
+    encoded[led_count] = 0;
+    CHECK(!send_packets(led_count + 1), "Index past the end of the frame accepted");
+    CHECK(pop_frame() == NULL, "Invalid indexed frame pushed");
+  }
+
+  // Switch back to raw frames
+  remote_renderer_set_frame_encoding(REMOTE_FRAME_ENCODING_RAW);
+  remote_renderer_init();
+  CHECK(
+      remote_renderer_get_transfer_state()->encoding == REMOTE_FRAME_ENCODING_RAW
+    , "Raw encoding not applied"
+  );
+
+  return check_report();
+}
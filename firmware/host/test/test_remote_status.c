@@ -0,0 +1,76 @@
+/* Check of the status reports in firmware/common/usb/remote_status.c.
+ * Frame timer roll-overs are simulated, and the reports are compared with the frame queue,
+ * EP1, and frame counter state.
+ */
+#include "host/check.h"
+#include "host/frame_timer_mock.h"
+
+#include "usb/remote_status.h"
+#include "usb/configuration.h"
+#include "usb/endpoint.h"
+#include "usb/remote_renderer.h"
+#include "remote.h"
+#include "display_properties.h"
+#include "frame_buffer.h"
+#include "frame_queue.h"
+#include "frame_timer.h"
+
+#define INTERVAL 10000
+
+static void next_rollover() {
+  frame_timer_mock_advance(frame_timer_mock_counts_to_rollover());
+}
+
+int main() {
+  init_display_properties();
+  init_frame_buffers();
+  frame_timer_mock_configure(1, INTERVAL - 1);
+  init_frame_timer();
+  set_configuration_index(1);
+
+  struct remote_status_t status;
+  CHECK(sizeof(status) <= REMOTE_STATUS_ENDPOINT_SIZE, "Report doesn't fit in the endpoint");
+
+  // A report is sent right after the endpoint is configured, and then once per roll-over
+  CHECK(remote_status_poll(&status), "No report after configuration");
+  CHECK(status.queue_free == 2, "%u free slots in an empty queue", status.queue_free);
+  CHECK(status.flags == REMOTE_STATUS_READY, "Flags 0x%x after configuration", status.flags);
+  CHECK(status.display_frame_counter == 0, "Display frame counter %u", status.display_frame_counter);
+  CHECK(!remote_status_poll(&status), "Report without roll-over");
+
+  next_rollover();
+  push_frame(create_frame());
+  CHECK(remote_status_poll(&status), "No report after roll-over");
+  CHECK(!remote_status_poll(&status), "Second report after a single roll-over");
+  CHECK(status.display_frame_counter == 1, "Display frame counter %u", status.display_frame_counter);
+  CHECK(status.queue_free == 1, "%u free slots after a push", status.queue_free);
+
+  // A full queue refuses frames, which halts EP1
+  next_rollover();
+  push_frame(create_frame());
+  remote_renderer_transfer_done();
+  CHECK(remote_status_poll(&status), "No report after roll-over");
+  CHECK(status.queue_free == 0, "%u free slots in a full queue", status.queue_free);
+  CHECK(status.flags == REMOTE_STATUS_HALTED, "Flags 0x%x after a refused frame", status.flags);
+  CHECK(status.telemetry[TELEMETRY_PUSH_REFUSED] == 1, "%u refused pushes", status.telemetry[TELEMETRY_PUSH_REFUSED]);
+  CHECK(status.telemetry[TELEMETRY_REMOTE_HALTED] == 1, "%u halts", status.telemetry[TELEMETRY_REMOTE_HALTED]);
+
+  // Missed roll-overs are reported once
+  destroy_frame(pop_frame());
+  destroy_frame(pop_frame());
+  next_rollover();
+  next_rollover();
+  CHECK(remote_status_poll(&status), "No report after two roll-overs");
+  CHECK(!remote_status_poll(&status), "Second report after two roll-overs");
+  CHECK(status.display_frame_counter == 4, "Display frame counter %u", status.display_frame_counter);
+  CHECK(status.queue_free == 2, "%u free slots in an emptied queue", status.queue_free);
+
+  // Clearing the halts resets the endpoints' state, and the next poll reports it immediately
+  endpoint_clear_stall(1);
+  ep1_init();
+  ep2_init();
+  CHECK(remote_status_poll(&status), "No report after endpoint reset");
+  CHECK(status.flags == REMOTE_STATUS_READY, "Flags 0x%x after clearing the halt", status.flags);
+
+  return check_report();
+}
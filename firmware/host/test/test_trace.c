@@ -0,0 +1,96 @@
+/* Check of the timing trace ring buffer in firmware/common/trace.c.
+ * Records are timestamped with the emulated frame timer, and read back with read_trace(), both
+ * in one go and in parts, before and after the ring buffer has wrapped around.
+ */
+#include "host/check.h"
+#include "host/frame_timer_mock.h"
+
+#include "trace.h"
+
+#include <string.h>
+
+static uint8_t readout[TRACE_READOUT_SIZE];
+
+static struct trace_header_t read_header() {
+  struct trace_header_t header;
+  memcpy(&header, readout, sizeof(header));
+  return header;
+}
+
+static uint32_t read_record(unsigned int index) {
+  uint32_t record;
+  memcpy(&record, readout + sizeof(struct trace_header_t) + index*sizeof(uint32_t), sizeof(record));
+  return record;
+}
+
+// Record an event at every step counts, starting at first_timestamp
+static void record_events(uint32_t count, uint32_t step) {
+  for (uint32_t i = 0; i < count; ++i) {
+    trace_record((i % TRACE_POINT_COUNT) | (i & 1 ? TRACE_END_FLAG : 0));
+    frame_timer_mock_advance(step);
+  }
+}
+
+// Check count records of record_events(), starting from the first-th event
+static void check_records(unsigned int count, uint32_t first, uint32_t step, uint32_t start) {
+  for (unsigned int i = 0; i < count; ++i) {
+    const uint32_t event = first + i;
+    const uint32_t expected = ((start + event*step) & ((UINT32_C(1) << TRACE_TIMESTAMP_BITS) - 1))
+      | ((event % TRACE_POINT_COUNT) | (event & 1 ? TRACE_END_FLAG : 0)) << TRACE_TIMESTAMP_BITS;
+    const uint32_t record = read_record(i);
+    CHECK(record == expected, "Record %u of event %u: %#x, expected %#x", i, event, record, expected);
+  }
+}
+
+int main() {
+  frame_timer_mock_configure(-1, UINT32_MAX - 1);
+  init_frame_timer_backend(NULL);
+
+  // Too small for the header
+  CHECK(read_trace(readout, sizeof(struct trace_header_t) - 1, true) == 0, "Short read copied data");
+
+  // Empty buffer
+  CHECK(
+      read_trace(readout, sizeof(readout), false) == sizeof(struct trace_header_t)
+    , "Empty read copied records"
+  );
+  struct trace_header_t header = read_header();
+  CHECK(header.timestamp_frequency == TRACE_TIMESTAMP_FREQUENCY, "Wrong timestamp frequency");
+  CHECK(header.record_count == 0 && header.records_lost == 0, "Empty buffer not empty");
+
+  // A few records, read without clearing, and then with clearing
+  uint32_t start = (uint32_t) frame_timer_mock_total_counts();
+  record_events(5, 1000);
+  for (unsigned int pass = 0; pass < 2; ++pass) {
+    const uint16_t length = read_trace(readout, sizeof(readout), pass == 1);
+    header = read_header();
+    CHECK(length == sizeof(header) + 5*sizeof(uint32_t), "Read %u bytes of 5 records", length);
+    CHECK(header.record_count == 5 && header.records_lost == 0, "Wrong header of 5 records");
+    check_records(5, 0, 1000, start);
+  }
+  read_trace(readout, sizeof(readout), true);
+  CHECK(read_header().record_count == 0, "Records not cleared");
+
+  // Wrap the buffer, and the timestamps, then read the newest records in parts
+  const uint32_t lost = 100;
+  const uint32_t step = (UINT32_C(1) << TRACE_TIMESTAMP_BITS)/300 + 1;
+  start = (uint32_t) frame_timer_mock_total_counts();
+  record_events(TRACE_BUFFER_LENGTH + lost, step);
+  const unsigned int part = 30;
+  unsigned int total = 0;
+  for (unsigned int reads = 0; reads < TRACE_BUFFER_LENGTH; ++reads) {
+    const uint16_t length = read_trace(readout, sizeof(header) + part*sizeof(uint32_t) + 3, true);
+    header = read_header();
+    CHECK(length == sizeof(header) + header.record_count*sizeof(uint32_t), "Wrong read length");
+    CHECK(header.records_lost == (reads == 0 ? lost : 0), "Read %u: %u lost", reads, header.records_lost);
+    CHECK(header.record_count <= part, "Read %u: too many records", reads);
+    check_records(header.record_count, lost + total, step, start);
+    total += header.record_count;
+    if (header.record_count == 0) {
+      break;
+    }
+  }
+  CHECK(total == TRACE_BUFFER_LENGTH, "Read %u records, expected %u", total, TRACE_BUFFER_LENGTH);
+
+  return check_report();
+}
@@ -0,0 +1,101 @@
+/* Check of the ATmega32u4's trace timestamps, in firmware/icetop-atmega32u4/src/frame_timer_backend.c.
+ * The test takes the role of Timer1, and runs it for enough periods to wrap the 24 bit timestamps,
+ * with period corrections applied by the timer callback. Timestamps are also taken while the
+ * roll-over interrupt is still pending.
+ */
+#include "host/check.h"
+
+#include <avr/io.h>
+#include "frame_timer_backend.h"
+#include "trace.h"
+
+#define TIMESTAMP_MASK ((UINT32_C(1) << TRACE_TIMESTAMP_BITS) - 1)
+
+void TIMER1_COMPA_vect(void);
+
+// TOP value in use by the counter, OCR1A is only loaded at a roll-over
+static uint16_t top;
+// Counts since the timer was started
+static uint64_t total_counts;
+static unsigned int periods;
+
+// Change the period length now and then, like the frame timer's corrections
+static void timer_callback() {
+  ++periods;
+  if (periods % 7 == 0) {
+    correct_counts_max((periods % 14) ? 37 : -37);
+  }
+}
+
+// Advance the counter, without servicing the roll-over interrupt
+static void advance(uint32_t counts) {
+  const uint32_t remaining = (uint32_t) top + 1 - TCNT1;
+  if (counts < remaining) {
+    TCNT1 += counts;
+  }
+  else {
+    CHECK(!(TIFR1 & _BV(OCF1A)), "Roll-over with an interrupt pending");
+    TCNT1 = counts - remaining;
+    top = OCR1A;
+    TIFR1 |= _BV(OCF1A);
+  }
+  total_counts += counts;
+}
+
+static void service_interrupt() {
+  if (TIFR1 & _BV(OCF1A)) {
+    TIFR1 &= ~_BV(OCF1A);
+    TIMER1_COMPA_vect();
+  }
+}
+
+static uint32_t last_timestamp;
+static uint64_t last_total_counts;
+
+// Check the timestamp, and its difference with the previous one as decoded by the host
+static void check_timestamp(const char* where) {
+  const uint32_t timestamp = get_trace_timestamp() & TIMESTAMP_MASK;
+  CHECK(
+      timestamp == (total_counts & TIMESTAMP_MASK)
+    , "Period %u %s: timestamp %#x, expected %#x"
+    , periods, where, timestamp, (uint32_t) (total_counts & TIMESTAMP_MASK)
+  );
+  const int32_t diff = (int32_t) ((timestamp - last_timestamp) << (32 - TRACE_TIMESTAMP_BITS))
+    >> (32 - TRACE_TIMESTAMP_BITS);
+  CHECK(
+      diff == (int32_t) (total_counts - last_total_counts)
+    , "Period %u %s: difference %d, expected %d"
+    , periods, where, diff, (int32_t) (total_counts - last_total_counts)
+  );
+  last_timestamp = timestamp;
+  last_total_counts = total_counts;
+}
+
+int main() {
+  init_frame_timer_backend(timer_callback);
+  top = OCR1A;
+  check_timestamp("start");
+
+  // More than 256 periods, and more than 2^24 counts
+  const unsigned int period_count = 2000;
+  for (unsigned int period = 0; period < period_count; ++period) {
+    const uint32_t length = (uint32_t) top + 1;
+    advance(length/2);
+    check_timestamp("middle");
+    advance(length - length/2 - 1);
+    check_timestamp("top");
+
+    // Roll-over with the interrupt pending, e.g. in another interrupt handler
+    advance(1);
+    check_timestamp("roll-over pending");
+    advance(3);
+    check_timestamp("pending");
+    service_interrupt();
+    check_timestamp("serviced");
+  }
+
+  CHECK(periods == period_count, "%u timer interrupts, expected %u", periods, period_count);
+  CHECK(total_counts > TIMESTAMP_MASK, "Timestamps did not wrap");
+
+  return check_report();
+}
@@ -53,9 +53,11 @@ class SegmentConfiguration:
   # {led_type, color_order, string_start, string_stop, has_deepcore, reverse_first_strip_segment}
   __OFFSET_CONFIG = 0x20
   __CONFIG = struct.Struct("<BBBB??")
-  # 4×(1+8) bytes string-to-strip mapping
+  # 4×(1+8) bytes string-to-strip mapping, or 2×(1+16) bytes for firmware with two port banks
   __OFFSET_PORT_MAP = 0x30
-  __PORT_MAP = struct.Struct("<B8sB8sB8sB8s")
+  __PORT_BANK_SIZE = 8
+  __MAX_PORT_BANKS = 2
+  __MAX_SEGMENTS = 4
   # group identifier: binary encoded MD5 hash
   __OFFSET_GROUP_ID = 0x60
   __GROUP_ID = struct.Struct("<16s")
@@ -73,6 +75,13 @@ class SegmentConfiguration:
 
     self.__other_serials = other_serials
 
+    # Must match the PORT_BANKS option of the firmware
+    self.port_banks = int(self.led_config.get('port_banks', 1))
+    if self.port_banks < 1 or self.port_banks > self.__MAX_PORT_BANKS:
+      raise ValueError("Invalid number of port banks: {}".format(self.port_banks))
+    self.port_count = self.__PORT_BANK_SIZE*self.port_banks
+    self.segment_count = self.__MAX_SEGMENTS // self.port_banks
+
     if not self.validate_string_config():
       raise ValueError("Invalid string configuration")
 
@@ -111,7 +120,7 @@ class SegmentConfiguration:
 
     port_map_data = list()
     # Convert from {port : string} mapping to {strip segment : string} mapping
-    for segment in range(4):
+    for segment in range(self.segment_count):
       # Determine number of ports with the current segment count by starting at the last
       # port and counting back until the number of segments on this port is at least the
       # current segment depth
@@ -121,13 +130,14 @@ class SegmentConfiguration:
 
       port_map_data.append(port_count)
 
-      segment_map = bytearray(8)
+      segment_map = bytearray(self.port_count)
       for port in range(port_count):
         segment_map[port] = buffer_offset_map[self.string_config[port][segment]]
 
       port_map_data.append(bytes(segment_map))
 
-    return self.__PORT_MAP.pack(*port_map_data)
+    port_map = struct.Struct("<" + "B{}s".format(self.port_count)*self.segment_count)
+    return port_map.pack(*port_map_data)
 
   def __pack_group_id(self):
     serials = {self.serial}
@@ -174,6 +184,15 @@ class SegmentConfiguration:
     self.__update_eeprom(controller, self.__OFFSET_PORT_MAP, self.__pack_port_map())
 
   def validate_string_config(self):
+    if len(self.string_config) > self.port_count:
+      msg = "String mapping invalid: more than {} ports".format(self.port_count)
+      logger.error(msg)
+      return False
+    if any(len(port) > self.segment_count for port in self.string_config):
+      msg = "String mapping invalid: more than {} strings on a port".format(self.segment_count)
+      logger.error(msg)
+      return False
+
     strings_set = set(self._string_list_sorted)
     if len(strings_set) != len(self._string_list_sorted):
       msg = "String mapping invalid: at least one string index used more than once"
@@ -0,0 +1,35 @@
+#ifndef DISPLAY_REFRESH_H
+#define DISPLAY_REFRESH_H
+
+/** \file
+  * \brief LED refreshes in between the display frames.
+  * \details When built with `DITHERING`, frames have 16 bit colors, of which only the 8 most
+  *   significant bits can be written to the LEDs. The display driver then writes every frame
+  *   ::DISPLAY_REFRESH_RATIO times per frame interval, on a second PIT channel started by
+  *   display_frame(). Every refresh is converted again from the dithering state, see
+  *   load_dither_frame(), so the remaining bits are shown as the average over a number of
+  *   refreshes. The last frame keeps being refreshed until the next frame is displayed.
+  *
+  *   When built with `INTERPOLATION` instead, the refreshes show a weighted average of the last
+  *   two displayed frames, see load_interpolated_frame(). The weight of the newest frame grows
+  *   with every refresh period since display_frame(), until only the newest frame is shown.
+  *
+  *   The refreshes are converted in the main loop, like the frames themselves, and are skipped
+  *   if the previous one is still waiting to be written.
+  * \author Sander Vanheule (Universiteit Gent)
+  */
+
+#include <stdbool.h>
+
+#ifdef __DOXYGEN__
+/// Number of LED refreshes per frame interval, at least 1. Supplied as a compiler flag.
+#define DISPLAY_REFRESH_RATIO
+#endif
+
+/// Whether the LEDs should be refreshed with the last displayed frames.
+bool should_refresh_display();
+
+/// Convert and write the next refresh of the last displayed frames.
+void refresh_display();
+
+#endif // DISPLAY_REFRESH_H
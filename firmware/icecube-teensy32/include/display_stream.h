@@ -0,0 +1,31 @@
+#ifndef DISPLAY_STREAM_H
+#define DISPLAY_STREAM_H
+
+/** \file
+  * \brief Conversion of remote frames to port data while they are received.
+  * \details Normally, a frame received over USB is only converted to port data by
+  *   display_frame(), at the frame timer tick on which it is drawn.
+  *   When built with `STREAM_ENCODING`, the USB interrupt instead converts every LED position
+  *   as soon as its data has been received for all ports, so the port data is ready when the
+  *   last packet of the frame arrives and display_frame() only has to start the DMA transfer.
+  *
+  *   Since the conversion is done on top of the port data of the previous frame, a frame is only
+  *   streamed if the previous frame has been written to the LEDs, and no other frame is waiting
+  *   in the frame queue. Otherwise the frame is converted by display_frame() as usual.
+  * \author Sander Vanheule (Universiteit Gent)
+  */
+
+#include <stddef.h>
+#include "frame_buffer.h"
+
+/// Call when the first data of \a frame is received, before display_stream_update().
+void display_stream_start(struct frame_buffer_t* frame);
+
+/** \brief Convert the newly received data of \a frame.
+  * \details Sets ::FRAME_ENCODED on \a frame when the whole frame has been converted.
+  * \param frame Frame that is being received.
+  * \param received Number of bytes of the frame buffer that have been received so far.
+  */
+void display_stream_update(struct frame_buffer_t* frame, size_t received);
+
+#endif // DISPLAY_STREAM_H
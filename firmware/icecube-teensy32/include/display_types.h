@@ -17,4 +17,27 @@ struct led_t {
   uint8_t blue; ///< 8 bit blue component.
 } __attribute__((packed));
 
+/** \brief LED data with 16 bit colors, as received by displays built with `DITHERING`.
+  * \details Every color is stored little-endian. The 8 most significant bits are the value
+  *   written to the LED, the 8 least significant bits are shown by temporal dithering.
+  * \ingroup led_display
+  */
+struct led16_t {
+  uint16_t red; ///< 16 bit red component.
+  uint16_t green; ///< 16 bit green component.
+  uint16_t blue; ///< 16 bit blue component.
+} __attribute__((packed));
+
+/** \brief LED data of displays built for APA102 compatible LEDs, with `LED_TYPE` set to `APA102`.
+  * \details The 24-bit RGB values can be scaled using the brightness field to achieve
+  *   a larger dynamic range, e.g. to perform gamma correction.
+  * \ingroup led_display
+  */
+struct led_apa102_t {
+  uint8_t brightness; ///< Global brightness bits; only 5 LSB are valid.
+  uint8_t red; ///< 8 bit red component.
+  uint8_t green; ///< 8 bit green component.
+  uint8_t blue; ///< 8 bit blue component.
+} __attribute__((packed));
+
 #endif //DISPLAY_TYPES_H
@@ -7,7 +7,7 @@
 
 /// Maximum number of valid endpoints
 /// Functions requiring an endpoint number should only use values smaller than ::MAX_ENDPOINTS.
-#define MAX_ENDPOINTS 2
+#define MAX_ENDPOINTS 3
 
 #define BDT_DESC_BC0 16
 #define BDT_DESC_OWN 7
@@ -0,0 +1,212 @@
+#ifndef PORT_ENCODER_H
+#define PORT_ENCODER_H
+
+/** \file
+  * \brief Conversion of frame buffer data to parallel WS2811 port data.
+  * \details The display driver writes 8 LED strips simultaneously using one byte of GPIO port D.
+  *   Every byte that is written to the port by the DMA engine therefore contains one bit of
+  *   data for each of the 8 strips.
+  *   When built with two port banks, 16 strips are written using one byte of GPIO port D and
+  *   one byte of GPIO port C. The port data of the second bank, i.e. ports 8 to 15, then follows
+  *   the port data of the first bank, and is written to port C at the same time.
+  *   The frame buffer contents, stored in OM-key order, are gathered per strip and transposed
+  *   into this bit-parallel format (also used by the OctoWS2811 library) by encode_frame().
+  *
+  *   The encoder can keep a copy of the frame data it last converted. encode_frame_changes() then
+  *   only gathers and transposes the 8-port blocks, i.e. one LED position of a strip segment,
+  *   of which the data has changed. The other blocks of the previous port data are reused.
+  *
+  *   A frame can also be converted while it is being received, by calling encode_stream_start()
+  *   at the start of the frame and encode_stream_update() every time more data has arrived.
+  *   The port data is then ready almost immediately after the last data is received.
+  *
+  *   Frames can be converted alternately into multiple port data buffers, so a frame can be
+  *   prepared while the previous one is still being written to the LEDs. For every buffer, the
+  *   encoder tracks which LED positions are out of date with respect to the last converted frame,
+  *   so these are converted again together with the changed positions.
+  *
+  *   Every color byte can be mapped through a color correction table while it is gathered, see
+  *   \ref led_display_color_lut.
+  *
+  *   Frames with 16 bit colors are shown by temporal dithering instead. load_dither_frame()
+  *   gathers such a frame into a dithering state in port data order, after which every call to
+  *   encode_dither_refresh() produces the port data of one LED refresh. The 8 most significant
+  *   bits of every color are written as is, or incremented by one when the error accumulated for
+  *   that color over the previous refreshes overflows. Averaged over successive refreshes, the
+  *   LEDs then show the remaining 8 bits as well.
+  *
+  *   Similarly, frames can be interpolated when the LEDs are refreshed more often than frames are
+  *   drawn. load_interpolated_frame() stores the colors of a new frame next to those of the
+  *   previous one, and encode_interpolated_refresh() converts a weighted average of both, mapped
+  *   through the color correction tables if there are any.
+  *
+  *   This conversion is independent of the microcontroller hardware, so it can also be built and
+  *   verified on a PC.
+  * \author Sander Vanheule (Universiteit Gent)
+  */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "display_properties.h"
+#include "display_types.h"
+
+#ifndef PORT_BANK_COUNT
+/// Number of GPIO port bytes the LED strips are connected to, 1 or 2. Supplied as a compiler flag.
+#define PORT_BANK_COUNT 1
+#endif
+/// Number of LED strips connected to one GPIO port byte.
+#define PORT_BANK_SIZE 8
+
+/// Number of LEDs (DOMs) per IceCube string.
+#define STRING_LENGTH 60
+/// Maximum number of strip segments (i.e. strings) connected in series to a single port.
+#define SEGMENT_COUNT (4/PORT_BANK_COUNT)
+/// Maximum number of LEDs connected to a single port.
+#define STRIP_LENGTH (STRING_LENGTH*SEGMENT_COUNT)
+
+/// Size in bytes of the frame buffer data of a single string.
+#define STRING_SIZE (STRING_LENGTH*sizeof(struct led_t))
+/// Number of strings of which changes are tracked, strings beyond are always converted again.
+#define MAX_TRACKED_STRING_COUNT 64
+/// Size in bytes of the copy of the last converted frame data.
+#define ENCODED_SOURCE_SIZE (MAX_TRACKED_STRING_COUNT*STRING_SIZE)
+
+/// Number of LED strips that can be driven in parallel.
+#define MAX_PORT_COUNT (PORT_BANK_SIZE*PORT_BANK_COUNT)
+
+/// Size in bytes of the encoded port data of a single frame.
+#define LED_DATA_SIZE (MAX_PORT_COUNT*STRIP_LENGTH*sizeof(struct led_t))
+/// Size in bytes of the encoded port data of a single port bank.
+#define PORT_BANK_DATA_SIZE (LED_DATA_SIZE/PORT_BANK_COUNT)
+/// Maximum number of port data buffers the encoder can alternate between.
+#define MAX_PORT_DATA_BUFFERS 2
+
+/// Size in bytes of a 16 bit color frame string, see ::led16_t.
+#define STRING_SIZE_16 (STRING_LENGTH*sizeof(struct led16_t))
+/// Size in bytes of the dithering state: the 8 most and least significant bits of every color,
+/// and its accumulated error.
+#define DITHER_STATE_SIZE (3*LED_DATA_SIZE)
+/// Size in bytes of the interpolation state: the colors of the last two loaded frames.
+#define INTERPOLATION_STATE_SIZE (2*LED_DATA_SIZE)
+/// Interpolation weight at which only the last loaded frame is shown.
+#define INTERPOLATION_WEIGHT_MAX 256
+
+/** \brief LED strip to buffer offset mapping of one strip segment.
+  * \details Strip segment `s` of port `p` shows the string with index `ports[p]` in the frame
+  *   buffer, i.e. buffer offset `ports[p]*STRING_LENGTH*sizeof(struct led_t)`.
+  *   Only the first `ports_length` ports are used.
+  */
+struct port_map_t {
+  uint8_t ports_length; ///< Number of used ports for this strip segment.
+  uint8_t ports[MAX_PORT_COUNT]; ///< String index in the frame buffer for every port.
+};
+
+/** \brief Configure the frame buffer to port data conversion.
+  * \param color_order Order in which the LED colour components are written.
+  * \param color_lut Color correction tables of size ::COLOR_LUT_SIZE, ordered by
+  *   ::color_lut_channel_t, or NULL to write the frame data unchanged.
+  *   The tables are not copied, so they must remain valid and unchanged until the encoder is
+  *   initialised again.
+  * \param reverse_first Whether the first strip segment of every port runs reversed.
+  *   Subsequent segments alternate direction.
+  * \param port_map Array of ::SEGMENT_COUNT strip segment mappings.
+  *   Mappings with an invalid port count are treated as unused.
+  *   The mapping is copied, so \a port_map does not have to remain valid.
+  * \param encoded_source Storage of size ::ENCODED_SOURCE_SIZE for a copy of the last converted
+  *   frame data, or NULL to always convert full frames.
+  * \param port_data Array of \a port_data_count port data buffers, each of size ::LED_DATA_SIZE.
+  * \param port_data_count Number of port data buffers, at most ::MAX_PORT_DATA_BUFFERS.
+  */
+void init_port_encoder(
+    enum display_led_color_order_t color_order
+  , const uint8_t* color_lut
+  , bool reverse_first
+  , const struct port_map_t* port_map
+  , uint8_t* encoded_source
+  , uint8_t* const* port_data
+  , unsigned int port_data_count
+);
+
+/** \brief Convert a frame buffer into port data.
+  * \details Strip segments are written consecutively to \a dest, until the first strip segment
+  *   without any used ports. Data of the remaining strip segments is left untouched, as is the
+  *   data of a segment's port bank without any used ports.
+  *   Bits corresponding to other unused ports are always written as zeros.
+  * \param src Frame buffer data, of size get_frame_buffer_size().
+  * \param buffer Index of the port data buffer to write to.
+  */
+void encode_frame(const uint8_t* restrict src, unsigned int buffer);
+
+/** \brief Update the port data of the last converted frame to a new frame.
+  * \details Every string is compared to the previous frame, and only the LED positions that
+  *   differ are converted again.
+  *   If there is no previous frame, e.g. after init_port_encoder(), the full frame is converted.
+  *   LED positions of which \a buffer still holds older data are converted as well.
+  * \param src Frame buffer data, of size get_frame_buffer_size().
+  * \param buffer Index of the port data buffer to write to.
+  */
+void encode_frame_changes(const uint8_t* restrict src, unsigned int buffer);
+
+/** \brief Start converting a new frame while it is being received.
+  * \details The frame is converted on top of the port data of the last converted frame, so no
+  *   other frame may be converted until the stream is complete. A frame that is converted
+  *   with encode_frame() or encode_frame_changes() in the mean time ends the stream, and the
+  *   remainder of the streamed frame should then be discarded.
+  * \param buffer Index of the port data buffer to write to.
+  */
+void encode_stream_start(unsigned int buffer);
+
+/** \brief Convert the LED positions of which the data has been received for all ports.
+  * \details Frame data is received in buffer order, i.e. in order of increasing string index.
+  *   LED positions that are the same as in the previous frame are not converted again.
+  *   Strings that are shown on more than one port are always converted.
+  * \param src Frame buffer data, of size get_frame_buffer_size().
+  * \param received Number of bytes of \a src that have been received.
+  * \returns `true` when the whole frame has been converted.
+  */
+bool encode_stream_update(const uint8_t* src, size_t received);
+
+/** \brief Prepare temporal dithering of 16 bit color frames.
+  * \details Uses the gather plan of the last call to init_port_encoder(), so this has to be called
+  *   again after every call to init_port_encoder().
+  *   All LEDs are dark until a frame is loaded with load_dither_frame().
+  * \param dither_state 4-byte aligned storage of size ::DITHER_STATE_SIZE.
+  */
+void init_port_dither(uint8_t* dither_state);
+
+/** \brief Load a new frame to dither.
+  * \details The accumulated errors are kept, so the residuals of the previous frame are carried
+  *   over into the next refreshes.
+  * \param src Frame buffer data of ::led16_t colors, with ::STRING_SIZE_16 bytes per string.
+  */
+void load_dither_frame(const uint8_t* restrict src);
+
+/** \brief Convert the loaded frame into the port data of the next LED refresh.
+  * \param buffer Index of the port data buffer to write to.
+  */
+void encode_dither_refresh(unsigned int buffer);
+
+/** \brief Prepare interpolation between frames.
+  * \details Uses the gather plan and color correction tables of the last call to
+  *   init_port_encoder(), so this has to be called again after every call to init_port_encoder().
+  *   Both the previous and the current frame are dark until frames are loaded.
+  * \param interpolation_state 4-byte aligned storage of size ::INTERPOLATION_STATE_SIZE.
+  */
+void init_port_interpolation(uint8_t* interpolation_state);
+
+/** \brief Load a new frame to interpolate towards.
+  * \details The frame that was loaded before becomes the frame that is interpolated from.
+  * \param src Frame buffer data, of size get_frame_buffer_size().
+  */
+void load_interpolated_frame(const uint8_t* restrict src);
+
+/** \brief Convert a weighted average of the last two loaded frames into port data.
+  * \param weight Weight of the last loaded frame, from 0 to ::INTERPOLATION_WEIGHT_MAX.
+  *   The previous frame has weight `INTERPOLATION_WEIGHT_MAX - weight`.
+  * \param buffer Index of the port data buffer to write to.
+  */
+void encode_interpolated_refresh(unsigned int weight, unsigned int buffer);
+
+#endif // PORT_ENCODER_H
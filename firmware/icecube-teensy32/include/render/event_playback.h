@@ -0,0 +1,90 @@
+#ifndef RENDER_EVENT_PLAYBACK_H
+#define RENDER_EVENT_PLAYBACK_H
+
+/** \file
+  * \brief Time lapse playback of an uploaded event.
+  * \author Sander Vanheule (Universiteit Gent)
+  */
+
+#include "render/renderer.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/** \defgroup led_display_event_playback Event playback
+  * \ingroup led_display_renderer
+  * \brief Render the time lapse of an event on the device.
+  * \details An event is shown as a time lapse of its pulses, so streaming it from the host takes
+  *   a full frame every frame interval. Instead, the host can upload the event's pulses once
+  *   with ::VENDOR_REQUEST_EVENT_PULSES, and start the time lapse with
+  *   ::VENDOR_REQUEST_EVENT_PLAYBACK. The device then renders the frames itself at ::DEVICE_FPS,
+  *   independent of the host's scheduling.
+  *
+  *   Every pulse lights up a single LED, starting at event_pulse_t::frame. Its brightness rises
+  *   linearly over event_playback_t::rise_frames to the pulse's peak brightness, after which it
+  *   decays linearly over event_playback_t::decay_frames. Without decay, the pulse stays lit until
+  *   the end of the playback. Pulses on the same LED are added. Pulses must be sorted by their
+  *   start frame.
+  *
+  *   Event playback is only available if the firmware is built with `EVENT_PLAYBACK` enabled,
+  *   since the pulses take up RAM otherwise used by the frame buffers. Devices without event
+  *   playback don't report ::DP_EVENT_PULSE_CAPACITY.
+  *
+  *   Playback starts when the device is connected, and ends when it is stopped, when new pulses
+  *   are uploaded, or when the device is disconnected. Frames received on EP1 are interleaved
+  *   with the rendered frames, so the host should stop the playback before sending frames.
+  * @{
+  */
+
+#ifndef EVENT_PULSE_CAPACITY
+/// Number of pulses that can be uploaded, reported by ::DP_EVENT_PULSE_CAPACITY.
+#define EVENT_PULSE_CAPACITY 1024
+#endif
+
+/// A single pulse of an event, as uploaded by the host.
+struct event_pulse_t {
+  uint16_t frame; ///< Frame number, relative to the start of the playback, when the pulse starts.
+  uint16_t led; ///< Index of the LED in the frame buffer.
+  uint8_t color[3]; ///< Red, green, and blue value of the pulse's color.
+  uint8_t brightness; ///< Peak brightness, e.g. the compressed charge of the pulse.
+} __attribute__((packed));
+
+/// Flags of event_playback_t::flags
+enum event_playback_flags_t {
+  /// Restart the playback after event_playback_t::duration frames, instead of showing the last
+  /// frame until the playback is stopped.
+  EVENT_PLAYBACK_LOOP = 1
+};
+
+/// Playback settings, as sent by the host to start the playback.
+struct event_playback_t {
+  uint16_t pulse_count; ///< Number of uploaded pulses that are played.
+  uint16_t duration; ///< Number of frames of the playback.
+  uint8_t rise_frames; ///< Number of frames over which a pulse reaches its peak brightness, at least 1.
+  uint8_t decay_frames; ///< Number of frames over which a pulse fades out, or 0 to keep it lit.
+  uint8_t flags; ///< Combination of ::event_playback_flags_t.
+  uint8_t reserved; ///< Should be 0.
+} __attribute__((packed));
+
+/** \brief Return the pulse storage for an upload of \a count pulses, starting at pulse \a first.
+  * \details Any playback is stopped, since the pulses are overwritten.
+  * \returns `NULL` if the pulses don't fit in the storage.
+  */
+struct event_pulse_t* get_event_pulse_upload(uint16_t first, uint16_t count);
+
+/** \brief Start, or restart, the playback of the uploaded pulses.
+  * \returns `false` if \a playback refers to more pulses than available.
+  */
+bool start_event_playback(const struct event_playback_t* playback);
+
+/// Stop the playback. The display is blanked once the renderer is stopped.
+void stop_event_playback();
+
+/// Whether a playback was started, and hasn't been stopped since.
+bool is_event_playback_enabled();
+
+/// Renderer that plays back the uploaded pulses while playback is enabled.
+const struct renderer_t* get_event_playback_renderer();
+
+/// @}
+
+#endif // RENDER_EVENT_PLAYBACK_H
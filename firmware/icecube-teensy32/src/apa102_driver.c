@@ -0,0 +1,337 @@
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+
+#include "kinetis/io.h"
+#include "kinetis/dma.h"
+#include <avr/eeprom.h>
+#include <util/atomic.h>
+
+#include "display_driver.h"
+#include "display_properties.h"
+#include "device_properties.h"
+#include "display_types.h"
+#include "port_encoder.h"
+#include "color_lut.h"
+#include "telemetry.h"
+#include "trace.h"
+
+/* APA102 and SK9822 LEDs are clocked, so a single chain of LEDs can be written with hardware SPI,
+ * at many times the WS2811 bit rate. SPI0 is used as master, with a DMA channel pushing the LED
+ * data into its transmit FIFO. The clock and data lines use pins D1 (Teensy pin 14) and
+ * D2 (pin 7), which are ports 1 and 2 of the OctoWS2811 adaptor, so the USB activity LED on C5
+ * remains available.
+ *
+ * The EEPROM port map is reused to describe the LED chain: the strips of every port are
+ * connected in series as with the WS2811 strips, and the ports themselves are chained in port
+ * order.
+ */
+
+// LED layout stored in EEPROM
+#define PORTMAP __attribute__((section(".portmap"),used))
+static const struct port_map_t LED_MAP[SEGMENT_COUNT] PORTMAP;
+
+/* # APA102C/SK9822
+ * Transmit bytes with MSB first
+ * Data frame
+ * * frame start: 4 bytes 0x00
+ * * led data: (111X:XXXX BBBB:BBBB GGGG:GGGG RRRR:RRRR)
+ *   * '111' header + 5 bits global brightness
+ *   * blue, green, red (default order)
+ * * frame end: 4 bytes 0x00, which the SK9822 requires to latch the new data,
+ *   followed by ceil(n/2) clock edges to push the data through the APA102 chain
+ */
+#define LED_HEADER 0xE0
+#define FRAME_START_SIZE 4
+#define FRAME_END_SIZE(led_count) (4 + ((led_count)+15)/16)
+#define MAX_CHAIN_LENGTH (MAX_PORT_COUNT*STRIP_LENGTH)
+#define SPI_DATA_SIZE ( \
+  FRAME_START_SIZE + sizeof(uint32_t)*MAX_CHAIN_LENGTH + FRAME_END_SIZE(MAX_CHAIN_LENGTH) \
+)
+
+// SPI clock: F_BUS/(PBR*BR), with a baud rate prescaler PBR of 2 or 3, and a scaler BR of 2-8
+#ifndef F_SPI_LED
+#define F_SPI_LED 12000000UL
+#endif
+#define SPI_CLOCK_DIVIDER (F_BUS/F_SPI_LED)
+#define SPI_PBR_VALUE ((SPI_CLOCK_DIVIDER % 3) == 0 ? 3 : 2)
+#define SPI_BR_VALUE (SPI_CLOCK_DIVIDER/SPI_PBR_VALUE)
+#if (F_BUS % F_SPI_LED) != 0 || SPI_PBR_VALUE*SPI_BR_VALUE != SPI_CLOCK_DIVIDER \
+  || SPI_BR_VALUE < 2 || SPI_BR_VALUE > 8 || (SPI_BR_VALUE % 2) != 0
+#error "F_SPI_LED must be F_BUS divided by 4, 6, 8, 12, 16, 18 or 24"
+#endif
+
+// DMA request source of the SPI0 transmit FIFO
+#define DMAMUX_SOURCE_SPI0_TX 17
+
+// A run of LEDs in the chain: one strip segment, written from a single string of the frame
+struct chain_run_t {
+  uint16_t first_offset; ///< Frame buffer offset of the LED written first
+  int8_t step; ///< Frame buffer offset to the next LED, negative for reversed strips
+  bool valid; ///< Whether the string is part of the frame buffer, otherwise it is blanked
+};
+
+static struct chain_run_t chain_runs[MAX_PORT_COUNT*SEGMENT_COUNT];
+static unsigned int chain_run_count;
+// Number of LEDs in the chain
+static unsigned int chain_length;
+// Number of bytes written per frame, including the start and end frames
+static unsigned int frame_data_size;
+
+// Offsets in struct led_apa102_t of the colors, in transmission order
+static uint8_t color_offsets[3];
+// Color correction table of every transmitted color, or NULL if colors are written as is
+static const uint8_t* color_luts[3];
+
+// SPI data is converted into one buffer while the other one is written to the LEDs
+#define DISPMEM __attribute__ ((section(".displaybuffer")))
+#define SPI_DATA_BUFFERS 2
+static alignas(4) uint8_t spi_data[SPI_DATA_BUFFERS][SPI_DATA_SIZE] DISPMEM;
+
+// Buffer that is being, or was last, written to the LEDs
+static volatile uint8_t front_buffer;
+// Set while the other buffer is being converted, or waiting to be written
+static volatile atomic_flag back_buffer_busy;
+// Set when the other buffer should be written after the current transfer
+static volatile bool back_buffer_ready;
+// Set while the DMA engine is writing to the LEDs
+static volatile atomic_flag frame_write_in_progress;
+
+// Set when the port map, color order, strip orientation, or color correction may have changed
+static volatile bool configuration_changed;
+
+// Colors in transmission order for every ::display_led_color_order_t
+static const uint8_t COLOR_ORDER_CHANNELS[][3] = {
+    [LED_ORDER_RGB] = {COLOR_LUT_RED, COLOR_LUT_GREEN, COLOR_LUT_BLUE}
+  , [LED_ORDER_BRG] = {COLOR_LUT_BLUE, COLOR_LUT_RED, COLOR_LUT_GREEN}
+  , [LED_ORDER_GBR] = {COLOR_LUT_GREEN, COLOR_LUT_BLUE, COLOR_LUT_RED}
+  , [LED_ORDER_BGR] = {COLOR_LUT_BLUE, COLOR_LUT_GREEN, COLOR_LUT_RED}
+  , [LED_ORDER_RBG] = {COLOR_LUT_RED, COLOR_LUT_BLUE, COLOR_LUT_GREEN}
+  , [LED_ORDER_GRB] = {COLOR_LUT_GREEN, COLOR_LUT_RED, COLOR_LUT_BLUE}
+};
+
+// Read the LED layout, color order and color correction, and compile the chain of LED runs
+static void init_chain() {
+  struct port_map_t port_map[SEGMENT_COUNT];
+  eeprom_read_block(&port_map, &LED_MAP, sizeof(LED_MAP));
+
+  enum display_led_color_order_t color_order = get_color_order();
+  if ((unsigned int) color_order >= sizeof(COLOR_ORDER_CHANNELS)/sizeof(COLOR_ORDER_CHANNELS[0])) {
+    color_order = LED_ORDER_BGR;
+  }
+  const uint8_t* color_lut = load_color_lut();
+  for (unsigned int color = 0; color < 3; ++color) {
+    const uint8_t channel = COLOR_ORDER_CHANNELS[color_order][color];
+    color_offsets[color] = offsetof(struct led_apa102_t, red) + channel;
+    color_luts[color] = color_lut ? color_lut + COLOR_LUT_LENGTH*channel : NULL;
+  }
+
+  // Segments following a segment without used ports, or with an invalid port count, are not
+  // part of the chain, as with the WS2811 strips.
+  unsigned int segment_count = 0;
+  while (segment_count < SEGMENT_COUNT
+      && port_map[segment_count].ports_length > 0
+      && port_map[segment_count].ports_length <= MAX_PORT_COUNT
+  ) {
+    ++segment_count;
+  }
+
+  const unsigned int string_count = get_led_count()/STRING_LENGTH;
+  const bool reverse_first = get_reverse_first_strip_segment();
+  chain_run_count = 0;
+  for (unsigned int port = 0; port < MAX_PORT_COUNT; ++port) {
+    for (unsigned int segment = 0; segment < segment_count; ++segment) {
+      if (port >= port_map[segment].ports_length) {
+        break;
+      }
+      const uint8_t string = port_map[segment].ports[port];
+      // Reverse even segments if first one is reversed, otherwise reverse odd segments
+      const bool reversed = reverse_first == ((segment % 2) == 0);
+      const size_t first_led = reversed ? STRING_LENGTH-1 : 0;
+
+      struct chain_run_t* run = &chain_runs[chain_run_count++];
+      run->valid = string < string_count;
+      run->first_offset = (STRING_LENGTH*string + first_led)*sizeof(struct led_apa102_t);
+      run->step = reversed ? -(int8_t) sizeof(struct led_apa102_t) : sizeof(struct led_apa102_t);
+    }
+  }
+
+  chain_length = STRING_LENGTH*chain_run_count;
+  frame_data_size = FRAME_START_SIZE + sizeof(uint32_t)*chain_length + FRAME_END_SIZE(chain_length);
+}
+
+// Write the start and end frames to the back buffer, and return where its LED data starts
+static uint32_t* prepare_back_buffer() {
+  uint8_t* data = spi_data[front_buffer ^ 1];
+  for (unsigned int i = 0; i < FRAME_START_SIZE; ++i) {
+    data[i] = 0;
+  }
+  for (unsigned int i = frame_data_size - FRAME_END_SIZE(chain_length); i < frame_data_size; ++i) {
+    data[i] = 0;
+  }
+  return (uint32_t*) &data[FRAME_START_SIZE];
+}
+
+// Write the LEDs of a run as (header, first, second, third) words
+static uint32_t* write_run(uint32_t* output, const uint8_t* frame, const struct chain_run_t* run) {
+  const uint32_t* const end = output + STRING_LENGTH;
+  if (!run->valid) {
+    while (output != end) {
+      *output++ = LED_HEADER;
+    }
+    return output;
+  }
+
+  // Keep the offsets in registers, instead of loading them for every LED
+  const uint8_t* led = frame + run->first_offset;
+  const ptrdiff_t step = run->step;
+  const uint8_t first = color_offsets[0];
+  const uint8_t second = color_offsets[1];
+  const uint8_t third = color_offsets[2];
+  if (color_luts[0]) {
+    const uint8_t* first_lut = color_luts[0];
+    const uint8_t* second_lut = color_luts[1];
+    const uint8_t* third_lut = color_luts[2];
+    for (; output != end; led += step) {
+      *output++ = (LED_HEADER | led[offsetof(struct led_apa102_t, brightness)])
+        | ((uint32_t) first_lut[led[first]] << 8)
+        | ((uint32_t) second_lut[led[second]] << 16)
+        | ((uint32_t) third_lut[led[third]] << 24);
+    }
+  }
+  else {
+    for (; output != end; led += step) {
+      *output++ = (LED_HEADER | led[offsetof(struct led_apa102_t, brightness)])
+        | ((uint32_t) led[first] << 8)
+        | ((uint32_t) led[second] << 16)
+        | ((uint32_t) led[third] << 24);
+    }
+  }
+  return output;
+}
+
+void init_display_driver() {
+  // SPI0 clock on D1, data on D2
+  ATOMIC_REGISTER_BIT_SET(SIM_SCGC5, 12); // Enable port D clock
+  PORTD_PCR1 = PORT_PCR_MUX(2) | PORT_PCR_DSE;
+  PORTD_PCR2 = PORT_PCR_MUX(2) | PORT_PCR_DSE;
+
+  // Master mode with the receive FIFO disabled, since nothing is read back
+  ATOMIC_REGISTER_BIT_SET(SIM_SCGC6, 12); // Enable SPI0 clock
+  SPI0_MCR = SPI_MCR_MSTR | SPI_MCR_DIS_RXF | SPI_MCR_CLR_TXF | SPI_MCR_HALT;
+  // 8 bit frames, MSB first, data sampled on the rising clock edge
+  SPI0_CTAR0 = SPI_CTAR_FMSZ(7)
+    | SPI_CTAR_PBR(SPI_PBR_VALUE == 3 ? 1 : 0)
+    | SPI_CTAR_BR(SPI_BR_VALUE/2 - 1);
+  // Request DMA transfers while the transmit FIFO isn't full
+  SPI0_RSER = SPI_RSER_TFFF_RE | SPI_RSER_TFFF_DIRS;
+  SPI0_MCR = SPI_MCR_MSTR | SPI_MCR_DIS_RXF;
+
+  // Initialise DMA
+  ATOMIC_REGISTER_BIT_SET(SIM_SCGC6, 1); // SIM_SCGC6(1) DMA mux module
+  ATOMIC_REGISTER_BIT_SET(SIM_SCGC7, 1); // SIM_SCGC7(1) DMA module
+
+  DMA_CR = 0;
+  DMA_ERQ = 0;
+  DMA_EEI = 0;
+  clear_channel_tcd(0);
+
+  // Push one byte into the transmit FIFO per request
+  // SADDR and CITER/BITER are set when initiating a frame write
+  dma_tcd_list[0].CSR = _BV(3) | _BV(1);
+  dma_tcd_list[0].SOFF = 1;
+  dma_tcd_list[0].NBYTES = 1;
+  dma_tcd_list[0].DADDR = &SPI0_PUSHR;
+
+  DMAMUX0_CHCFG0 = DMAMUX_SOURCE_SPI0_TX | _BV(7);
+  NVIC_ENABLE_IRQ(IRQ_DMA_CH0);
+
+  configuration_changed = false;
+  init_chain();
+
+  front_buffer = 0;
+  back_buffer_ready = false;
+  atomic_flag_clear(&back_buffer_busy);
+  atomic_flag_clear(&frame_write_in_progress);
+}
+
+// Swap the buffers and write the new front buffer. Called with frame_write_in_progress set.
+static void start_back_buffer_transfer() {
+  front_buffer ^= 1;
+
+  dma_tcd_list[0].SADDR = &(spi_data[front_buffer][0]);
+  dma_tcd_list[0].SLAST = -(int32_t) frame_data_size;
+  dma_tcd_list[0].BITER = frame_data_size;
+  dma_tcd_list[0].CITER = frame_data_size;
+  DMA_ERQ = _BV(0);
+
+  atomic_flag_clear(&back_buffer_busy);
+}
+
+// Write the back buffer now, or when the current transfer has finished
+static void submit_back_buffer() {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if (!atomic_flag_test_and_set(&frame_write_in_progress)) {
+      start_back_buffer_transfer();
+    }
+    else {
+      back_buffer_ready = true;
+    }
+  }
+}
+
+// ISR must be visible to other modules, so don't declare this static
+void dma_ch0_isr() {
+  TRACE_BEGIN(TRACE_DMA_ISR);
+  DMA_CINT = 0;
+  // All data has been pushed into the FIFO, so the front buffer can be reused. The next frame
+  // can follow right away, as the start frame resets the LEDs.
+  if (back_buffer_ready) {
+    back_buffer_ready = false;
+    start_back_buffer_transfer();
+  }
+  else {
+    atomic_flag_clear(&frame_write_in_progress);
+  }
+  TRACE_END(TRACE_DMA_ISR);
+}
+
+void display_frame(struct frame_buffer_t* buffer) {
+  if (!atomic_flag_test_and_set(&back_buffer_busy)) {
+    // The chain is only used with back_buffer_busy set, so it can be safely reconfigured now.
+    // A transfer of the front buffer keeps its own length.
+    if (configuration_changed) {
+      configuration_changed = false;
+      init_chain();
+    }
+
+    ATOMIC_SRAM_BIT_SET(buffer->flags, 2);
+    uint32_t* output = prepare_back_buffer();
+    for (unsigned int run = 0; run < chain_run_count; ++run) {
+      output = write_run(output, buffer->buffer, &chain_runs[run]);
+    }
+    ATOMIC_SRAM_BIT_CLEAR(buffer->flags, 2);
+
+    submit_back_buffer();
+    telemetry_count(TELEMETRY_FRAMES_DRAWN);
+  }
+  else {
+    telemetry_count(TELEMETRY_DRAW_SKIPPED);
+  }
+}
+
+void reload_display_configuration() {
+  configuration_changed = true;
+}
+
+void display_blank() {
+  if (!atomic_flag_test_and_set(&back_buffer_busy)) {
+    uint32_t* output = prepare_back_buffer();
+    const uint32_t* end = output + chain_length;
+    while (output != end) {
+      *output++ = LED_HEADER;
+    }
+    submit_back_buffer();
+  }
+}
@@ -6,58 +6,160 @@
 #include "kinetis/io.h"
 #include "kinetis/ftm.h"
 #include "kinetis/dma.h"
+#include "kinetis/pit.h"
 #include <avr/eeprom.h>
+#include <util/atomic.h>
 
 #include "display_driver.h"
 #include "display_properties.h"
 #include "device_properties.h"
 #include "display_types.h"
+#include "port_encoder.h"
+#include "color_lut.h"
+#include "telemetry.h"
+#include "display_stream.h"
+#include "display_refresh.h"
+#include "frame_queue.h"
+#include "trace.h"
 
 
-// Buffer dimensions
-#define STRING_LENGTH 60
-#define SEGMENT_COUNT 4
-#define STRIP_LENGTH (STRING_LENGTH*SEGMENT_COUNT)
-
-#define MAX_PORT_COUNT 8
-
-#define BUFFER_STEP sizeof(struct led_t)
-#define BUFFER_SIZE (MAX_PORT_COUNT*STRIP_LENGTH*sizeof(struct led_t))
-
-// Color order
-#define OFFSET_RED ((ptrdiff_t) offsetof(struct led_t, red))
-#define OFFSET_GREEN ((ptrdiff_t) offsetof(struct led_t, green))
-#define OFFSET_BLUE ((ptrdiff_t) offsetof(struct led_t, blue))
-
-static ptrdiff_t color_offset_initial;
-static ptrdiff_t delta_0;
-static ptrdiff_t delta_1;
-
-// Strip orientation
-static bool reverse_first_segment;
-
-// LED strip to buffer offset mapping
-struct port_map_t {
-  uint8_t ports_length;
-  uint8_t ports[MAX_PORT_COUNT];
-};
-
 // LED layout stored in EEPROM
 #define PORTMAP __attribute__((section(".portmap"),used))
 static const struct port_map_t LED_MAP[SEGMENT_COUNT] PORTMAP;
 
-static struct port_map_t led_mapping[SEGMENT_COUNT];
-
+// Set while the DMA engine is writing to the LEDs
 static volatile atomic_flag frame_write_in_progress;
 
 // DMA sources
 #define DISPMEM __attribute__ ((section(".displaybuffer")))
 static alignas(4) uint8_t ones DISPMEM;
-static alignas(4) uint8_t led_data[BUFFER_SIZE] DISPMEM;
+// Port data is converted into one buffer while the other one is written to the LEDs
+#define LED_DATA_BUFFERS 2
+static alignas(4) uint8_t led_data[LED_DATA_BUFFERS][LED_DATA_SIZE] DISPMEM;
+#ifdef DISPLAY_DITHERING
+// 16 bit colors of the last displayed frame, with their accumulated errors
+static alignas(4) uint8_t dither_state[DITHER_STATE_SIZE] DISPMEM;
+#elif defined(DISPLAY_INTERPOLATION)
+// Colors of the last two displayed frames
+static alignas(4) uint8_t interpolation_state[INTERPOLATION_STATE_SIZE] DISPMEM;
+#else
+// Frame data that was last converted into led_data
+static alignas(4) uint8_t encoded_source[ENCODED_SOURCE_SIZE] DISPMEM;
+#endif
+
+// Buffer that is being, or was last, written to the LEDs
+static volatile uint8_t front_buffer;
+// Set while the other buffer is being converted, or waiting to be written
+static volatile atomic_flag back_buffer_busy;
+// Set when the other buffer should be written after the current transfer
+static volatile bool back_buffer_ready;
+
+// Set when the port map, color order, strip orientation, or color correction may have changed
+static volatile bool configuration_changed;
+
+#ifdef DISPLAY_STREAM_ENCODING
+#if defined(DISPLAY_DITHERING) || defined(DISPLAY_INTERPOLATION)
+#error "Frames cannot be converted while they are received when dithering or interpolating"
+#endif
+// Remote frame that is being converted into the back buffer while it is received
+static struct frame_buffer_t* volatile stream_frame;
+#endif
+
+#ifdef DISPLAY_REFRESH_RATIO
+// Set by the refresh timer, cleared when the refresh is converted
+static volatile bool refresh_due;
+// Refresh timer periods since the last displayed frame, up to DISPLAY_REFRESH_RATIO
+static volatile uint8_t refresh_index;
+#endif
 
 // Defaoult FTM channel configuration
 static const uint32_t ftm_channel_output = _BV(5)|_BV(3);
 
+#if PORT_BANK_COUNT > 1
+/* Every DMA minor loop writes one byte to port D, and then one byte to port C, by stepping from
+ * the port D register to the same port C register. The destination address modulo keeps the
+ * next step within the GPIO registers of both ports, so it returns to port D.
+ * The port data of the second bank follows that of the first bank, so the source address steps
+ * forward to the second bank, and then back to the next byte of the first bank.
+ */
+#define PORT_BANK_DOFF (-0x40)
+#define PORT_BANK_ATTR_DST (7<<3) // 8 bit transfers, 128 byte destination modulo
+#define MINOR_LOOP_NBYTES PORT_BANK_COUNT
+#define MINOR_LOOP_SOURCE_OFFSET(offset) (_BV(31) | ((uint32_t) ((offset) & 0xFFFFF) << 10))
+#define PORT_DATA_NBYTES ( \
+  MINOR_LOOP_SOURCE_OFFSET(1 - PORT_BANK_COUNT*PORT_BANK_DATA_SIZE) | MINOR_LOOP_NBYTES \
+)
+#else
+#define MINOR_LOOP_NBYTES 1
+#define PORT_DATA_NBYTES MINOR_LOOP_NBYTES
+#endif
+
+// Read the LED layout and color correction, and compile the frame data conversion plan
+static void init_encoder() {
+  struct port_map_t led_mapping[SEGMENT_COUNT];
+  eeprom_read_block(&led_mapping, &LED_MAP, sizeof(LED_MAP));
+  uint8_t* const buffers[LED_DATA_BUFFERS] = {led_data[0], led_data[1]};
+#ifdef DISPLAY_DITHERING
+  // Every refresh is converted completely, so there is no use for a copy of the frame data.
+  // Color correction is left to the host, as it should be applied to the 16 bit colors.
+  init_port_encoder(
+      get_color_order()
+    , NULL
+    , get_reverse_first_strip_segment()
+    , led_mapping
+    , NULL
+    , buffers
+    , LED_DATA_BUFFERS
+  );
+  init_port_dither(dither_state);
+#elif defined(DISPLAY_INTERPOLATION)
+  // Every refresh is converted completely, so there is no use for a copy of the frame data
+  init_port_encoder(
+      get_color_order()
+    , load_color_lut()
+    , get_reverse_first_strip_segment()
+    , led_mapping
+    , NULL
+    , buffers
+    , LED_DATA_BUFFERS
+  );
+  init_port_interpolation(interpolation_state);
+#else
+  init_port_encoder(
+      get_color_order()
+    , load_color_lut()
+    , get_reverse_first_strip_segment()
+    , led_mapping
+    , encoded_source
+    , buffers
+    , LED_DATA_BUFFERS
+  );
+#endif
+}
+
+#ifdef DISPLAY_REFRESH_RATIO
+// (Re)start the refresh timer, so the refreshes are evenly spread over the frame interval
+static void start_refresh_timer() {
+  pit_channels[2].TCTRL = 0;
+  pit_channels[2].TFLG = 1;
+  refresh_due = false;
+  refresh_index = 0;
+  pit_channels[2].LDVAL = F_BUS/(DEVICE_FPS*DISPLAY_REFRESH_RATIO) - 1;
+  pit_channels[2].TCTRL = _BV(1)|_BV(0);
+}
+
+// ISR must be visible to other modules, so don't declare this static
+void pit2_isr() {
+  TRACE_BEGIN(TRACE_REFRESH_TIMER_ISR);
+  pit_channels[2].TFLG = 1;
+  if (refresh_index < DISPLAY_REFRESH_RATIO) {
+    ++refresh_index;
+  }
+  refresh_due = true;
+  TRACE_END(TRACE_REFRESH_TIMER_ISR);
+}
+#endif
+
 // OctoWS2811 init_display_driver
 void init_display_driver() {
   /** Based on OctoWS2811 code **/
@@ -68,6 +170,13 @@ void init_display_driver() {
   PORTD_GPCHR = (0xFFFF<<16); // Disable all interrupts on port D
   GPIOD_PDDR = 0xFF; // Set all port pins as output
   GPIOD_PCOR = 0xFF; // Clear all pin outputs
+#if PORT_BANK_COUNT > 1
+  // Ports 8 to 15 use pins 0 to 7 of port C, which includes the USB activity LED pin
+  ATOMIC_REGISTER_BIT_SET(SIM_SCGC5, 11); // Enable port C clock
+  PORTC_GPCLR = (0xFF<<16) | (1<<8); // Select ALT1 (GPIO) mode for pins 0-7
+  GPIOC_PDDR |= 0xFF;
+  GPIOC_PCOR = 0xFF;
+#endif
 
   // Initialise DMA
   ATOMIC_REGISTER_BIT_SET(SIM_SCGC6, 1); // SIM_SCGC6(1) DMA mux module
@@ -87,24 +196,32 @@ void init_display_driver() {
   dma_tcd_list[0].CSR = _BV(3);
   dma_tcd_list[0].SADDR = &ones;
   dma_tcd_list[0].DADDR = &GPIOD_PSOR;
-  dma_tcd_list[0].NBYTES = 1;
-  dma_tcd_list[0].BITER = BUFFER_SIZE;
-  dma_tcd_list[0].CITER = BUFFER_SIZE;
+  dma_tcd_list[0].NBYTES = MINOR_LOOP_NBYTES;
+  dma_tcd_list[0].BITER = PORT_BANK_DATA_SIZE;
+  dma_tcd_list[0].CITER = PORT_BANK_DATA_SIZE;
 
   // Write bit values after time_0_high
-  // SADDR, SOFF, SLAST and DADDR are set when initiating a frame write
+  // SADDR, SOFF, NBYTES, SLAST and DADDR are set when initiating a frame write
   dma_tcd_list[1].CSR = _BV(3);
-  dma_tcd_list[1].NBYTES = 1;
-  dma_tcd_list[1].BITER = BUFFER_SIZE;
-  dma_tcd_list[1].CITER = BUFFER_SIZE;
+  dma_tcd_list[1].NBYTES = MINOR_LOOP_NBYTES;
+  dma_tcd_list[1].BITER = PORT_BANK_DATA_SIZE;
+  dma_tcd_list[1].CITER = PORT_BANK_DATA_SIZE;
 
   // Set all outputs low after time_1_high
   dma_tcd_list[2].CSR = _BV(3) | _BV(1);
   dma_tcd_list[2].SADDR = &ones;
   dma_tcd_list[2].DADDR = &GPIOD_PCOR;
-  dma_tcd_list[2].NBYTES = 1;
-  dma_tcd_list[2].BITER = BUFFER_SIZE;
-  dma_tcd_list[2].CITER = BUFFER_SIZE;
+  dma_tcd_list[2].NBYTES = MINOR_LOOP_NBYTES;
+  dma_tcd_list[2].BITER = PORT_BANK_DATA_SIZE;
+  dma_tcd_list[2].CITER = PORT_BANK_DATA_SIZE;
+
+#if PORT_BANK_COUNT > 1
+  // Write to port D and port C in every minor loop
+  for (unsigned int channel = 0; channel < 3; ++channel) {
+    dma_tcd_list[channel].ATTR_DST = PORT_BANK_ATTR_DST;
+    dma_tcd_list[channel].DOFF = PORT_BANK_DOFF;
+  }
+#endif
 
   // Disable used DMA channels
   DMAMUX0_CHCFG0 = 0;
@@ -154,50 +271,9 @@ void init_display_driver() {
   DMAMUX0_CHCFG1 = 34 | _BV(7); // Ch 34 = FTM2_CH0
   DMAMUX0_CHCFG2 = 35 | _BV(7); // Ch 34 = FTM2_CH1
 
-  // Read color order and determine pointer differences
-  switch (get_color_order()) {
-    case LED_ORDER_BGR:
-      color_offset_initial = OFFSET_BLUE;
-      delta_0 = OFFSET_GREEN-OFFSET_BLUE;
-      delta_1 = OFFSET_RED-OFFSET_GREEN;
-      break;
-    case LED_ORDER_BRG:
-      color_offset_initial = OFFSET_BLUE;
-      delta_0 = OFFSET_RED-OFFSET_BLUE;
-      delta_1 = OFFSET_GREEN-OFFSET_RED;
-      break;
-    case LED_ORDER_GBR:
-      color_offset_initial = OFFSET_GREEN;
-      delta_0 = OFFSET_BLUE-OFFSET_GREEN;
-      delta_1 = OFFSET_RED-OFFSET_BLUE;
-      break;
-    case LED_ORDER_GRB:
-      color_offset_initial = OFFSET_GREEN;
-      delta_0 = OFFSET_RED-OFFSET_GREEN;
-      delta_1 = OFFSET_BLUE-OFFSET_RED;
-      break;
-    case LED_ORDER_RBG:
-      color_offset_initial = OFFSET_RED;
-      delta_0 = OFFSET_BLUE-OFFSET_RED;
-      delta_1 = OFFSET_GREEN-OFFSET_BLUE;
-      break;
-    case LED_ORDER_RGB:
-    default:
-      color_offset_initial = OFFSET_RED;
-      delta_0 = OFFSET_GREEN-OFFSET_RED;
-      delta_1 = OFFSET_BLUE-OFFSET_GREEN;
-      break;
-  }
-
-  eeprom_read_block(&led_mapping, &LED_MAP, sizeof(LED_MAP));
-  for (unsigned int segment = 0; segment < SEGMENT_COUNT; ++segment) {
-    if (led_mapping[segment].ports_length > MAX_PORT_COUNT) {
-      led_mapping[segment].ports_length = 0;
-    }
-  }
-
-  // Strip orientation
-  reverse_first_segment = get_reverse_first_strip_segment();
+  // Prepare frame data conversion
+  configuration_changed = false;
+  init_encoder();
 
   // PDB configuration for frame reset timer
   ATOMIC_REGISTER_BIT_SET(SIM_SCGC6, 22); // Enable PDB clock
@@ -210,10 +286,23 @@ void init_display_driver() {
 
   PDB0_SC = PDB_SC_PDBIE | PDB_SC_TRGSEL(15) | PDB_SC_LDOK | PDB_SC_PDBEN;
 
+#ifdef DISPLAY_REFRESH_RATIO
+  // The refresh timer is started by the first displayed frame
+  enable_pit_module();
+  pit_channels[2].TCTRL = 0;
+  pit_channels[2].TFLG = 1;
+  refresh_due = false;
+  NVIC_ENABLE_IRQ(IRQ_PIT_CH2);
+#endif
+
+  front_buffer = 0;
+  back_buffer_ready = false;
+  atomic_flag_clear(&back_buffer_busy);
   atomic_flag_clear(&frame_write_in_progress);
 }
 
 void dma_ch2_isr() {
+  TRACE_BEGIN(TRACE_DMA_ISR);
   // Clear the interrupt
   DMA_CINT = 2;
   // Halt the FTM clock and disable this IRQ
@@ -224,14 +313,14 @@ void dma_ch2_isr() {
   // This ensures that the LED string receives a RESET signal and
   // the next frame will be displayed properly.
   GPIOD_PDOR = 0;
+#if PORT_BANK_COUNT > 1
+  // Only clear pins 0-7 of port C, the other pins aren't used for LED strips
+  GPIOC_PCOR = 0xFF;
+#endif
 
   // Trigger 50µs delay timer
   ATOMIC_REGISTER_BIT_SET(PDB0_SC, 16);
-}
-
-void pdb_isr() {
-  ATOMIC_REGISTER_BIT_CLEAR(PDB0_SC, 6);
-  atomic_flag_clear(&frame_write_in_progress);
+  TRACE_END(TRACE_DMA_ISR);
 }
 
 static void start_dma_transfer() {
@@ -270,151 +359,126 @@ static void start_dma_transfer() {
   ftm2_config->SC = (1<<3);
 }
 
-// Store a 8b×8b matrix as two 32b little-endian integers
-union matrix_t {
-  uint8_t rows[8];
-  struct {
-    uint32_t low;
-    uint32_t high;
-  };
-};
-
-/* Swap bits in a 32b word using XOR operations.
- * For the two set of bits have that are to be swapped, the first one has to be right shifted on the
- * position of the second one. The mask then indicates the position of the bits in the second set.
- * Note that the mask must necessarily also be a shifted version the locations of the first bit set.
- * Example: To swap bits (31, 20, 15, 13) with bits (18, 7, 2, 0) provide the following values:
- *  - `shift`: `13`
- *  - `mask`: `0x00040085` (`0b00000000_00000100_00000000_10000101`)
- */
-static inline uint32_t swap_bits(uint32_t rows, uint8_t shift, uint32_t mask) {
-  uint32_t swapped_bits = (rows ^ (rows >> shift)) & mask;
-  return rows ^ swapped_bits ^ (swapped_bits << shift);
-}
-
-static union matrix_t transpose_matrix(union matrix_t m) {
-  /* Transposing a matrix can be done recursively for matrices of size (2^n × 2^n).
-   * 1. Divide the matrix T into four submatrices T[i,j], each of size (2^(n-1) × 2^(n-1)).
-   * 2. Swap T[0,1] and T[1,0].
-   * 3. Repeat steps 1 and 2 for each submatrix until the submatrices have reached size (1×1).
-   *
-   * The following algorithm is applied recursively to swap (blocks of) high and low bits.
-   * Steps 2 and 3 can be combined into one expression for swap_level_2 and swap_level_3.
-   * 1. XOR high bits that into low bits, and mask out all other data
-   * 2. XOR original high data with temp to cancel original low bits and keep high bits
-   * 3. XOR original low data with shifted temp to cancel original high bits and keep low bits
-   *
-   * Bytes can be kept in little-endian representation by rotating around j=7-i axis.
-   * This is equivalent to reversing the byte order before and after the transpose (with axis i=j).
-   *
-   * The original implementation this was based can be found at:
-   *   http://www.hackersdelight.org/hdcodetxt/transpose8.c.txt
-   */
+// Swap the buffers and write the new front buffer. Called with frame_write_in_progress set.
+static void start_back_buffer_transfer() {
+  front_buffer ^= 1;
 
-  // Stage 1 swap: 4 (4×4) submatrices
-  uint32_t swapped_bits = ((m.high >> 4) ^ m.low) & 0x0F0F0F0F;
-  m.high = m.high ^ (swapped_bits << 4);
-  m.low = m.low ^ swapped_bits;
+  // Setup TCD to write buffer data
+  dma_tcd_list[1].SADDR = &(led_data[front_buffer][0]);
+  dma_tcd_list[1].SOFF = PORT_BANK_COUNT > 1 ? PORT_BANK_DATA_SIZE : 1;
+  dma_tcd_list[1].NBYTES = PORT_DATA_NBYTES;
+  dma_tcd_list[1].SLAST = -PORT_BANK_DATA_SIZE;
+  dma_tcd_list[1].DADDR = &GPIOD_PDOR;
 
-  // Stage 2 swap: 16 (2×2) submatrices
-  m.high = swap_bits(m.high, 18, 0x00003333);
-  m.low = swap_bits(m.low, 18, 0x00003333);
-
-  // Stage 3 swap: 64 (1×1) submatrices
-  m.high = swap_bits(m.high, 9, 0x00550055);
-  m.low = swap_bits(m.low, 9, 0x00550055);
-
-  return m;
+  start_dma_transfer();
+  atomic_flag_clear(&back_buffer_busy);
 }
 
-
-static void copy_buffer(const void* restrict src, void* restrict dest) {
-  // Perform a linear write to the output buffer, at the expense of having to jump around
-  // the input buffer *a lot*.
-  union matrix_t* output = (union matrix_t*) dest;
-
-  const ptrdiff_t color_offset_rewind = -(delta_0 + delta_1);
-  ptrdiff_t delta_color_offset[sizeof(struct led_t)] = {delta_0, delta_1, 0};
-
-  // Current reading positions for all ports
-  const uint8_t* input[MAX_PORT_COUNT];
-  // Current last position for port 0; all ports need the same amount of data any way.
-  const uint8_t* input_0_end;
-
-  unsigned int segment = 0;
-  while (segment < SEGMENT_COUNT && led_mapping[segment].ports_length > 0) {
-    const uint8_t used_port_count = led_mapping[segment].ports_length;
-    // Reverse even segments if first one is reversed, otherwise reverse odd segments.
-    // rF\E| 0 1
-    // ---------
-    //   0 | 1 0
-    //   1 | 0 1
-    const bool is_even = (segment % 2) == 0;
-    const bool is_reversed = reverse_first_segment == is_even;
-
-    const uint8_t* initial_position = ((const uint8_t*) src) + color_offset_initial;
-    if (is_reversed) {
-      initial_position += (STRING_LENGTH-1)*BUFFER_STEP;
+// Write the back buffer now, or when the current transfer has finished
+static void submit_back_buffer() {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if (!atomic_flag_test_and_set(&frame_write_in_progress)) {
+      start_back_buffer_transfer();
     }
-
-    for (unsigned int port = 0; port < used_port_count; ++port) {
-      const uint8_t string = led_mapping[segment].ports[port];
-      input[port] = initial_position + STRING_LENGTH*BUFFER_STEP*string;
+    else {
+      back_buffer_ready = true;
     }
+  }
+}
+
+void pdb_isr() {
+  TRACE_BEGIN(TRACE_PDB_ISR);
+  ATOMIC_REGISTER_BIT_CLEAR(PDB0_SC, 6);
+  if (back_buffer_ready) {
+    back_buffer_ready = false;
+    start_back_buffer_transfer();
+  }
+  else {
+    atomic_flag_clear(&frame_write_in_progress);
+  }
+  TRACE_END(TRACE_PDB_ISR);
+}
 
-    if (!is_reversed) {
-      input_0_end = input[0] + STRING_LENGTH*BUFFER_STEP;
-      delta_color_offset[2] = color_offset_rewind + BUFFER_STEP;
+void display_frame(struct frame_buffer_t* buffer) {
+  if (!atomic_flag_test_and_set(&back_buffer_busy)) {
+    bool encoded = false;
+#ifdef DISPLAY_STREAM_ENCODING
+    // Stop any stream before touching the back buffer. The USB interrupt won't start a new one,
+    // since back_buffer_busy is now set.
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      encoded = stream_frame == buffer && (buffer->flags & FRAME_ENCODED);
+      stream_frame = NULL;
     }
-    else {
-      input_0_end = input[0] - STRING_LENGTH*BUFFER_STEP;
-      delta_color_offset[2] = color_offset_rewind - BUFFER_STEP;
+#endif
+    // The encoder is only used with back_buffer_busy set, or by a stream, so it can be safely
+    // reconfigured now
+    if (configuration_changed) {
+      configuration_changed = false;
+      init_encoder();
+      encoded = false;
     }
-
-    // Shuffle LED data from USB buffer format to OctoWS2811 format
-    while (input[0] != input_0_end) {
-      for (unsigned int color = 0; color < sizeof(struct led_t); ++color) {
-        // Gather data for all ports
-        union matrix_t m;
-
-        for (unsigned int port = 0; port < used_port_count; ++port) {
-          // Copy 8 data bytes for the current color
-          m.rows[MAX_PORT_COUNT-1 - port] = *input[port];
-          // Jump to next color (possibly of the next LED)
-          input[port] += delta_color_offset[color];
-        }
-
-        // Transpose bytes to correct output format
-        *output = transpose_matrix(m);
-        output++;
-      }
+    if (!encoded) {
+      ATOMIC_SRAM_BIT_SET(buffer->flags, 2);
+      // The front buffer may still be written to the LEDs in the mean time
+#ifdef DISPLAY_DITHERING
+      load_dither_frame(buffer->buffer);
+      encode_dither_refresh(front_buffer ^ 1);
+#elif defined(DISPLAY_INTERPOLATION)
+      // Start from the previous frame, which is what the LEDs were last refreshed with
+      load_interpolated_frame(buffer->buffer);
+      encode_interpolated_refresh(0, front_buffer ^ 1);
+#else
+      encode_frame_changes(buffer->buffer, front_buffer ^ 1);
+#endif
+      ATOMIC_SRAM_BIT_CLEAR(buffer->flags, 2);
     }
+#ifdef DISPLAY_REFRESH_RATIO
+    start_refresh_timer();
+#endif
 
-    segment++;
+    submit_back_buffer();
+    telemetry_count(TELEMETRY_FRAMES_DRAWN);
+  }
+  else {
+    telemetry_count(TELEMETRY_DRAW_SKIPPED);
   }
 }
 
-void display_frame(struct frame_buffer_t* buffer) {
-  if (!atomic_flag_test_and_set(&frame_write_in_progress)) {
-    ATOMIC_SRAM_BIT_SET(buffer->flags, 2);
-    copy_buffer(buffer->buffer, &(led_data[0]));
-    ATOMIC_SRAM_BIT_CLEAR(buffer->flags, 2);
-
-    // Setup TCD to write buffer data
-    dma_tcd_list[1].SADDR = &(led_data[0]);
-    dma_tcd_list[1].SOFF = 1;
-    dma_tcd_list[1].SLAST = -BUFFER_SIZE;
-    dma_tcd_list[1].DADDR = &GPIOD_PDOR;
+#ifdef DISPLAY_REFRESH_RATIO
+bool should_refresh_display() {
+  return refresh_due;
+}
 
-    start_dma_transfer();
+void refresh_display() {
+  refresh_due = false;
+  if (!atomic_flag_test_and_set(&back_buffer_busy)) {
+#ifdef DISPLAY_DITHERING
+    encode_dither_refresh(front_buffer ^ 1);
+#else
+    // Move towards the last frame over the frame interval, then keep showing it
+    encode_interpolated_refresh(
+        (INTERPOLATION_WEIGHT_MAX*refresh_index)/DISPLAY_REFRESH_RATIO
+      , front_buffer ^ 1
+    );
+#endif
+    submit_back_buffer();
+  }
+  else {
+    telemetry_count(TELEMETRY_REFRESH_SKIPPED);
   }
 }
+#endif
+
+void reload_display_configuration() {
+  configuration_changed = true;
+}
 
 void display_blank() {
   if (!atomic_flag_test_and_set(&frame_write_in_progress)) {
     // Setup TCD to write blank data
     dma_tcd_list[1].SADDR = &ones;
     dma_tcd_list[1].SOFF = 0;
+    dma_tcd_list[1].NBYTES = MINOR_LOOP_NBYTES;
     dma_tcd_list[1].SLAST = 0;
     dma_tcd_list[1].DADDR = &GPIOD_PCOR;
 
@@ -422,3 +486,35 @@ void display_blank() {
   }
 }
 
+#ifdef DISPLAY_STREAM_ENCODING
+// Only called from the USB interrupt
+void display_stream_start(struct frame_buffer_t* frame) {
+  // The buffer may have been used for a stream that was abandoned
+  if (stream_frame == frame) {
+    stream_frame = NULL;
+  }
+}
+
+void display_stream_update(struct frame_buffer_t* frame, size_t received) {
+  if (stream_frame != frame) {
+    // The back buffer must be available, and this frame must be the next one that is drawn.
+    // Any data that was already received is converted now.
+    // Since the encoder keeps encoded_source consistent with the port data, an abandoned stream
+    // or a frame that is drawn before this one is complete only leave unnecessary work for
+    // display_frame().
+    if (atomic_flag_test_and_set(&back_buffer_busy)) {
+      return;
+    }
+    atomic_flag_clear(&back_buffer_busy);
+    if (!frame_queue_empty()) {
+      return;
+    }
+    stream_frame = frame;
+    encode_stream_start(front_buffer ^ 1);
+  }
+
+  if (encode_stream_update(frame->buffer, received)) {
+    frame->flags |= FRAME_ENCODED;
+  }
+}
+#endif
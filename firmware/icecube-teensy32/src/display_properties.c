@@ -2,6 +2,10 @@
 #include "device_properties.h"
 #include "display_types.h"
 #include "frame_buffer.h"
+#include "usb/remote_renderer.h"
+#if defined(DEVICE_HAS_EVENT_PLAYBACK) && DEVICE_HAS_EVENT_PLAYBACK
+#include "render/event_playback.h"
+#endif
 #include <avr/eeprom.h>
 #include <stdbool.h>
 
@@ -27,8 +31,13 @@ struct dp_led_information_t {
 
 #define DISPLAYPROP __attribute__((section(".displayprop"), used))
 static const struct dp_led_information_t DP_LED_INFORMATION DISPLAYPROP = {
+#ifdef DISPLAY_LED_APA102
+    LED_TYPE_APA102
+  , LED_ORDER_BGR
+#else
     LED_TYPE_WS2811
   , LED_ORDER_GRB
+#endif
   , DEVICE_ICECUBE_STRING_START
   , DEVICE_ICECUBE_STRING_END
   , DEVICE_HAS_DEEPCORE
@@ -38,8 +47,18 @@ static const struct dp_led_information_t DP_LED_INFORMATION DISPLAYPROP = {
 #define GROUPPROP __attribute__((section(".groupid"), used))
 static const uint8_t DP_INFO_GROUP[16] GROUPPROP;
 
+#ifdef DISPLAY_LED_APA102
+static const enum display_led_type_t DP_INFO_LED_TYPE = LED_TYPE_APA102;
+#elif defined(DISPLAY_DITHERING)
+static const enum display_led_type_t DP_INFO_LED_TYPE = LED_TYPE_WS2811_16;
+#else
 static const enum display_led_type_t DP_INFO_LED_TYPE = LED_TYPE_WS2811;
+#endif
 static const enum display_information_type_t DP_INFO_TYPE = INFORMATION_IC_STRING;
+static const uint8_t DP_INFO_FRAME_ENCODINGS = REMOTE_FRAME_ENCODINGS;
+#if defined(DEVICE_HAS_EVENT_PLAYBACK) && DEVICE_HAS_EVENT_PLAYBACK
+static const uint16_t DP_INFO_EVENT_PULSE_CAPACITY = EVENT_PULSE_CAPACITY;
+#endif
 
 static uint16_t dp_buffer_size;
 
@@ -50,6 +69,10 @@ static const struct dp_tlv_item_t PROPERTIES_TLV_LIST[] = {
   , TLV_ENTRY(DP_BUFFER_SIZE, MEMSPACE_RAM, &dp_buffer_size)
   , TLV_ENTRY(DP_INFORMATION_RANGE, MEMSPACE_RAM, &dp_info_range_icecube)
   , TLV_ENTRY(DP_GROUP_ID, MEMSPACE_PROGMEM, &DP_INFO_GROUP)
+  , TLV_ENTRY(DP_FRAME_ENCODINGS, MEMSPACE_PROGMEM, &DP_INFO_FRAME_ENCODINGS)
+#if defined(DEVICE_HAS_EVENT_PLAYBACK) && DEVICE_HAS_EVENT_PLAYBACK
+  , TLV_ENTRY(DP_EVENT_PULSE_CAPACITY, MEMSPACE_PROGMEM, &DP_INFO_EVENT_PULSE_CAPACITY)
+#endif
   , TLV_END
 };
 
@@ -84,7 +107,13 @@ uint16_t get_led_count() {
 }
 
 uint8_t get_led_size() {
+#ifdef DISPLAY_LED_APA102
+  return sizeof(struct led_apa102_t);
+#elif defined(DISPLAY_DITHERING)
+  return sizeof(struct led16_t);
+#else
   return sizeof(struct led_t);
+#endif
 }
 
 enum display_led_color_order_t get_color_order() {
@@ -1,6 +1,7 @@
 #include "kinetis/io.h"
 #include "kinetis/pit.h"
 #include "frame_timer_backend.h"
+#include "trace.h"
 
 static void (*callback)();
 
@@ -21,23 +22,21 @@ void init_frame_timer_backend(void (*timer_callback)()) {
   pit_channels[0].TCTRL = _BV(1); // enable timer interrupts
   pit_channels[0].TCTRL = _BV(1)|_BV(0); // ... and enable timer
 
-  // GPIO C2 init
-  ATOMIC_REGISTER_BIT_SET(GPIOC_PDDR, 2);
-  ATOMIC_REGISTER_BIT_SET(GPIOC_PCOR, 2);
-  PORTC_PCR2 = PORT_PCR_MUX(1);
+#if defined(DEVICE_HAS_TRACE) && DEVICE_HAS_TRACE
+  // Enable the DWT cycle counter for the trace timestamps
+  ARM_DEMCR |= ARM_DEMCR_TRCENA;
+  ARM_DWT_CTRL |= ARM_DWT_CTRL_CYCCNTENA;
+#endif
 }
 
 // ISR must be visible to other modules, so don't declare this static
 void pit0_isr() {
+  TRACE_BEGIN(TRACE_FRAME_TIMER_ISR);
   pit_channels[0].TFLG = 1;
-  // GPIO C2 set
-  ATOMIC_REGISTER_BIT_SET(GPIOC_PSOR, 2);
-  GPIOC_PSOR |= _BV(2);
   if (callback) {
     callback();
   }
-  // GPIO C2 clear
-  ATOMIC_REGISTER_BIT_SET(GPIOC_PCOR, 2);
+  TRACE_END(TRACE_FRAME_TIMER_ISR);
 }
 
 timer_count_t get_counts_max() {
@@ -48,6 +47,10 @@ timer_count_t get_counts_current() {
   return pit_channels[0].CVAL;
 }
 
+bool is_rollover_pending() {
+  return pit_channels[0].TFLG & 1;
+}
+
 int8_t get_counter_direction() {
   return -1;
 }
@@ -55,3 +58,7 @@ int8_t get_counter_direction() {
 void correct_counts_max(timer_diff_t diff) {
   pit_channels[0].LDVAL += diff;
 }
+
+uint32_t get_trace_timestamp() {
+  return ARM_DWT_CYCCNT;
+}
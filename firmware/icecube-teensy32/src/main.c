@@ -1,11 +1,18 @@
 #include <stdint.h>
 
 #include "display_driver.h"
+#include "display_refresh.h"
+#include "color_lut.h"
+#include "color_palette.h"
 #include "render/rain.h"
+#if defined(DEVICE_HAS_EVENT_PLAYBACK) && DEVICE_HAS_EVENT_PLAYBACK
+#include "render/event_playback.h"
+#endif
 #include "remote.h"
 #include "frame_buffer.h"
 #include "frame_queue.h"
 #include "frame_timer.h"
+#include "trace.h"
 
 // Display state
 enum display_state_t {
@@ -13,6 +20,7 @@ enum display_state_t {
   , DISPLAY_STATE_IDLE
   , DISPLAY_STATE_BOOT_SPLASH
   , DISPLAY_STATE_EXTERNAL
+  , DISPLAY_STATE_EVENT_PLAYBACK
 };
 
 static volatile enum display_state_t display_state = DISPLAY_STATE_BOOT;
@@ -29,6 +37,11 @@ static inline const struct renderer_t* get_renderer() {
     case DISPLAY_STATE_BOOT_SPLASH:
       return get_rain_renderer();
       break;
+#if defined(DEVICE_HAS_EVENT_PLAYBACK) && DEVICE_HAS_EVENT_PLAYBACK
+    case DISPLAY_STATE_EVENT_PLAYBACK:
+      return get_event_playback_renderer();
+      break;
+#endif
 #ifndef DEVICE_TEST_MODE
     case DISPLAY_STATE_IDLE:
 #endif
@@ -66,6 +79,20 @@ static inline void advance_display_state() {
   else if (display_state == DISPLAY_STATE_EXTERNAL && !is_remote_connected()) {
     new_state = DISPLAY_STATE_IDLE;
   }
+#if defined(DEVICE_HAS_EVENT_PLAYBACK) && DEVICE_HAS_EVENT_PLAYBACK
+  else if (display_state == DISPLAY_STATE_EXTERNAL && is_event_playback_enabled()) {
+    new_state = DISPLAY_STATE_EVENT_PLAYBACK;
+  }
+  else if (display_state == DISPLAY_STATE_EVENT_PLAYBACK) {
+    // The renderer stops the playback when it is stopped itself
+    if (!is_remote_connected()) {
+      new_state = DISPLAY_STATE_IDLE;
+    }
+    else if (!is_event_playback_enabled()) {
+      new_state = DISPLAY_STATE_EXTERNAL;
+    }
+  }
+#endif
 
   // Check if state changed and switch renderers accordingly
   if (new_state != display_state) {
@@ -97,7 +124,9 @@ static inline void advance_display_state() {
 
 static inline void consume_frame(struct frame_buffer_t* frame) {
   if (frame && frame->buffer) {
+    TRACE_BEGIN(TRACE_DISPLAY_FRAME);
     display_frame(frame);
+    TRACE_END(TRACE_DISPLAY_FRAME);
     if (frame->flags & FRAME_FREE_AFTER_DRAW) {
       destroy_frame(frame);
     }
@@ -108,9 +137,17 @@ int main () {
   // Must be run *before* using any other display functions
   init_display_properties();
 
+  // The color palette is small, so allocate it before the frame buffers take the remaining memory
+  init_color_palette();
+
   // Initialise frame buffer memory before rendering
   init_frame_buffers();
 
+#if defined(DEVICE_HAS_COLOR_LUT) && DEVICE_HAS_COLOR_LUT
+  // Load the stored color correction before the display driver uses it
+  init_color_lut();
+#endif
+
   // Init display pin configuration
   init_display_driver();
   display_blank();
@@ -124,16 +161,33 @@ int main () {
   // Main loop
   for (;;) {
     while (!should_draw_frame()) {
+#ifdef DISPLAY_REFRESH_RATIO
+      // Dither or interpolate the last frames in between frame draws
+      if (should_refresh_display()) {
+        TRACE_BEGIN(TRACE_REFRESH_DISPLAY);
+        refresh_display();
+        TRACE_END(TRACE_REFRESH_DISPLAY);
+        continue;
+      }
+#endif
       // Idle CPU until next interrupt
       asm("wfi");
     }
 
-    consume_frame(pop_frame());
+    struct display_frame_usb_phase_t frame_phase;
+    if (get_display_frame_usb_phase(&frame_phase)) {
+      TRACE_BEGIN(TRACE_POP_FRAME);
+      struct frame_buffer_t* frame = pop_due_frame(frame_phase.display_frame_counter);
+      TRACE_END(TRACE_POP_FRAME);
+      consume_frame(frame);
+    }
 
     advance_display_state();
 
     if (renderer && !frame_queue_full()) {
+      TRACE_BEGIN(TRACE_RENDER_FRAME);
       struct frame_buffer_t* f = renderer->render_frame();
+      TRACE_END(TRACE_RENDER_FRAME);
       if (f && !push_frame(f) && (f->flags & FRAME_FREE_AFTER_DRAW)) {
         destroy_frame(f);
       }
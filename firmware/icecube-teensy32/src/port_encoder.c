@@ -0,0 +1,972 @@
+#include <stddef.h>
+#include <string.h>
+
+#include "port_encoder.h"
+#include "color_lut.h"
+
+#define BUFFER_STEP sizeof(struct led_t)
+#define ALL_LEDS ((UINT64_C(1) << STRING_LENGTH) - 1)
+// Every port bank of a strip segment is converted separately
+#define PLAN_SIZE (SEGMENT_COUNT*PORT_BANK_COUNT)
+// Number of 8×8 matrices in the port data of one segment of a port bank
+#define SEGMENT_MATRICES (sizeof(struct led_t)*STRING_LENGTH)
+
+#ifdef PORT_ENCODER_DSP_KERNEL
+#if defined(__ARM_FEATURE_DSP)
+/* Run the kernels from RAM, without flash wait states. Every kernel is placed in its own
+ * .fastrun subsection, so the linker can still discard the kernels that are not used.
+ */
+#define KERNEL_SECTION(n) KERNEL_SECTION_NAME(n)
+#define KERNEL_SECTION_NAME(n) ".fastrun.port_encoder." #n
+#define KERNEL \
+  __attribute__ ((section(KERNEL_SECTION(__COUNTER__)), long_call, noinline, optimize("O2")))
+// Optimised like the RAM resident kernels, but run from flash
+#define FLASH_KERNEL __attribute__ ((noinline, optimize("O2")))
+
+static inline uint32_t pack_halfwords(uint32_t bottom, uint32_t top) {
+  uint32_t packed;
+  __asm__ ("pkhbt %0, %1, %2, lsl #16" : "=r" (packed) : "r" (bottom), "r" (top));
+  return packed;
+}
+#else
+#define KERNEL
+#define FLASH_KERNEL
+// Equivalent of PKHBT, so the kernel can also be verified on a PC
+static inline uint32_t pack_halfwords(uint32_t bottom, uint32_t top) {
+  return (bottom & 0xFFFF) | (top << 16);
+}
+#endif
+
+// Source data of unused ports
+static uint8_t blank_led[sizeof(struct led_t)];
+#else
+#define KERNEL
+#define FLASH_KERNEL
+#endif
+
+// Color order
+#define OFFSET_RED ((ptrdiff_t) offsetof(struct led_t, red))
+#define OFFSET_GREEN ((ptrdiff_t) offsetof(struct led_t, green))
+#define OFFSET_BLUE ((ptrdiff_t) offsetof(struct led_t, blue))
+#define OFFSET16_RED ((ptrdiff_t) offsetof(struct led16_t, red))
+#define OFFSET16_GREEN ((ptrdiff_t) offsetof(struct led16_t, green))
+#define OFFSET16_BLUE ((ptrdiff_t) offsetof(struct led16_t, blue))
+
+struct segment_plan_t;
+union matrix_t;
+
+// Conversion of all LED positions of a strip segment
+typedef void (*segment_kernel_t)(
+    const uint8_t* restrict src
+  , const struct segment_plan_t* plan
+  , union matrix_t* restrict output
+);
+// Conversion of the LED at position `dom` of every string of a strip segment
+typedef void (*led_kernel_t)(
+    const uint8_t* restrict src
+  , const struct segment_plan_t* plan
+  , unsigned int dom
+  , union matrix_t* restrict output
+);
+
+// Gather plan of a strip segment of one port bank, compiled from the port map, color order and
+// strip orientation
+struct segment_plan_t {
+  uint8_t port_count; // Number of used ports of the bank
+  bool reversed; // Whether the segment runs from the string's last LED to its first
+  uint8_t block; // Position of the port data, in segments of one bank
+  uint8_t last_string; // String of which the data is received last
+  uint8_t strings[PORT_BANK_SIZE]; // String index for every port
+  uint16_t string_offsets[PORT_BANK_SIZE]; // Frame buffer offset of every port's string
+  uint16_t first_offsets[PORT_BANK_SIZE]; // Frame buffer offset of every port's first LED
+#ifdef PORT_ENCODER_DSP_KERNEL
+  uint64_t used_rows; // Mask of the matrix rows of the used ports
+#endif
+  segment_kernel_t encode_segment; // Kernel for the segment's color order and orientation
+};
+static struct segment_plan_t gather_plan[PLAN_SIZE];
+// Number of planned segments, i.e. the used banks of the segments up to the first unused segment
+static uint8_t plan_length;
+// Kernel for the configured color order
+static led_kernel_t encode_led;
+
+// Copy of the frame data that was last converted, only valid for the mapped strings
+static uint8_t* encoded_source;
+static bool encoded_source_valid;
+
+// Port data buffers
+static uint8_t* port_data[MAX_PORT_DATA_BUFFERS];
+static unsigned int port_data_count;
+// LED positions of every segment at which a buffer doesn't match encoded_source
+static uint64_t stale_leds[MAX_PORT_DATA_BUFFERS][PLAN_SIZE];
+
+// Frame conversion while the frame is being received
+// Next LED position to convert for every segment
+static uint8_t stream_dom[PLAN_SIZE];
+// Whether unchanged LED positions may be skipped
+static bool stream_compare;
+// Port data buffer the stream is converted into
+static unsigned int stream_buffer;
+// Comparing LED positions is only possible if every string is shown at most once
+static bool unique_strings;
+
+// Byte offsets in struct led16_t of the configured colors, in output order
+static ptrdiff_t dither_offsets[sizeof(struct led_t)];
+// Byte offsets in struct led_t and color correction tables of the interpolated colors
+static ptrdiff_t interpolation_offsets[sizeof(struct led_t)];
+static const uint8_t* interpolation_luts[sizeof(struct led_t)];
+
+// Store a 8b×8b matrix as two 32b little-endian integers
+union matrix_t {
+  uint8_t rows[8];
+  struct {
+    uint32_t low;
+    uint32_t high;
+  };
+};
+
+/* Swap bits in a 32b word using XOR operations.
+ * For the two set of bits have that are to be swapped, the first one has to be right shifted on the
+ * position of the second one. The mask then indicates the position of the bits in the second set.
+ * Note that the mask must necessarily also be a shifted version the locations of the first bit set.
+ * Example: To swap bits (31, 20, 15, 13) with bits (18, 7, 2, 0) provide the following values:
+ *  - `shift`: `13`
+ *  - `mask`: `0x00040085` (`0b00000000_00000100_00000000_10000101`)
+ */
+static inline __attribute__((always_inline)) uint32_t swap_bits(
+    uint32_t rows
+  , uint8_t shift
+  , uint32_t mask
+) {
+  uint32_t swapped_bits = (rows ^ (rows >> shift)) & mask;
+  return rows ^ swapped_bits ^ (swapped_bits << shift);
+}
+
+static inline __attribute__((always_inline)) union matrix_t transpose_matrix(union matrix_t m) {
+  /* Transposing a matrix can be done recursively for matrices of size (2^n × 2^n).
+   * 1. Divide the matrix T into four submatrices T[i,j], each of size (2^(n-1) × 2^(n-1)).
+   * 2. Swap T[0,1] and T[1,0].
+   * 3. Repeat steps 1 and 2 for each submatrix until the submatrices have reached size (1×1).
+   *
+   * The following algorithm is applied recursively to swap (blocks of) high and low bits.
+   * Steps 2 and 3 can be combined into one expression for swap_level_2 and swap_level_3.
+   * 1. XOR high bits that into low bits, and mask out all other data
+   * 2. XOR original high data with temp to cancel original low bits and keep high bits
+   * 3. XOR original low data with shifted temp to cancel original high bits and keep low bits
+   *
+   * Bytes can be kept in little-endian representation by rotating around j=7-i axis.
+   * This is equivalent to reversing the byte order before and after the transpose (with axis i=j).
+   *
+   * The original implementation this was based can be found at:
+   *   http://www.hackersdelight.org/hdcodetxt/transpose8.c.txt
+   */
+
+  // Stage 1 swap: 4 (4×4) submatrices
+  uint32_t swapped_bits = ((m.high >> 4) ^ m.low) & 0x0F0F0F0F;
+  m.high = m.high ^ (swapped_bits << 4);
+  m.low = m.low ^ swapped_bits;
+
+  // Stage 2 swap: 16 (2×2) submatrices
+  m.high = swap_bits(m.high, 18, 0x00003333);
+  m.low = swap_bits(m.low, 18, 0x00003333);
+
+  // Stage 3 swap: 64 (1×1) submatrices
+  m.high = swap_bits(m.high, 9, 0x00550055);
+  m.low = swap_bits(m.low, 9, 0x00550055);
+
+  return m;
+}
+
+/* Generic kernels, instantiated for every color order and strip orientation by
+ * DEFINE_COLOR_ORDER_KERNELS(). In every instance the color offsets `c0`, `c1`, `c2` and the LED
+ * step are constants, so the source data is gathered with fixed offsets and the loops can be
+ * unrolled by the compiler.
+ * If `luts` is not NULL, it contains the color correction table of every color in output order,
+ * and every gathered byte is mapped through the table of its color.
+ */
+
+// Read the color at `offset` of an LED, through the color correction table `lut` if there is one
+static inline __attribute__((always_inline)) uint8_t gather(
+    const uint8_t* led
+  , const ptrdiff_t offset
+  , const uint8_t* lut
+) {
+  return lut ? lut[led[offset]] : led[offset];
+}
+
+#ifdef PORT_ENCODER_DSP_KERNEL
+/* Convert one LED position of all ports. Unused ports must point to blank_led, so the matrix rows
+ * can always be gathered into registers without branches, instead of via memory.
+ */
+static inline __attribute__((always_inline)) void encode_block(
+    const uint8_t* const* leds
+  , union matrix_t* output
+  , const ptrdiff_t c0
+  , const ptrdiff_t c1
+  , const ptrdiff_t c2
+  , const uint8_t* const* luts
+  , const uint64_t used_rows
+) {
+  const ptrdiff_t color_offset[sizeof(struct led_t)] = {c0, c1, c2};
+  for (unsigned int color = 0; color < sizeof(struct led_t); ++color) {
+    const ptrdiff_t offset = color_offset[color];
+    const uint8_t* lut = luts ? luts[color] : NULL;
+    // Row `PORT_BANK_SIZE-1 - port` contains the data of `port`, see encode_segment_leds()
+    union matrix_t m;
+    m.low = pack_halfwords(
+        gather(leds[7], offset, lut) | (gather(leds[6], offset, lut) << 8)
+      , gather(leds[5], offset, lut) | (gather(leds[4], offset, lut) << 8)
+    );
+    m.high = pack_halfwords(
+        gather(leds[3], offset, lut) | (gather(leds[2], offset, lut) << 8)
+      , gather(leds[1], offset, lut) | (gather(leds[0], offset, lut) << 8)
+    );
+    if (luts) {
+      // The table may not map the blank LED of unused ports to zero
+      m.low &= (uint32_t) used_rows;
+      m.high &= (uint32_t) (used_rows >> 32);
+    }
+    output[color] = transpose_matrix(m);
+  }
+}
+#endif
+
+static inline __attribute__((always_inline)) void encode_segment_leds(
+    const uint8_t* restrict src
+  , const struct segment_plan_t* plan
+  , union matrix_t* restrict output
+  , const ptrdiff_t c0
+  , const ptrdiff_t c1
+  , const ptrdiff_t c2
+  , const ptrdiff_t led_step
+  , const uint8_t* const* luts
+) {
+  // Perform a linear write to the output buffer, at the expense of having to jump around
+  // the input buffer *a lot*.
+  const uint8_t used_port_count = plan->port_count;
+
+  // Current reading positions for all ports
+  const uint8_t* input[PORT_BANK_SIZE];
+  for (unsigned int port = 0; port < used_port_count; ++port) {
+    input[port] = src + plan->first_offsets[port];
+  }
+
+#ifdef PORT_ENCODER_DSP_KERNEL
+  for (unsigned int port = used_port_count; port < PORT_BANK_SIZE; ++port) {
+    input[port] = blank_led;
+  }
+
+  for (unsigned int led = 0; led < STRING_LENGTH; ++led) {
+    encode_block(input, output, c0, c1, c2, luts, plan->used_rows);
+    output += sizeof(struct led_t);
+    for (unsigned int port = 0; port < used_port_count; ++port) {
+      input[port] += led_step;
+    }
+  }
+#else
+  const ptrdiff_t color_offset[sizeof(struct led_t)] = {c0, c1, c2};
+
+  // Shuffle LED data from USB buffer format to OctoWS2811 format
+  for (unsigned int led = 0; led < STRING_LENGTH; ++led) {
+    for (unsigned int color = 0; color < sizeof(struct led_t); ++color) {
+      // Gather data for all ports, unused ports are kept low
+      union matrix_t m = {.rows = {0}};
+
+      const uint8_t* lut = luts ? luts[color] : NULL;
+      for (unsigned int port = 0; port < used_port_count; ++port) {
+        // Copy 8 data bytes for the current color
+        m.rows[PORT_BANK_SIZE-1 - port] = gather(input[port], color_offset[color], lut);
+      }
+
+      // Transpose bytes to correct output format
+      *output = transpose_matrix(m);
+      output++;
+    }
+
+    // Jump to the next LED
+    for (unsigned int port = 0; port < used_port_count; ++port) {
+      input[port] += led_step;
+    }
+  }
+#endif
+}
+
+static inline __attribute__((always_inline)) void encode_led_colors(
+    const uint8_t* restrict src
+  , const struct segment_plan_t* plan
+  , unsigned int dom
+  , union matrix_t* restrict output
+  , const ptrdiff_t c0
+  , const ptrdiff_t c1
+  , const ptrdiff_t c2
+  , const uint8_t* const* luts
+) {
+#ifdef PORT_ENCODER_DSP_KERNEL
+  const uint8_t* leds[PORT_BANK_SIZE];
+  for (unsigned int port = 0; port < PORT_BANK_SIZE; ++port) {
+    if (port < plan->port_count) {
+      leds[port] = src + plan->string_offsets[port] + BUFFER_STEP*dom;
+    }
+    else {
+      leds[port] = blank_led;
+    }
+  }
+  encode_block(leds, output, c0, c1, c2, luts, plan->used_rows);
+#else
+  const ptrdiff_t color_offset[sizeof(struct led_t)] = {c0, c1, c2};
+  for (unsigned int color = 0; color < sizeof(struct led_t); ++color) {
+    union matrix_t m = {.rows = {0}};
+    const uint8_t* lut = luts ? luts[color] : NULL;
+    for (unsigned int port = 0; port < plan->port_count; ++port) {
+      const uint8_t* led = src + plan->string_offsets[port] + BUFFER_STEP*dom;
+      m.rows[PORT_BANK_SIZE-1 - port] = gather(led, color_offset[color], lut);
+    }
+    output[color] = transpose_matrix(m);
+  }
+#endif
+}
+
+/* RAM_L also holds the port data, so only the kernels of the color order selected with
+ * PORT_ENCODER_RAM_ORDER_<order> are placed in RAM. The kernels of the other orders run from flash.
+ */
+#ifdef PORT_ENCODER_RAM_ORDER_RGB
+#define KERNEL_RGB KERNEL
+#else
+#define KERNEL_RGB FLASH_KERNEL
+#endif
+#ifdef PORT_ENCODER_RAM_ORDER_BRG
+#define KERNEL_BRG KERNEL
+#else
+#define KERNEL_BRG FLASH_KERNEL
+#endif
+#ifdef PORT_ENCODER_RAM_ORDER_GBR
+#define KERNEL_GBR KERNEL
+#else
+#define KERNEL_GBR FLASH_KERNEL
+#endif
+#ifdef PORT_ENCODER_RAM_ORDER_BGR
+#define KERNEL_BGR KERNEL
+#else
+#define KERNEL_BGR FLASH_KERNEL
+#endif
+#ifdef PORT_ENCODER_RAM_ORDER_RBG
+#define KERNEL_RBG KERNEL
+#else
+#define KERNEL_RBG FLASH_KERNEL
+#endif
+#ifdef PORT_ENCODER_RAM_ORDER_GRB
+#define KERNEL_GRB KERNEL
+#else
+#define KERNEL_GRB FLASH_KERNEL
+#endif
+
+// Instantiate the kernels for a color order, given as the colors in output order
+#define DEFINE_COLOR_ORDER_KERNELS(order, first, second, third) \
+  static KERNEL_##order void encode_segment_forward_##order( \
+      const uint8_t* restrict src \
+    , const struct segment_plan_t* plan \
+    , union matrix_t* restrict output \
+  ) { \
+    encode_segment_leds( \
+        src, plan, output \
+      , OFFSET_##first, OFFSET_##second, OFFSET_##third \
+      , (ptrdiff_t) BUFFER_STEP, NULL \
+    ); \
+  } \
+  static KERNEL_##order void encode_segment_reversed_##order( \
+      const uint8_t* restrict src \
+    , const struct segment_plan_t* plan \
+    , union matrix_t* restrict output \
+  ) { \
+    encode_segment_leds( \
+        src, plan, output \
+      , OFFSET_##first, OFFSET_##second, OFFSET_##third \
+      , -(ptrdiff_t) BUFFER_STEP, NULL \
+    ); \
+  } \
+  static KERNEL_##order void encode_led_##order( \
+      const uint8_t* restrict src \
+    , const struct segment_plan_t* plan \
+    , unsigned int dom \
+    , union matrix_t* restrict output \
+  ) { \
+    encode_led_colors( \
+        src, plan, dom, output \
+      , OFFSET_##first, OFFSET_##second, OFFSET_##third \
+      , NULL \
+    ); \
+  }
+
+DEFINE_COLOR_ORDER_KERNELS(RGB, RED, GREEN, BLUE)
+DEFINE_COLOR_ORDER_KERNELS(BRG, BLUE, RED, GREEN)
+DEFINE_COLOR_ORDER_KERNELS(GBR, GREEN, BLUE, RED)
+DEFINE_COLOR_ORDER_KERNELS(BGR, BLUE, GREEN, RED)
+DEFINE_COLOR_ORDER_KERNELS(RBG, RED, BLUE, GREEN)
+DEFINE_COLOR_ORDER_KERNELS(GRB, GREEN, RED, BLUE)
+
+// Offsets in struct led_t of the configured colors, in output order
+static ptrdiff_t lut_offsets[sizeof(struct led_t)];
+// Color correction tables of the configured colors, in output order
+static const uint8_t* lut_rows[sizeof(struct led_t)];
+
+/* Kernels with color correction. The color offsets are not constant, so a single instance can
+ * serve all color orders, which limits the size of the RAM resident code.
+ */
+static KERNEL void encode_segment_forward_lut(
+    const uint8_t* restrict src
+  , const struct segment_plan_t* plan
+  , union matrix_t* restrict output
+) {
+  encode_segment_leds(
+      src, plan, output
+    , lut_offsets[0], lut_offsets[1], lut_offsets[2]
+    , (ptrdiff_t) BUFFER_STEP, lut_rows
+  );
+}
+
+static KERNEL void encode_segment_reversed_lut(
+    const uint8_t* restrict src
+  , const struct segment_plan_t* plan
+  , union matrix_t* restrict output
+) {
+  encode_segment_leds(
+      src, plan, output
+    , lut_offsets[0], lut_offsets[1], lut_offsets[2]
+    , -(ptrdiff_t) BUFFER_STEP, lut_rows
+  );
+}
+
+static KERNEL void encode_led_lut(
+    const uint8_t* restrict src
+  , const struct segment_plan_t* plan
+  , unsigned int dom
+  , union matrix_t* restrict output
+) {
+  encode_led_colors(
+      src, plan, dom, output
+    , lut_offsets[0], lut_offsets[1], lut_offsets[2]
+    , lut_rows
+  );
+}
+
+// Kernels and colors of a color order
+struct color_order_kernels_t {
+  segment_kernel_t forward;
+  segment_kernel_t reversed;
+  led_kernel_t led;
+  ptrdiff_t offsets[sizeof(struct led_t)];
+  uint8_t channels[sizeof(struct led_t)];
+  ptrdiff_t offsets_16[sizeof(struct led_t)];
+};
+
+#define COLOR_ORDER_KERNELS(order, first, second, third) [LED_ORDER_##order] = { \
+    encode_segment_forward_##order \
+  , encode_segment_reversed_##order \
+  , encode_led_##order \
+  , {OFFSET_##first, OFFSET_##second, OFFSET_##third} \
+  , {COLOR_LUT_##first, COLOR_LUT_##second, COLOR_LUT_##third} \
+  , {OFFSET16_##first, OFFSET16_##second, OFFSET16_##third} \
+}
+
+static const struct color_order_kernels_t KERNELS[] = {
+    COLOR_ORDER_KERNELS(RGB, RED, GREEN, BLUE)
+  , COLOR_ORDER_KERNELS(BRG, BLUE, RED, GREEN)
+  , COLOR_ORDER_KERNELS(GBR, GREEN, BLUE, RED)
+  , COLOR_ORDER_KERNELS(BGR, BLUE, GREEN, RED)
+  , COLOR_ORDER_KERNELS(RBG, RED, BLUE, GREEN)
+  , COLOR_ORDER_KERNELS(GRB, GREEN, RED, BLUE)
+};
+
+void init_port_encoder(
+    enum display_led_color_order_t color_order
+  , const uint8_t* color_lut
+  , bool reverse_first
+  , const struct port_map_t* port_map
+  , uint8_t* source_copy
+  , uint8_t* const* buffers
+  , unsigned int buffer_count
+) {
+  // Select the kernels for the color order, defaulting to RGB
+  const struct color_order_kernels_t* kernels = &KERNELS[LED_ORDER_RGB];
+  if ((unsigned int) color_order < sizeof(KERNELS)/sizeof(KERNELS[0])) {
+    kernels = &KERNELS[color_order];
+  }
+  segment_kernel_t encode_forward = kernels->forward;
+  segment_kernel_t encode_reversed = kernels->reversed;
+  encode_led = kernels->led;
+  for (unsigned int color = 0; color < sizeof(struct led_t); ++color) {
+    dither_offsets[color] = kernels->offsets_16[color];
+    interpolation_offsets[color] = kernels->offsets[color];
+    interpolation_luts[color] = color_lut
+      ? color_lut + COLOR_LUT_LENGTH*kernels->channels[color]
+      : NULL;
+  }
+  if (color_lut) {
+    for (unsigned int color = 0; color < sizeof(struct led_t); ++color) {
+      lut_offsets[color] = kernels->offsets[color];
+      lut_rows[color] = color_lut + COLOR_LUT_LENGTH*kernels->channels[color];
+    }
+    encode_forward = encode_segment_forward_lut;
+    encode_reversed = encode_segment_reversed_lut;
+    encode_led = encode_led_lut;
+  }
+
+  // Compile the port map into the gather plan. Segments following a segment without used ports,
+  // or with an invalid port count, are not converted. Banks without used ports are skipped.
+  uint64_t used_strings = 0;
+  unique_strings = true;
+  plan_length = 0;
+  for (unsigned int segment = 0; segment < SEGMENT_COUNT; ++segment) {
+    const struct port_map_t* segment_map = &port_map[segment];
+    if (segment_map->ports_length == 0 || segment_map->ports_length > MAX_PORT_COUNT) {
+      break;
+    }
+
+    // Reverse even segments if first one is reversed, otherwise reverse odd segments.
+    // rF\E| 0 1
+    // ---------
+    //   0 | 1 0
+    //   1 | 0 1
+    const bool is_even = (segment % 2) == 0;
+    const bool reversed = reverse_first == is_even;
+    const size_t first_led = reversed ? (STRING_LENGTH-1)*BUFFER_STEP : 0;
+
+    for (unsigned int bank = 0; PORT_BANK_SIZE*bank < segment_map->ports_length; ++bank) {
+      const uint8_t* bank_ports = &segment_map->ports[PORT_BANK_SIZE*bank];
+      const unsigned int remaining = segment_map->ports_length - PORT_BANK_SIZE*bank;
+
+      struct segment_plan_t* plan = &gather_plan[plan_length];
+      plan->port_count = remaining < PORT_BANK_SIZE ? remaining : PORT_BANK_SIZE;
+      plan->reversed = reversed;
+      plan->block = SEGMENT_COUNT*bank + segment;
+      plan->encode_segment = plan->reversed ? encode_reversed : encode_forward;
+#ifdef PORT_ENCODER_DSP_KERNEL
+      plan->used_rows = UINT64_MAX << 8*(PORT_BANK_SIZE - plan->port_count);
+#endif
+
+      plan->last_string = 0;
+      for (unsigned int port = 0; port < plan->port_count; ++port) {
+        const uint8_t string = bank_ports[port];
+        plan->strings[port] = string;
+        plan->string_offsets[port] = STRING_SIZE*string;
+        plan->first_offsets[port] = STRING_SIZE*string + first_led;
+        if (string > plan->last_string) {
+          plan->last_string = string;
+        }
+        if (string < MAX_TRACKED_STRING_COUNT) {
+          const uint64_t string_mask = UINT64_C(1) << string;
+          unique_strings = unique_strings && !(used_strings & string_mask);
+          used_strings |= string_mask;
+        }
+      }
+
+      plan_length++;
+    }
+  }
+
+  // The port data has to be regenerated completely for the new configuration
+  encoded_source = source_copy;
+  encoded_source_valid = false;
+
+  port_data_count = buffer_count < MAX_PORT_DATA_BUFFERS ? buffer_count : MAX_PORT_DATA_BUFFERS;
+  for (unsigned int buffer = 0; buffer < port_data_count; ++buffer) {
+    port_data[buffer] = buffers[buffer];
+    for (unsigned int segment = 0; segment < PLAN_SIZE; ++segment) {
+      stale_leds[buffer][segment] = ALL_LEDS;
+    }
+  }
+
+  // Nothing to convert until encode_stream_start() is called
+  for (unsigned int segment = 0; segment < PLAN_SIZE; ++segment) {
+    stream_dom[segment] = STRING_LENGTH;
+  }
+}
+
+// Record that the LED positions `leds` of a segment were converted into `buffer`
+static inline void mark_converted(unsigned int buffer, unsigned int segment, uint64_t leds) {
+  for (unsigned int other = 0; other < port_data_count; ++other) {
+    if (other == buffer) {
+      stale_leds[other][segment] &= ~leds;
+    }
+    else {
+      stale_leds[other][segment] |= leds;
+    }
+  }
+}
+
+void encode_frame(const uint8_t* restrict src, unsigned int buffer) {
+  for (unsigned int segment = 0; segment < plan_length; ++segment) {
+    const struct segment_plan_t* plan = &gather_plan[segment];
+    union matrix_t* output = (union matrix_t*) port_data[buffer] + SEGMENT_MATRICES*plan->block;
+
+    for (unsigned int port = 0; port < plan->port_count; ++port) {
+      if (encoded_source && plan->strings[port] < MAX_TRACKED_STRING_COUNT) {
+        const uint16_t offset = plan->string_offsets[port];
+        memcpy(encoded_source + offset, src + offset, STRING_SIZE);
+      }
+    }
+
+    plan->encode_segment(src, plan, output);
+
+    mark_converted(buffer, segment, ALL_LEDS);
+  }
+
+  encoded_source_valid = encoded_source != NULL;
+}
+
+void encode_frame_changes(const uint8_t* restrict src, unsigned int buffer) {
+  if (!encoded_source_valid) {
+    encode_frame(src, buffer);
+    return;
+  }
+
+  uint64_t changed_strings = 0;
+
+  for (unsigned int segment = 0; segment < plan_length; ++segment) {
+    const struct segment_plan_t* plan = &gather_plan[segment];
+    union matrix_t* output = (union matrix_t*) port_data[buffer] + SEGMENT_MATRICES*plan->block;
+
+    // Find the LED positions at which any of the segment's strings has changed, or of which the
+    // buffer holds the data of an older frame
+    uint64_t changed_leds = stale_leds[buffer][segment];
+    for (unsigned int port = 0; port < plan->port_count; ++port) {
+      const uint8_t string = plan->strings[port];
+      if (string >= MAX_TRACKED_STRING_COUNT) {
+        changed_leds = ALL_LEDS;
+        continue;
+      }
+      const uint64_t string_mask = UINT64_C(1) << string;
+      const uint8_t* current = src + plan->string_offsets[port];
+      const uint8_t* previous = encoded_source + plan->string_offsets[port];
+      // Most strings don't change at all, so first compare them as a whole
+      if (memcmp(current, previous, STRING_SIZE) == 0) {
+        continue;
+      }
+      changed_strings |= string_mask;
+      for (unsigned int dom = 0; dom < STRING_LENGTH; ++dom) {
+        if (memcmp(current + BUFFER_STEP*dom, previous + BUFFER_STEP*dom, BUFFER_STEP) != 0) {
+          changed_leds |= UINT64_C(1) << dom;
+        }
+      }
+    }
+
+    // Convert the changed LED positions
+    mark_converted(buffer, segment, changed_leds);
+    for (unsigned int dom = 0; changed_leds; ++dom, changed_leds >>= 1) {
+      if (changed_leds & 1) {
+        const unsigned int position = plan->reversed ? STRING_LENGTH-1 - dom : dom;
+        encode_led(src, plan, dom, output + sizeof(struct led_t)*position);
+      }
+    }
+  }
+
+  // Only update the copy after all segments are converted, since strings may be used repeatedly
+  for (unsigned int string = 0; changed_strings; ++string, changed_strings >>= 1) {
+    if (changed_strings & 1) {
+      memcpy(encoded_source + STRING_SIZE*string, src + STRING_SIZE*string, STRING_SIZE);
+    }
+  }
+}
+
+// Check if the LED at position `dom` of any of the segment's strings differs from encoded_source
+static inline bool led_changed(
+    const uint8_t* restrict src
+  , const struct segment_plan_t* plan
+  , unsigned int dom
+) {
+  for (unsigned int port = 0; port < plan->port_count; ++port) {
+    if (plan->strings[port] >= MAX_TRACKED_STRING_COUNT) {
+      return true;
+    }
+    const size_t offset = plan->string_offsets[port] + BUFFER_STEP*dom;
+    if (memcmp(src + offset, encoded_source + offset, BUFFER_STEP) != 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Copy the LED at position `dom` of the segment's strings to encoded_source
+static inline void store_led(
+    const uint8_t* restrict src
+  , const struct segment_plan_t* plan
+  , unsigned int dom
+) {
+  for (unsigned int port = 0; port < plan->port_count; ++port) {
+    if (plan->strings[port] < MAX_TRACKED_STRING_COUNT) {
+      const size_t offset = plan->string_offsets[port] + BUFFER_STEP*dom;
+      memcpy(encoded_source + offset, src + offset, BUFFER_STEP);
+    }
+  }
+}
+
+void encode_stream_start(unsigned int buffer) {
+  for (unsigned int segment = 0; segment < PLAN_SIZE; ++segment) {
+    stream_dom[segment] = 0;
+  }
+  stream_compare = encoded_source_valid && unique_strings;
+  stream_buffer = buffer;
+}
+
+bool encode_stream_update(const uint8_t* src, size_t received) {
+  bool done = true;
+
+  for (unsigned int segment = 0; segment < plan_length; ++segment) {
+    const struct segment_plan_t* plan = &gather_plan[segment];
+    union matrix_t* output =
+      (union matrix_t*) port_data[stream_buffer] + SEGMENT_MATRICES*plan->block;
+
+    // Strings are received in order, so an LED position is complete when it is received for
+    // the segment's last string
+    const size_t last_string_offset = STRING_SIZE*plan->last_string;
+    unsigned int dom = stream_dom[segment];
+    while (dom < STRING_LENGTH && last_string_offset + BUFFER_STEP*(dom+1) <= received) {
+      const uint64_t led_mask = UINT64_C(1) << dom;
+      if (
+          !stream_compare
+          || (stale_leds[stream_buffer][segment] & led_mask)
+          || led_changed(src, plan, dom)
+      ) {
+        const unsigned int position = plan->reversed ? STRING_LENGTH-1 - dom : dom;
+        encode_led(src, plan, dom, output + sizeof(struct led_t)*position);
+        // Keep the copy consistent with the port data, in case the stream is abandoned
+        if (encoded_source) {
+          store_led(src, plan, dom);
+        }
+        mark_converted(stream_buffer, segment, led_mask);
+      }
+      ++dom;
+    }
+    stream_dom[segment] = dom;
+    done = done && dom == STRING_LENGTH;
+  }
+
+  if (done && encoded_source) {
+    encoded_source_valid = true;
+  }
+  return done;
+}
+
+
+/* TEMPORAL DITHERING
+ * The dithering state is stored per LED position of a segment, in the same order as the port
+ * data. The matrix rows of every color are updated as 32b words, four ports at a time, after which
+ * the resulting 8 bit values are transposed as usual.
+ */
+
+// Dithering state of one LED position of all ports, for every color in output order
+struct dither_block_t {
+  union matrix_t value[sizeof(struct led_t)]; // 8 most significant bits of the colors
+  union matrix_t fraction[sizeof(struct led_t)]; // 8 least significant bits of the colors
+  union matrix_t error[sizeof(struct led_t)]; // Accumulated fractions
+};
+
+static struct dither_block_t* dither_state;
+
+// Step between the initial errors of consecutive colors. Close to 256 divided by the golden ratio,
+// and odd so all 256 values are used.
+#define ERROR_SPREAD 159
+
+#if defined(PORT_ENCODER_DSP_KERNEL) && defined(__ARM_FEATURE_DSP)
+// Add `fraction` to every byte of `error`, and return 1 in every byte that overflowed
+static inline uint32_t accumulate_error(uint32_t* error, uint32_t fraction) {
+  uint32_t sum, carries;
+  __asm__ (
+      "uadd8 %0, %2, %3\n\t"
+      "sel %1, %4, %5"
+    : "=&r" (sum), "=r" (carries)
+    : "r" (*error), "r" (fraction), "r" (0x01010101), "r" (0)
+    : "cc"
+  );
+  *error = sum;
+  return carries;
+}
+
+// Add the carries to every byte of `value`, saturating at 255
+static inline uint32_t add_carries(uint32_t value, uint32_t carries) {
+  uint32_t sum;
+  __asm__ ("uqadd8 %0, %1, %2" : "=r" (sum) : "r" (value), "r" (carries));
+  return sum;
+}
+#else
+// Equivalents of UADD8/SEL and UQADD8, without carries between the bytes
+static inline uint32_t accumulate_error(uint32_t* error, uint32_t fraction) {
+  const uint32_t previous = *error;
+  const uint32_t sum = ((previous & 0x7F7F7F7F) + (fraction & 0x7F7F7F7F))
+    ^ ((previous ^ fraction) & 0x80808080);
+  *error = sum;
+  // A byte overflows if both top bits are set, or if one is set and the top bit of the sum isn't
+  return (((previous & fraction) | ((previous | fraction) & ~sum)) >> 7) & 0x01010101;
+}
+
+static inline uint32_t add_carries(uint32_t value, uint32_t carries) {
+  // Top bit of every byte that is 255
+  const uint32_t full = ((value & 0x7F7F7F7F) + 0x01010101) & value & 0x80808080;
+  return value + (carries & ~(full >> 7));
+}
+#endif
+
+static KERNEL void encode_dither_blocks(
+    struct dither_block_t* restrict block
+  , union matrix_t* restrict output
+  , unsigned int count
+) {
+  for (; count; --count, ++block) {
+    for (unsigned int color = 0; color < sizeof(struct led_t); ++color) {
+      union matrix_t m;
+      uint32_t carries = accumulate_error(&block->error[color].low, block->fraction[color].low);
+      m.low = add_carries(block->value[color].low, carries);
+      carries = accumulate_error(&block->error[color].high, block->fraction[color].high);
+      m.high = add_carries(block->value[color].high, carries);
+      *output++ = transpose_matrix(m);
+    }
+  }
+}
+
+void init_port_dither(uint8_t* state) {
+  dither_state = (struct dither_block_t*) state;
+  memset(state, 0, DITHER_STATE_SIZE);
+
+  // Spread out the initial errors, so LEDs with the same fraction don't all change on the same
+  // refresh
+  uint8_t error = 0;
+  for (unsigned int block = 0; block < PLAN_SIZE*STRING_LENGTH; ++block) {
+    for (unsigned int color = 0; color < sizeof(struct led_t); ++color) {
+      for (unsigned int row = 0; row < PORT_BANK_SIZE; ++row) {
+        dither_state[block].error[color].rows[row] = error;
+        error += ERROR_SPREAD;
+      }
+    }
+  }
+
+  // The port data will no longer match the copy of the last converted 8 bit frame
+  encoded_source_valid = false;
+}
+
+void load_dither_frame(const uint8_t* restrict src) {
+  for (unsigned int segment = 0; segment < plan_length; ++segment) {
+    const struct segment_plan_t* plan = &gather_plan[segment];
+    struct dither_block_t* block = dither_state + STRING_LENGTH*segment;
+
+    for (unsigned int position = 0; position < STRING_LENGTH; ++position, ++block) {
+      const unsigned int dom = plan->reversed ? STRING_LENGTH-1 - position : position;
+      for (unsigned int port = 0; port < plan->port_count; ++port) {
+        const uint8_t* led = src + STRING_SIZE_16*plan->strings[port] + sizeof(struct led16_t)*dom;
+        const unsigned int row = PORT_BANK_SIZE-1 - port;
+        for (unsigned int color = 0; color < sizeof(struct led_t); ++color) {
+          // Colors are little-endian
+          const uint8_t* value = led + dither_offsets[color];
+          block->fraction[color].rows[row] = value[0];
+          block->value[color].rows[row] = value[1];
+        }
+      }
+    }
+  }
+}
+
+void encode_dither_refresh(unsigned int buffer) {
+  for (unsigned int segment = 0; segment < plan_length; ++segment) {
+    encode_dither_blocks(
+        dither_state + STRING_LENGTH*segment
+      , (union matrix_t*) port_data[buffer] + SEGMENT_MATRICES*gather_plan[segment].block
+      , STRING_LENGTH
+    );
+  }
+}
+
+
+/* FRAME INTERPOLATION
+ * Like the dithering state, the colors of the previous and current frame are stored per LED
+ * position of a segment, in output order. The weighted average of four ports is calculated at once,
+ * by splitting the bytes of a 32b word into two words with 16b lanes. The products of an 8 bit
+ * color and a weight of at most 256 then never carry into the next lane.
+ */
+
+// Colors of the previous and current frame of one LED position of all ports, in output order
+struct interpolation_block_t {
+  union matrix_t previous[sizeof(struct led_t)];
+  union matrix_t current[sizeof(struct led_t)];
+};
+
+static struct interpolation_block_t* interpolation_state;
+
+// Rounded weighted average of every byte of `previous` and `current`, with weights
+// `256-weight` and `weight` respectively
+static inline uint32_t blend_bytes(uint32_t previous, uint32_t current, uint32_t weight) {
+  const uint32_t inverse = INTERPOLATION_WEIGHT_MAX - weight;
+  const uint32_t even = (previous & 0x00FF00FF)*inverse + (current & 0x00FF00FF)*weight;
+  const uint32_t odd = ((previous >> 8) & 0x00FF00FF)*inverse + ((current >> 8) & 0x00FF00FF)*weight;
+  return (((even + 0x00800080) >> 8) & 0x00FF00FF) | ((odd + 0x00800080) & 0xFF00FF00);
+}
+
+// Look up every byte of `word` in a color correction table
+static inline uint32_t correct_bytes(const uint8_t* lut, uint32_t word) {
+  return lut[word & 0xFF]
+    | (uint32_t) lut[(word >> 8) & 0xFF] << 8
+    | (uint32_t) lut[(word >> 16) & 0xFF] << 16
+    | (uint32_t) lut[word >> 24] << 24;
+}
+
+static KERNEL void encode_interpolated_segment(
+    const struct interpolation_block_t* restrict block
+  , union matrix_t* restrict output
+  , uint64_t used_rows
+  , uint32_t weight
+) {
+  for (unsigned int position = 0; position < STRING_LENGTH; ++position, ++block) {
+    for (unsigned int color = 0; color < sizeof(struct led_t); ++color) {
+      union matrix_t m;
+      m.low = blend_bytes(block->previous[color].low, block->current[color].low, weight);
+      m.high = blend_bytes(block->previous[color].high, block->current[color].high, weight);
+      // Unused ports have to remain dark after color correction
+      const uint8_t* lut = interpolation_luts[color];
+      if (lut) {
+        m.low = correct_bytes(lut, m.low) & (uint32_t) used_rows;
+        m.high = correct_bytes(lut, m.high) & (uint32_t) (used_rows >> 32);
+      }
+      *output++ = transpose_matrix(m);
+    }
+  }
+}
+
+void init_port_interpolation(uint8_t* state) {
+  interpolation_state = (struct interpolation_block_t*) state;
+  memset(state, 0, INTERPOLATION_STATE_SIZE);
+
+  // The port data will no longer match the copy of the last converted frame
+  encoded_source_valid = false;
+}
+
+void load_interpolated_frame(const uint8_t* restrict src) {
+  for (unsigned int segment = 0; segment < plan_length; ++segment) {
+    const struct segment_plan_t* plan = &gather_plan[segment];
+    struct interpolation_block_t* block = interpolation_state + STRING_LENGTH*segment;
+
+    for (unsigned int position = 0; position < STRING_LENGTH; ++position, ++block) {
+      memcpy(block->previous, block->current, sizeof(block->previous));
+      const unsigned int dom = plan->reversed ? STRING_LENGTH-1 - position : position;
+      for (unsigned int port = 0; port < plan->port_count; ++port) {
+        const uint8_t* led = src + plan->string_offsets[port] + BUFFER_STEP*dom;
+        const unsigned int row = PORT_BANK_SIZE-1 - port;
+        for (unsigned int color = 0; color < sizeof(struct led_t); ++color) {
+          block->current[color].rows[row] = led[interpolation_offsets[color]];
+        }
+      }
+    }
+  }
+}
+
+void encode_interpolated_refresh(unsigned int weight, unsigned int buffer) {
+  if (weight > INTERPOLATION_WEIGHT_MAX) {
+    weight = INTERPOLATION_WEIGHT_MAX;
+  }
+  for (unsigned int segment = 0; segment < plan_length; ++segment) {
+    const struct segment_plan_t* plan = &gather_plan[segment];
+    encode_interpolated_segment(
+        interpolation_state + STRING_LENGTH*segment
+      , (union matrix_t*) port_data[buffer] + SEGMENT_MATRICES*plan->block
+      , UINT64_MAX << 8*(PORT_BANK_SIZE - plan->port_count)
+      , weight
+    );
+  }
+}
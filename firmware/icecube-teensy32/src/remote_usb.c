@@ -7,7 +7,10 @@
 #include "usb/endpoint.h"
 #include "usb/endpoint_0.h"
 #include "usb/remote_renderer.h"
+#include "usb/remote_status.h"
 #include "frame_timer.h"
+#include "display_stream.h"
+#include "trace.h"
 
 #include "kinetis/io.h"
 #include "kinetis/usb_bdt.h"
@@ -68,6 +71,12 @@ bool is_remote_connected() {
 static uint8_t* frame_transfer_queue_pos;
 
 static inline void ep1_queue_remaining(struct frame_transfer_state_t* transfer) {
+  if (transfer->encoding != REMOTE_FRAME_ENCODING_RAW) {
+    // Encoded data is received in the endpoint's buffers, and decoded into the frame buffer
+    while (ep_rx_buffer_push(1, NULL, 0)) {}
+    return;
+  }
+
   // Queue more buffers if we haven't queued all data yet.
   // If we are at the end of the transfer, and the whole frame was queued, don't queue
   // more data until we complete the frame.
@@ -93,6 +102,34 @@ void ep1_init() {
   ep1_queue_remaining(transfer);
 }
 
+// EP2 logic
+// Transmitted from this buffer, so it may only be modified while no report is queued
+static struct remote_status_t status_report;
+
+void ep2_init() {
+  uint8_t bank = get_buffer_bank_count();
+  while (bank--) {
+    get_buffer_descriptor(REMOTE_STATUS_ENDPOINT, BDT_DIR_TX, bank)->desc = 0;
+  }
+  remote_status_init();
+}
+
+static inline bool ep2_tx_idle() {
+  uint8_t bank = get_buffer_bank_count();
+  while (bank--) {
+    if (get_buffer_descriptor(REMOTE_STATUS_ENDPOINT, BDT_DIR_TX, bank)->desc & _BV(BDT_DESC_OWN)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static inline void ep2_queue_status() {
+  if (is_remote_connected() && ep2_tx_idle() && remote_status_poll(&status_report)) {
+    ep_tx_buffer_push(REMOTE_STATUS_ENDPOINT, &status_report, sizeof(status_report));
+  }
+}
+
 // USB event logic
 static inline uint8_t pop_token_status() {
   // Read token status
@@ -119,12 +156,14 @@ static inline bool needs_extra_zlp(struct control_transfer_t* transfer) {
 #define DATA_INTERRUPTS (USB_INTEN_TOKDNEEN | USB_INTEN_SOFTOKEN)
 
 void usb_isr() {
+  TRACE_BEGIN(TRACE_USB_ISR);
   // TODO VBUS transitions?
 
   if (IRQ_ENABLED_AND_SET(SOFTOK)) {
     USB0_ISTAT = USB_ISTAT_SOFTOK;
     uint16_t frame_number = ((USB0_FRMNUMH << 8) | (USB0_FRMNUML)) & 0x7FF;
     new_sof_received(frame_number);
+    ep2_queue_status();
   }
 
   if (IRQ_ENABLED_AND_SET(USBRST)) {
@@ -364,23 +403,43 @@ void usb_isr() {
       struct frame_transfer_state_t* transfer = remote_renderer_get_transfer_state();
       if (transfer->write_pos) {
         const uint16_t transferred = get_byte_count(bdt_entry);
-        const uint16_t transfer_remaining = transfer->buffer_end - transfer->write_pos;
-        const uint16_t copy_len = min(transfer_remaining, transferred);
-        if (transfer->write_pos != bdt_entry->buffer) {
-          memcpy(transfer->write_pos, bdt_entry->buffer, copy_len);
+#ifdef DISPLAY_STREAM_ENCODING
+        if (transfer->write_pos == transfer->frame->buffer) {
+          display_stream_start(transfer->frame);
+        }
+#endif
+        bool overflow = false;
+        bool decode_error = false;
+        if (transfer->encoding == REMOTE_FRAME_ENCODING_RAW) {
+          const uint16_t transfer_remaining = transfer->buffer_end - transfer->write_pos;
+          const uint16_t copy_len = min(transfer_remaining, transferred);
+          if (transfer->write_pos != bdt_entry->buffer) {
+            TRACE_BEGIN(TRACE_USB_COPY);
+            memcpy(transfer->write_pos, bdt_entry->buffer, copy_len);
+            TRACE_END(TRACE_USB_COPY);
+          }
+          transfer->write_pos += copy_len;
+          // Check for overflows if we queued a small packet (max_transfer < ep_size)
+          overflow = USB0_ERRSTAT & USB_ERRSTAT_DMAERR;
+        }
+        else {
+          TRACE_BEGIN(TRACE_USB_COPY);
+          // Runs past the end of the frame are an error, even in a full packet
+          decode_error = !remote_renderer_decode(bdt_entry->buffer, transferred);
+          TRACE_END(TRACE_USB_COPY);
         }
-        transfer->write_pos += copy_len;
 
         bool short_transfer = transferred < get_endpoint_size(1);
-        // Check for overflows if we queued a small packet (max_transfer < ep_size)
-        bool overflow = USB0_ERRSTAT & USB_ERRSTAT_DMAERR;
         // Check for underflows if we received a short packet
         bool not_finished = transfer->buffer_end != transfer->write_pos;
-        if (short_transfer && (overflow || not_finished)) {
+        if (decode_error || (short_transfer && (overflow || not_finished))) {
           // all error flags are cleared at the end of the ISR
           remote_renderer_halt();
         }
         else {
+#ifdef DISPLAY_STREAM_ENCODING
+          display_stream_update(transfer->frame, transfer->write_pos - transfer->frame->buffer);
+#endif
           if (transfer->buffer_end == transfer->write_pos) {
             remote_renderer_transfer_done();
             frame_transfer_queue_pos = transfer->write_pos;
@@ -396,4 +455,5 @@ void usb_isr() {
 
   // Clear all errors
   USB0_ERRSTAT = 0xFF;
+  TRACE_END(TRACE_USB_ISR);
 }
@@ -0,0 +1,185 @@
+#include "render/event_playback.h"
+#include "frame_buffer.h"
+#include <util/atomic.h>
+#include <stddef.h>
+
+static struct event_pulse_t pulses[EVENT_PULSE_CAPACITY];
+
+// Playback settings as requested by the host, loaded by the renderer on a restart
+static struct event_playback_t requested;
+static volatile bool enabled = false;
+static volatile bool restart = false;
+
+// Playback state, only used by the renderer
+static struct event_playback_t playback;
+static const struct event_pulse_t* first_active;
+static const struct event_pulse_t* pulses_end;
+static uint16_t frame_number;
+static bool finished;
+
+struct event_pulse_t* get_event_pulse_upload(uint16_t first, uint16_t count) {
+  stop_event_playback();
+  if (first > EVENT_PULSE_CAPACITY || count > EVENT_PULSE_CAPACITY - first) {
+    return NULL;
+  }
+  return pulses + first;
+}
+
+bool start_event_playback(const struct event_playback_t* settings) {
+  if (settings->pulse_count > EVENT_PULSE_CAPACITY) {
+    return false;
+  }
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    requested = *settings;
+    restart = true;
+    enabled = true;
+  }
+  return true;
+}
+
+void stop_event_playback() {
+  enabled = false;
+}
+
+bool is_event_playback_enabled() {
+  return enabled;
+}
+
+static void rewind_playback() {
+  first_active = pulses;
+  pulses_end = pulses + playback.pulse_count;
+  frame_number = 0;
+  finished = false;
+}
+
+static void load_requested_playback() {
+  bool load = false;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if (restart) {
+      playback = requested;
+      restart = false;
+      load = true;
+    }
+  }
+  if (load) {
+    rewind_playback();
+  }
+}
+
+// Number of rise frames, where a pulse without rise time reaches its peak in its first frame
+static inline uint8_t get_rise_frames() {
+  return playback.rise_frames ? playback.rise_frames : 1;
+}
+
+// Brightness of a pulse, from 0 to 255, depending on the number of frames since its start.
+// The peak is reached in the last rise frame, and the pulse is off in the last decay frame.
+static uint8_t pulse_envelope(uint16_t age) {
+  const uint8_t rise = get_rise_frames();
+  const uint8_t decay = playback.decay_frames;
+  if (age < rise) {
+    return (255*(age+1))/rise;
+  }
+  else if (decay == 0) {
+    return 255;
+  }
+  age -= rise - 1;
+  if (age >= decay) {
+    return 0;
+  }
+  return (255*(decay - age))/decay;
+}
+
+// Add a pulse's color to an LED, saturating at the maximum value
+static void add_pulse(uint8_t* led, const struct event_pulse_t* pulse, uint8_t envelope) {
+  // Write the colors in the format used by rain.c: 8 or 16 bit colors, with an APA102 brightness
+  // byte at its maximum before the colors
+  const uint8_t led_size = get_led_size();
+  const uint8_t color_size = led_size/3;
+  const uint8_t brightness_size = led_size - 3*color_size;
+  const uint32_t level = pulse->brightness*envelope;
+
+  if (brightness_size) {
+    *led++ = 0x1F;
+  }
+  for (uint8_t color = 0; color < 3; ++color, led += color_size) {
+    if (color_size == 2) {
+      // Scale to 16 bits, little-endian
+      uint32_t value = (pulse->color[color]*level*257)/(255*255) + (led[0] | (led[1] << 8));
+      if (value > UINT16_MAX) {
+        value = UINT16_MAX;
+      }
+      led[0] = value;
+      led[1] = value >> 8;
+    }
+    else {
+      uint16_t value = (pulse->color[color]*level)/(255*255) + led[0];
+      led[0] = value > UINT8_MAX ? UINT8_MAX : value;
+    }
+  }
+}
+
+static void start_renderer() {
+  load_requested_playback();
+}
+
+static void stop_renderer() {
+  stop_event_playback();
+}
+
+static struct frame_buffer_t* render_event_playback() {
+  load_requested_playback();
+  // Keep showing the last frame
+  if (finished) {
+    return NULL;
+  }
+
+  struct frame_buffer_t* frame = create_empty_frame();
+  if (!frame) {
+    // Try again on the next frame, so the playback is delayed instead of skipping frames
+    return NULL;
+  }
+  frame->flags = FRAME_FREE_AFTER_DRAW;
+
+  // Pulses are sorted by start frame and have the same duration, so they also end in order
+  if (playback.decay_frames) {
+    const uint32_t duration = get_rise_frames() + playback.decay_frames;
+    while (first_active != pulses_end && first_active->frame + duration <= frame_number) {
+      ++first_active;
+    }
+  }
+
+  const uint8_t led_size = get_led_size();
+  const uint16_t led_count = get_led_count();
+  for (
+    const struct event_pulse_t* pulse = first_active;
+    pulse != pulses_end && pulse->frame <= frame_number;
+    ++pulse
+  ) {
+    const uint8_t envelope = pulse_envelope(frame_number - pulse->frame);
+    if (envelope && pulse->led < led_count) {
+      add_pulse(frame->buffer + pulse->led*led_size, pulse, envelope);
+    }
+  }
+
+  ++frame_number;
+  if (frame_number >= playback.duration) {
+    if (playback.flags & EVENT_PLAYBACK_LOOP) {
+      rewind_playback();
+    }
+    else {
+      finished = true;
+    }
+  }
+
+  return frame;
+}
+
+static const struct renderer_t EVENT_PLAYBACK_RENDERER = {
+    start_renderer
+  , stop_renderer
+  , render_event_playback
+};
+
+const struct renderer_t* get_event_playback_renderer() {
+  return &EVENT_PLAYBACK_RENDERER;
+}
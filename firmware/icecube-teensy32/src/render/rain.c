@@ -24,11 +24,20 @@ struct frame_buffer_t* render_rain() {
     uint8_t* output = frame->buffer;
 
     uint8_t string_count = get_led_count()/60;
+    // Write the most significant byte of the color, which is the last one for 16 bit colors.
+    // APA102 LEDs have a brightness byte before the colors, which is set to its maximum.
+    const uint8_t led_size = get_led_size();
+    const uint8_t color_size = led_size/3;
+    const uint8_t brightness_size = led_size - 3*color_size;
+    const uint8_t color_offset = brightness_size + color_size*(color+1) - 1;
 
     for (unsigned string = 0; string < string_count; string++) {
       for (unsigned dom = dom_index; dom < 60; dom+=DOM_SPACING) {
-        ptrdiff_t buffer_offset = (string*60 + dom)*sizeof(struct led_t);
-        output[buffer_offset+color] = (1<<4);
+        ptrdiff_t buffer_offset = (string*60 + dom)*led_size;
+        if (brightness_size) {
+          output[buffer_offset] = 0x1F;
+        }
+        output[buffer_offset+color_offset] = (1<<4);
       }
     }
   }
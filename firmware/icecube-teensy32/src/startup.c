@@ -49,6 +49,8 @@ extern unsigned long _stext;
 extern unsigned long _etext;
 extern unsigned long _sdata;
 extern unsigned long _edata;
+extern unsigned long _sfastrun;
+extern unsigned long _efastrun;
 extern unsigned long _sbss;
 extern unsigned long _ebss;
 extern unsigned long _estack;
@@ -756,6 +758,9 @@ void ResetHandler(void)
     
 	// TODO: do this while the PLL is waiting to lock....
 	while (dest < &_edata) *dest++ = *src++;
+	// .fastrun is loaded directly after .data
+	dest = &_sfastrun;
+	while (dest < &_efastrun) *dest++ = *src++;
 	dest = &_sbss;
 	while (dest < &_ebss) *dest++ = 0;
 
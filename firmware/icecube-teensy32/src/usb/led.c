@@ -2,6 +2,7 @@
 
 #include "kinetis/io.h"
 #include "kinetis/pit.h"
+#include "trace.h"
 
 #include <stdbool.h>
 #include <stdint.h>
@@ -12,12 +13,17 @@ static enum led_mode_t led_mode;
 static bool led_tripped;
 static bool interval_end;
 
+// With two port banks, the LED pin (C5) is used to write to the LED strips instead
 static inline void set_led_on() {
+#if defined(DEVICE_HAS_USB_LED) && DEVICE_HAS_USB_LED
   GPIOC_PSOR = _BV(5);
+#endif
 }
 
 static inline void set_led_off() {
+#if defined(DEVICE_HAS_USB_LED) && DEVICE_HAS_USB_LED
   GPIOC_PCOR = _BV(5);
+#endif
 }
 
 #define INTERVALS_PER_SECOND 10
@@ -40,10 +46,12 @@ static void enable_timer(uint8_t interval_count) {
 }
 
 void init_led() {
+#if defined(DEVICE_HAS_USB_LED) && DEVICE_HAS_USB_LED
   // Ensure PORTC_PCR5 is configured for GPIO output
   ATOMIC_REGISTER_BIT_SET(SIM_SCGC5, 11); // Enable port C clock
   ATOMIC_REGISTER_BIT_SET(GPIOC_PDDR, 5); // Configure C5 as output
   PORTC_PCR5 = (1<<8); // GPIO mode
+#endif
 
   // Enable PIT module
   enable_pit_module();
@@ -75,6 +83,7 @@ void trip_led() {
 }
 
 void pit1_isr() {
+  TRACE_BEGIN(TRACE_USB_LED_ISR);
   pit_channels[1].TFLG = 1;
 
   if (interval_end) {
@@ -90,4 +99,5 @@ void pit1_isr() {
   }
 
   interval_end = !interval_end;
+  TRACE_END(TRACE_USB_LED_ISR);
 }
@@ -13,6 +13,7 @@
 #include "frame_buffer.h"
 #include "frame_queue.h"
 #include "frame_timer.h"
+#include "trace.h"
 
 enum display_state_t {
     DISPLAY_STATE_BOOT = 0
@@ -119,7 +120,9 @@ static inline void advance_display_state() {
 
 static inline void consume_frame(struct frame_buffer_t* frame) {
   if (frame && frame->buffer) {
+    TRACE_BEGIN(TRACE_DISPLAY_FRAME);
     display_frame(frame);
+    TRACE_END(TRACE_DISPLAY_FRAME);
     if (frame->flags & FRAME_FREE_AFTER_DRAW) {
       destroy_frame(frame);
     }
@@ -157,12 +160,20 @@ int main () {
       sleep_cpu();
     }
 
-    consume_frame(pop_frame());
+    struct display_frame_usb_phase_t frame_phase;
+    if (get_display_frame_usb_phase(&frame_phase)) {
+      TRACE_BEGIN(TRACE_POP_FRAME);
+      struct frame_buffer_t* frame = pop_due_frame(frame_phase.display_frame_counter);
+      TRACE_END(TRACE_POP_FRAME);
+      consume_frame(frame);
+    }
 
     advance_display_state();
 
     if (renderer && !frame_queue_full()) {
+      TRACE_BEGIN(TRACE_RENDER_FRAME);
       struct frame_buffer_t* f = renderer->render_frame();
+      TRACE_END(TRACE_RENDER_FRAME);
       if (f && !push_frame(f) && (f->flags & FRAME_FREE_AFTER_DRAW)) {
         destroy_frame(f);
       }
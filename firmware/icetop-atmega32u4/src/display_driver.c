@@ -4,6 +4,7 @@
 #include "display_types.h"
 #include "display_driver.h"
 #include "display_properties.h"
+#include "telemetry.h"
 
 // See pocket_icetop.dxf
 static const uint8_t LED_MAP_IT78[LED_COUNT_IT78] PROGMEM = {
@@ -36,21 +37,21 @@ static const uint8_t LED_MAP_IT81[LED_COUNT_IT81] PROGMEM = {
 static uint8_t led_count;
 static const uint8_t* led_mapping_P;
 
-/* Pre-calculated differential offsets between LED color components.
- * Since the LED chips might need the RGB data in a different order than the one that is stored
- * in RAM, calculate and store the pointer differences in the required order.
- * If an led_t object L is stored at address A, then L.red is stored at A+1, etc.
- * The jump_c[1-3] variables store the differences between the transmitted RGB components.
- * If the tranmission order is blue, green, red for example, jump_c[1-3] will be [3,-1,-1].
- * This corresponds to reading the data at [A, A+3, A+2, A+1]
+/* Since the LED chips might need the RGB data in a different order than the one that is stored
+ * in RAM, a frame writer is instantiated for every color order. Each one reads the components at
+ * fixed offsets from an led_t object, so the offsets don't have to be loaded for every LED.
+ * The writer for the configured color order is selected once, by load_color_order().
  */
-static int8_t jump_c1;
-static int8_t jump_c2;
-static int8_t jump_c3;
+typedef void (*frame_writer_t)(const uint8_t* leds);
+static frame_writer_t write_leds;
+static void load_color_order();
 
-#define OFFSET_RED ((int8_t) offsetof(struct led_t, red))
-#define OFFSET_GREEN ((int8_t) offsetof(struct led_t, green))
-#define OFFSET_BLUE ((int8_t) offsetof(struct led_t, blue))
+// Set when the color order in EEPROM may have changed
+static volatile bool configuration_changed;
+
+#define OFFSET_RED ((uint8_t) offsetof(struct led_t, red))
+#define OFFSET_GREEN ((uint8_t) offsetof(struct led_t, green))
+#define OFFSET_BLUE ((uint8_t) offsetof(struct led_t, blue))
 
 
 /* Since the display uses a number of APA102 LEDs connected in series, a hardware SPI
@@ -94,39 +95,12 @@ void init_display_driver() {
       break;
   }
 
-  switch (get_color_order()) {
-    case LED_ORDER_BGR:
-      jump_c1 = OFFSET_BLUE;
-      jump_c2 = OFFSET_GREEN-OFFSET_BLUE;
-      jump_c3 = OFFSET_RED-OFFSET_GREEN;
-      break;
-    case LED_ORDER_BRG:
-      jump_c1 = OFFSET_BLUE;
-      jump_c2 = OFFSET_RED-OFFSET_GREEN;
-      jump_c3 = OFFSET_GREEN-OFFSET_RED;
-      break;
-    case LED_ORDER_GBR:
-      jump_c1 = OFFSET_GREEN;
-      jump_c2 = OFFSET_BLUE-OFFSET_GREEN;
-      jump_c3 = OFFSET_RED-OFFSET_BLUE;
-      break;
-    case LED_ORDER_GRB:
-      jump_c1 = OFFSET_GREEN;
-      jump_c2 = OFFSET_RED-OFFSET_GREEN;
-      jump_c3 = OFFSET_BLUE-OFFSET_RED;
-      break;
-    case LED_ORDER_RBG:
-      jump_c1 = OFFSET_RED;
-      jump_c2 = OFFSET_BLUE-OFFSET_RED;
-      jump_c3 = OFFSET_GREEN-OFFSET_BLUE;
-      break;
-    case LED_ORDER_RGB:
-      jump_c1 = OFFSET_RED;
-      jump_c2 = OFFSET_GREEN-OFFSET_RED;
-      jump_c3 = OFFSET_BLUE-OFFSET_GREEN;
-      break;
-  }
+  configuration_changed = false;
+  load_color_order();
+}
 
+void reload_display_configuration() {
+  configuration_changed = true;
 }
 
 static inline void wait_write_finish() __attribute__((always_inline));
@@ -177,34 +151,71 @@ static inline void write_frame_footer() {
 
 const uint8_t LED_HEADER = 0xE0;
 
+// Instantiate the frame writer for a color order, given as the colors in transmission order
+#define DEFINE_FRAME_WRITER(order, first, second, third) \
+  static void write_leds_##order(const uint8_t* leds) { \
+    const uint8_t* led_P = led_mapping_P; \
+    const uint8_t* led_end_P = led_mapping_P + led_count; \
+    while (led_P != led_end_P) { \
+      const uint8_t* led_data = leds + sizeof(struct led_t)*pgm_read_byte(led_P++); \
+      write_byte(LED_HEADER | *led_data); \
+      write_byte(led_data[OFFSET_##first]); \
+      write_byte(led_data[OFFSET_##second]); \
+      write_byte(led_data[OFFSET_##third]); \
+    } \
+  }
+
+DEFINE_FRAME_WRITER(RGB, RED, GREEN, BLUE)
+DEFINE_FRAME_WRITER(BRG, BLUE, RED, GREEN)
+DEFINE_FRAME_WRITER(GBR, GREEN, BLUE, RED)
+DEFINE_FRAME_WRITER(BGR, BLUE, GREEN, RED)
+DEFINE_FRAME_WRITER(RBG, RED, BLUE, GREEN)
+DEFINE_FRAME_WRITER(GRB, GREEN, RED, BLUE)
+
+static void load_color_order() {
+  switch (get_color_order()) {
+    case LED_ORDER_BGR:
+      write_leds = write_leds_BGR;
+      break;
+    case LED_ORDER_BRG:
+      write_leds = write_leds_BRG;
+      break;
+    case LED_ORDER_GBR:
+      write_leds = write_leds_GBR;
+      break;
+    case LED_ORDER_GRB:
+      write_leds = write_leds_GRB;
+      break;
+    case LED_ORDER_RBG:
+      write_leds = write_leds_RBG;
+      break;
+    case LED_ORDER_RGB:
+    default:
+      write_leds = write_leds_RGB;
+      break;
+  }
+}
+
 void display_frame(struct frame_buffer_t* frame) {
-  frame->flags |= FRAME_DRAW_IN_PROGRESS;
+  if (configuration_changed) {
+    configuration_changed = false;
+    load_color_order();
+  }
 
-  // Transmit LED data
-  const uint8_t* leds = frame->buffer;
-  const uint8_t* led_P = led_mapping_P;
-  const uint8_t* led_end_P = led_mapping_P + led_count;
+  frame->flags |= FRAME_DRAW_IN_PROGRESS;
 
   // Start of frame
   write_frame_header();
 
-  while (led_P != led_end_P) {
-    // Calculate initial buffer position
-    const uint8_t* led_data = leds + sizeof(struct led_t)*pgm_read_byte(led_P++);
-    write_byte(LED_HEADER | *led_data);
-    // Jump to first, second, and third transmitted component
-    led_data += jump_c1;
-    write_byte(*led_data);
-    led_data += jump_c2;
-    write_byte(*led_data);
-    led_data += jump_c3;
-    write_byte(*led_data);
-  }
+  // Transmit LED data
+  write_leds(frame->buffer);
 
   // End of frame
   write_frame_footer();
 
   frame->flags &= ~FRAME_DRAW_IN_PROGRESS;
+  // Frames are written synchronously, so they are never skipped
+  telemetry_count(TELEMETRY_FRAMES_DRAWN);
 }
 
 
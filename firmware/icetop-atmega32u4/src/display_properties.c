@@ -1,6 +1,7 @@
 #include "display_properties.h"
 #include "display_types.h"
 #include "util/tlv_list.h"
+#include "usb/remote_renderer.h"
 #include <avr/pgmspace.h>
 #include <avr/eeprom.h>
 
@@ -43,12 +44,14 @@ enum display_led_color_order_t get_color_order() {
 }
 
 static const enum display_information_type_t DP_INFO_TYPE PROGMEM = INFORMATION_IT_STATION;
+static const uint8_t DP_INFO_FRAME_ENCODINGS PROGMEM = REMOTE_FRAME_ENCODINGS;
 
 static const struct dp_tlv_item_t PROPERTIES_TLV_LIST[] PROGMEM = {
     TLV_ENTRY(DP_LED_TYPE, MEMSPACE_EEPROM, &DP_LED_INFORMATION.type)
   , TLV_ENTRY(DP_INFORMATION_TYPE, MEMSPACE_PROGMEM, &DP_INFO_TYPE)
   , TLV_ENTRY(DP_INFORMATION_RANGE, MEMSPACE_RAM, &dp_info_range)
   , TLV_ENTRY(DP_BUFFER_SIZE, MEMSPACE_RAM, &dp_buffer_size)
+  , TLV_ENTRY(DP_FRAME_ENCODINGS, MEMSPACE_PROGMEM, &DP_INFO_FRAME_ENCODINGS)
   , TLV_END
 };
 
@@ -1,6 +1,7 @@
 #include <avr/io.h>
 #include <avr/interrupt.h>
 #include "frame_timer_backend.h"
+#include "trace.h"
 
 #define MODE_SELECT_A (_BV(WGM11) | _BV(WGM10))
 #define MODE_SELECT_B (_BV(WGM13) | _BV(WGM12))
@@ -19,6 +20,12 @@ enum clock_t {
 
 static void (*callback)();
 static timer_count_t old_max_count;
+/* Timer counts at the start of the current period, to extend the counter for the trace
+ * timestamps. It wraps at 2^32, so the 24 bit timestamps wrap at 2^24 counts as well.
+ */
+static volatile uint32_t period_start;
+// Number of counts of the current period, as OCR1A only takes effect at the next roll-over
+static volatile uint32_t period_length;
 
 void init_frame_timer_backend(void (*timer_callback)()) {
   /* Clock is 16MHz
@@ -29,6 +36,7 @@ void init_frame_timer_backend(void (*timer_callback)()) {
   OCR1A = (F_CPU/64/DEVICE_FPS)-1;
   TCCR1A = MODE_SELECT_A;
   TCCR1B = MODE_SELECT_B | CLOCK_SELECT(CLOCK_DIV_64);
+  period_length = (uint32_t) OCR1A + 1;
 
   old_max_count = 0;
 
@@ -38,9 +46,15 @@ void init_frame_timer_backend(void (*timer_callback)()) {
 }
 
 ISR(TIMER1_COMPA_vect) {
+  // The counter has already restarted, so start the new period before its first timestamp.
+  // OCR1A was loaded at the roll-over, corrections made by the callback apply to the next period.
+  period_start += period_length;
+  period_length = (uint32_t) OCR1A + 1;
+  TRACE_BEGIN(TRACE_FRAME_TIMER_ISR);
   if (callback) {
     callback();
   }
+  TRACE_END(TRACE_FRAME_TIMER_ISR);
 }
 
 int8_t get_counter_direction() {
@@ -55,6 +69,22 @@ timer_count_t get_counts_current() {
   return TCNT1;
 }
 
+bool is_rollover_pending() {
+  return TIFR1 & _BV(OCF1A);
+}
+
 void correct_counts_max(timer_diff_t diff) {
   OCR1A += diff;
 }
+
+// Only called with interrupts disabled
+uint32_t get_trace_timestamp() {
+  uint32_t start = period_start;
+  uint16_t count = TCNT1;
+  // Add the period that ended if its interrupt is still pending
+  if (TIFR1 & _BV(OCF1A)) {
+    count = TCNT1;
+    start += period_length;
+  }
+  return start + count;
+}
@@ -14,7 +14,9 @@
 #include "usb/endpoint.h"
 #include "usb/endpoint_0.h"
 #include "usb/remote_renderer.h"
+#include "usb/remote_status.h"
 #include "frame_timer.h"
+#include "trace.h"
 
 // Heavily based on LUFA code, stripped down to the specifics of the ATmega32U4.
 
@@ -95,12 +97,33 @@ bool is_remote_connected() {
 #define requested_suspend() DEVICE_ENABLED_AND_SET(SUSP)
 #define requested_wakeup() DEVICE_ENABLED_AND_SET(WAKEUP)
 
+void ep2_init() {
+  remote_status_init();
+}
+
+// Only queue a report when both banks are free, so the host never reads an outdated report
+static inline void ep2_queue_status() {
+  if (is_remote_connected() && endpoint_push(REMOTE_STATUS_ENDPOINT)) {
+    if (!(UESTA0X & (3 << NBUSYBK0)) && FLAG_IS_SET(UEINTX, TXINI)) {
+      struct remote_status_t status;
+      if (remote_status_poll(&status)) {
+        CLEAR_INT(UEINTX, TXINI);
+        fifo_write(&status, sizeof(status));
+        CLEAR_FLAG(UEINTX, FIFOCON);
+      }
+    }
+    endpoint_pop();
+  }
+}
+
 ISR(USB_GEN_vect) {
+  TRACE_BEGIN(TRACE_USB_ISR);
   if (DEVICE_ENABLED_AND_SET(SOF)) {
     CLEAR_UDINT(SOFI);
     uint16_t fnum = UDFNUMH;
     fnum = (fnum << 8) | UDFNUML;
     new_sof_received(fnum);
+    ep2_queue_status();
   }
 
   // VBUS transitions
@@ -177,6 +200,7 @@ ISR(USB_GEN_vect) {
       set_device_state(POWERED);
     }
   }
+  TRACE_END(TRACE_USB_ISR);
 }
 
 void ep1_init() {
@@ -199,6 +223,7 @@ static inline uint16_t min(uint16_t a, uint16_t b) {
 // This will result in these resources being held until the next control transfer occurs.
 
 ISR(USB_COM_vect) {
+  TRACE_BEGIN(TRACE_USB_ISR);
   trip_led();
 
   // Process USB transfers
@@ -339,16 +364,31 @@ ISR(USB_COM_vect) {
       // If a transfer is possible, copy the received data. Otherwise, halt the endpoint.
       struct frame_transfer_state_t* transfer = remote_renderer_get_transfer_state();
       if (transfer->write_pos) {
-        // Make sure we don't overrun the buffer
-        const uint16_t max_len = min(transfer->buffer_end-transfer->write_pos, fifo_byte_count());
-        const uint16_t transferred = fifo_read(transfer->write_pos, max_len);
-        transfer->write_pos += transferred;
+        uint16_t transferred = 0;
+        bool decode_error = false;
+        TRACE_BEGIN(TRACE_USB_COPY);
+        if (transfer->encoding == REMOTE_FRAME_ENCODING_RAW) {
+          // Make sure we don't overrun the buffer
+          const uint16_t max_len = min(transfer->buffer_end-transfer->write_pos, fifo_byte_count());
+          transferred = fifo_read(transfer->write_pos, max_len);
+          transfer->write_pos += transferred;
+        }
+        else {
+          // Decode the packet in small chunks, to limit the stack usage
+          uint8_t chunk[16];
+          uint16_t chunk_length;
+          while (!decode_error && (chunk_length = fifo_read(chunk, sizeof(chunk)))) {
+            transferred += chunk_length;
+            decode_error = !remote_renderer_decode(chunk, chunk_length);
+          }
+        }
+        TRACE_END(TRACE_USB_COPY);
 
         const uint16_t fifo_remaining = fifo_byte_count();
         const uint16_t transfer_remaining = transfer->buffer_end - transfer->write_pos;
 
         // Halt endpoint on buffer overflow or buffer underflow
-        if (fifo_remaining || (transferred < fifo_size() && transfer_remaining)) {
+        if (decode_error || fifo_remaining || (transferred < fifo_size() && transfer_remaining)) {
           remote_renderer_halt();
         }
         else if (transfer_remaining == 0) {
@@ -365,4 +405,5 @@ ISR(USB_COM_vect) {
     endpoint_pop();
   }
 
+  TRACE_END(TRACE_USB_ISR);
 }
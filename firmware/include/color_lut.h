@@ -0,0 +1,78 @@
+#ifndef COLOR_LUT_H
+#define COLOR_LUT_H
+
+/** \file
+  * \brief Per-channel color correction tables.
+  * \author Sander Vanheule (Universiteit Gent)
+  */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** \defgroup led_display_color_lut Color correction
+  * \ingroup led_display
+  * \brief Lookup tables applied to the LED data as it is written to the display.
+  * \details LED brightness is not linear in the PWM duty cycle, so hosts would otherwise have to
+  *   gamma correct every LED value of every frame. With a color correction table, a host can
+  *   send linear 8 bit values instead, and the display driver maps every color byte through the
+  *   table of its channel while it gathers the frame data. A white balance correction of a
+  *   specific display can be folded into the same tables.
+  *
+  *   The tables are uploaded with ::VENDOR_REQUEST_COLOR_LUT, and can optionally be stored in
+  *   EEPROM so they are used after a reset. New tables only take effect when the display driver
+  *   reloads its configuration, so a frame is never converted with a partially updated table.
+  * @{
+  */
+
+/// Number of entries of a single channel's table.
+#define COLOR_LUT_LENGTH 256
+
+/// Color channels, in the order their tables are stored.
+enum color_lut_channel_t {
+    COLOR_LUT_RED
+  , COLOR_LUT_GREEN
+  , COLOR_LUT_BLUE
+  , COLOR_LUT_CHANNEL_COUNT
+};
+
+/// Size in bytes of the tables of all channels.
+#define COLOR_LUT_SIZE (COLOR_LUT_CHANNEL_COUNT*COLOR_LUT_LENGTH)
+
+/// Flags of a color correction table update, provided in the wValue field of the request.
+enum color_lut_flags_t {
+  /// Apply the tables after the update. Without this flag, color correction is disabled.
+  COLOR_LUT_ENABLE = 1,
+  /// Also store the tables, and whether they are enabled, in EEPROM.
+  COLOR_LUT_STORE = 2
+};
+
+/// Load the stored color correction tables from EEPROM.
+void init_color_lut();
+
+/** \brief Update (part of) the color correction tables.
+  * \details Color correction remains disabled until an update with ::COLOR_LUT_ENABLE, so tables
+  *   can be uploaded in multiple parts by only setting the flag on the last part.
+  * \param offset Byte offset in the tables, `channel*COLOR_LUT_LENGTH + value`.
+  * \param data New table entries.
+  * \param length Number of entries in \a data.
+  * \param flags Combination of ::color_lut_flags_t.
+  * \returns `false` if the update does not fit in the tables.
+  */
+bool write_color_lut(uint16_t offset, const uint8_t* data, uint16_t length, uint8_t flags);
+
+/** \brief Return the ::color_lut_flags_t describing the tables.
+  * \details ::COLOR_LUT_ENABLE is set if the uploaded tables are applied, and ::COLOR_LUT_STORE
+  *   if EEPROM holds enabled tables, which are applied after a reset.
+  */
+uint8_t get_color_lut_flags();
+
+/** \brief Activate the most recently uploaded tables.
+  * \details Should only be called by the display driver while it is not converting a frame.
+  * \returns ::COLOR_LUT_SIZE bytes of tables, ordered by ::color_lut_channel_t, or NULL if color
+  *   correction is disabled.
+  */
+const uint8_t* load_color_lut();
+
+/// @}
+
+#endif // COLOR_LUT_H
@@ -0,0 +1,47 @@
+#ifndef COLOR_PALETTE_H
+#define COLOR_PALETTE_H
+
+/** \file
+  * \brief Color table for palette indexed remote frames.
+  * \author Sander Vanheule (Universiteit Gent)
+  */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/** \defgroup led_display_color_palette Color palette
+  * \ingroup led_display
+  * \brief Color table used to expand palette indexed frames.
+  * \details Event displays typically only use a small number of distinct colors, so a frame can
+  *   also be transferred as one index byte per LED with ::REMOTE_FRAME_ENCODING_INDEXED. The
+  *   remote renderer replaces every index by the corresponding entry of the color palette as the
+  *   frame is received, so the frame buffer and display drivers are not affected.
+  *
+  *   Every entry has the size and format of a single LED in the frame buffer, e.g. `RGB` for
+  *   WS2811 LEDs, or `bRGB` for APA102 LEDs. The palette is uploaded with
+  *   ::VENDOR_REQUEST_COLOR_PALETTE, and is used for all frames that are received afterwards.
+  *   It is not stored in EEPROM, and all entries are black after a reset.
+  * @{
+  */
+
+/// Number of palette entries, i.e. the number of values of an index byte.
+#define COLOR_PALETTE_LENGTH 256
+
+/** \brief Allocate the color palette.
+  * \details Must be called after init_display_properties(), since the palette size depends on the
+  *   LED size. If there is not enough memory, the palette is not available.
+  */
+void init_color_palette();
+
+/// Size in bytes of the color palette, or 0 if it couldn't be allocated.
+size_t get_color_palette_size();
+
+/** \brief Return the color palette, or NULL if it couldn't be allocated.
+  * \details Entry `i` starts at byte `i*get_led_size()`.
+  */
+uint8_t* get_color_palette();
+
+/// @}
+
+#endif // COLOR_PALETTE_H
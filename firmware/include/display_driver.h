@@ -28,6 +28,12 @@
   */
 void init_display_driver();
 
+/** \brief Apply a changed display configuration, e.g. the LED color order or layout.
+  * \details Called after the EEPROM has been written, possibly from an interrupt. The new
+  *   configuration is loaded before the next frame is drawn.
+  */
+void reload_display_configuration();
+
 /// @}
 
 
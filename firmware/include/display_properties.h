@@ -83,7 +83,16 @@ enum display_property_type_t {
   /// The group identifier is then given by the (binary value) of the MD5 hash of the identifier
   /// string encoded in UTF-8.
   /// This 128 bit value is stored as big-endian 16 byte integer.
-  DP_GROUP_ID = 5
+  DP_GROUP_ID = 5,
+  /// Supported encodings of the frame data on EP1, always length 1.
+  /// Bit `n` is set if ::remote_frame_encoding_t value `n` is supported.
+  /// Devices that don't report this property only support ::REMOTE_FRAME_ENCODING_RAW.
+  /// Allowed only once per metadata report.
+  DP_FRAME_ENCODINGS = 6,
+  /// Number of pulses that can be uploaded for event playback, always length 2 (little-endian).
+  /// Devices that don't report this property don't support event playback.
+  /// Allowed only once per metadata report.
+  DP_EVENT_PULSE_CAPACITY = 7
 };
 
 /// Type of information the display is capable of showing.
@@ -104,7 +113,10 @@ enum display_led_type_t {
   /// APA102 compatible. Data for each LED consists of 4 bytes: brightness + RGB.
   LED_TYPE_APA102 = 0,
   /// WS2811/WS2812 compatible. Data for each LED consists of 3 bytes: RGB.
-  LED_TYPE_WS2811 = 1
+  LED_TYPE_WS2811 = 1,
+  /// WS2811/WS2812 compatible, with 16 bit colors shown by temporal dithering.
+  /// Data for each LED consists of 6 bytes: RGB, with every color as a little-endian 16 bit value.
+  LED_TYPE_WS2811_16 = 2
 };
 
 /// Order in which the RGB bytes should be pushed out to the display.
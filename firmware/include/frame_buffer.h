@@ -46,7 +46,7 @@
   *   In case of the APA102 modules, an extra brightness byte `b` is required. This is stored
   *   _before_ the other data, resulting in a `bRGB` data pattern.
   *
-  *   Two flags are currently supported as defined by ::frame_flag_t. A newly allocated frame will
+  *   Four flags are currently supported as defined by ::frame_flag_t. A newly allocated frame will
   *   not have any of these set, so the user should take care of setting these as needed to prevent
   *   any memory leaks or corruption. After drawing a frame with its ::FRAME_FREE_AFTER_DRAW flag
   *   set, the memory will be released. Using this pointer after the frame has been released, may
@@ -68,7 +68,13 @@ enum frame_flag_t {
   FRAME_FREE_AFTER_DRAW  = 1<<1,
   /// Indicate if the frame is currently being drawn.
   /// A renderer may choose to abstain from drawing to the buffer to avoid rendering artifacts.
-  FRAME_DRAW_IN_PROGRESS = 1<<2
+  FRAME_DRAW_IN_PROGRESS = 1<<2,
+  /// Indicate that the frame should only be drawn when the display frame counter reaches
+  /// frame_buffer_t::display_frame_counter. See pop_due_frame().
+  FRAME_PRESENTATION_TIME = 1<<3,
+  /// Indicate that the display driver already converted the frame while it was received,
+  /// so it does not have to be converted again before drawing.
+  FRAME_ENCODED = 1<<4
 };
 
 /// \brief Object constisting of a frame buffer and a number of associated (bit)flags.
@@ -76,7 +82,12 @@ struct frame_buffer_t {
   /// Frame metadata as bit flags (see ::frame_flag_t)
   /// * flags(0): ::FRAME_FREE_AFTER_DRAW
   /// * flags(1): ::FRAME_DRAW_IN_PROGRESS
+  /// * flags(2): ::FRAME_PRESENTATION_TIME
+  /// * flags(3): ::FRAME_ENCODED
   enum frame_flag_t flags;
+  /// Display frame counter value at which the frame is to be drawn.
+  /// Only valid if ::FRAME_PRESENTATION_TIME is set.
+  uint16_t display_frame_counter;
   /// Frame buffer LED data.
   uint8_t* buffer;
 };
@@ -86,6 +97,7 @@ struct frame_buffer_t {
 /// @{
 
 /// Initialise data storage for display frames.
+/// If there is not enough memory for all frame buffers, fewer buffers are handed out.
 void init_frame_buffers();
 
 /// Size in bytes of array pointed to by frame_buffer_t::buffer.
@@ -17,8 +17,14 @@
   *   Multiple instances can push frames in the queue to be displayed.
   *   They can do this independently from each other, without running the risk of (partially)
   *   overwriting an existing frame, or a frame that is currently being drawn.
-  *   Queue manipulation is done atomically to ensure no pointers are dropped, or invalid pointers
-  *   are returned.
+  *   Queue manipulation is lock-free, so frames can be pushed from interrupt handlers without
+  *   the queue having to disable interrupts. Frames may be pushed from any context, but should
+  *   only be popped from the main loop.
+  *
+  *   Next to the FIFO, a single frame mailbox is available via push_latest_frame().
+  *   A frame pushed into the mailbox replaces the frame that is already there, so a producer
+  *   that only cares about the most recent frame is never blocked by a full queue.
+  *   The mailbox frame is only returned by pop_due_frame(), after all frames in the FIFO.
   * @{
   * \name Frame queue manipulation
   * @{
@@ -26,17 +32,43 @@
 
 /// \brief Check if the frame queue is full.
 bool frame_queue_full();
-/// \brief Check if the frame queue is empty.
+/// \brief Check if the frame queue is empty, i.e. there is no frame in the FIFO or the mailbox.
 bool frame_queue_empty();
+/// \brief Number of frames that can be pushed into the FIFO before it is full.
+uint8_t frame_queue_free_slots();
 
 /// \brief Push new frame into the frame FIFO.
-/// \returns `true` on success, and `false` if the FIFO was full.
+/// \returns `true` on success, and `false` if the FIFO was full or \a frame is NULL.
+///   Frames refused because the FIFO was full are counted as ::TELEMETRY_PUSH_REFUSED.
 bool push_frame(struct frame_buffer_t* frame);
 
-/// \brief Pop a frame from the frame FIFO.
+/** \brief Push a frame into the single frame mailbox, replacing any frame that has not been
+  *   popped yet.
+  * \details The replaced frame is released if ::FRAME_FREE_AFTER_DRAW is set, and counted as
+  *   ::TELEMETRY_FRAMES_REPLACED.
+  * \returns `true` on success, and `false` if \a frame is NULL.
+  */
+bool push_latest_frame(struct frame_buffer_t* frame);
+
+/// \brief Pop a frame from the frame FIFO. The mailbox is not checked.
 /// \returns Pointer to the popped frame, or NULL if the FIFO was empty.
 struct frame_buffer_t* pop_frame();
 
+/** \brief Pop the frame that should be drawn for the provided display frame counter value.
+  * \details Frames with the ::FRAME_PRESENTATION_TIME flag set are kept in the FIFO until
+  *   \a display_frame_counter equals their frame_buffer_t::display_frame_counter, blocking any
+  *   frames queued after them.
+  *   Frames of which the presentation time has already passed are removed from the FIFO without
+  *   being returned, released if ::FRAME_FREE_AFTER_DRAW is set, and counted as
+  *   ::TELEMETRY_FRAMES_LATE.
+  *   Frames without a presentation time are returned immediately, like pop_frame() does.
+  *   When the FIFO is empty, the mailbox frame is returned according to the same rules.
+  *   An early mailbox frame remains in the mailbox, where it can still be replaced.
+  * \param display_frame_counter Current value of display_frame_usb_phase_t::display_frame_counter.
+  * \returns Pointer to the popped frame, or NULL if no frame should be drawn yet.
+  */
+struct frame_buffer_t* pop_due_frame(uint16_t display_frame_counter);
+
 /// @}
 /// @}
 
@@ -21,11 +21,14 @@
   * all display segments can be made to update within 1ms from each other.
   * These phase corrections can be performed remotely by sending a
   * \ref VENDOR_REQUEST_FRAME_DRAW_SYNC "FRAME_DRAW_SYNC" request to the control endpoint.
-  * Note that tearing can still occur if no mechanism is present to tell the segments when
-  * the remotely rendered data should be displayed.
   *
-  * \todo A USB UVC-like interface should be implemented for displays consisting of multiple
-  *   segments to prevent frame tearing.
+  * ## Frame presentation time
+  * Even with synchronised frame timers, tearing can still occur between segments if a frame
+  * arrives at one segment just before a timer tick, and at another segment just after it.
+  * A \ref VENDOR_REQUEST_FRAME_PRESENTATION_TIME "FRAME_PRESENTATION_TIME" request before
+  * sending a frame, tells the segment at which display frame counter value the frame should be
+  * drawn. If all segments receive the same value, they will all switch to the new frame on the
+  * same timer tick.
   */
 
 #include <stdint.h>
@@ -97,9 +100,38 @@ void init_frame_timer();
 /// Whether a new frame should be displayed or if the device is allowed to idle.
 bool should_draw_frame();
 
-/// Acknowledge that a frame has been drawn.
+/** \brief Acknowledge that a frame has been drawn.
+  * \details The time left until the next timer roll-over is recorded in the frame budget.
+  */
 void clear_draw_frame();
 
+/// @}
+
+
+/// \name Frame budget
+/// @{
+
+/** \brief Time spent by the main loop on a frame, relative to the frame interval.
+  * \details The main loop should finish its work on a frame, i.e. call clear_draw_frame(),
+  *   before the next timer roll-over. Otherwise the next frame draw is missed, and the
+  *   effective frame rate drops without any other sign.
+  *   Slack is the number of timer counts left until the next roll-over when the work is done.
+  *   It is negative if one or more roll-overs were missed, in which case it is the overrun past
+  *   the deadline.
+  */
+struct frame_budget_t {
+  uint32_t interval_us; ///< Nominal frame interval in microseconds.
+  uint32_t interval_counts; ///< Current frame interval in timer counts.
+  int32_t min_slack_counts; ///< Lowest slack of all measured frames, in timer counts.
+  uint16_t frames_measured; ///< Number of frames measured.
+  uint16_t ticks_missed; ///< Number of timer roll-overs that occurred during the work on a frame.
+};
+
+/** \brief Copy the frame budget statistics to \a budget.
+  * \param clear If `true`, the statistics are reset after reading them.
+  */
+void read_frame_budget(struct frame_budget_t* budget, bool clear);
+
 /// @}
 /// @}
 
@@ -24,10 +24,10 @@
 #warning FRAME_TIMER_RESOLUTION not defined
 typedef unsigned int timer_count_t;
 typedef signed int timer_diff_t;
-#elif FRAME_TIMER_RESOLUTION < 32
+#elif FRAME_TIMER_RESOLUTION > 32
 typedef uint64_t timer_count_t;
 typedef int64_t timer_diff_t;
-#elif FRAME_TIMER_RESOLUTION < 16
+#elif FRAME_TIMER_RESOLUTION > 16
 typedef uint32_t timer_count_t;
 typedef int32_t timer_diff_t;
 #else
@@ -57,6 +57,11 @@ timer_count_t get_counts_max();
 /// \brief Get the current counter value of the timer.
 timer_count_t get_counts_current();
 
+/** \brief Whether the timer has rolled over, but its interrupt has not been handled yet.
+  * \details Useful with interrupts disabled, when the counter value has already restarted.
+  */
+bool is_rollover_pending();
+
 /** \brief Add \a diff to the current maximum value of the counter.
   * \details The new value will be applied after the counter has rolled over.
   *   Therefore, although possible, it doesn't really make sense to call this function more
@@ -28,4 +28,7 @@ bool is_remote_connected();
 /// Custom initialisation function for endpoint 1: the bulk endpoint for frame data transfers.
 void ep1_init();
 
+/// Custom initialisation function for endpoint 2: the interrupt endpoint for status reports.
+void ep2_init();
+
 #endif
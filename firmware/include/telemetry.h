@@ -0,0 +1,50 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+/** \file
+  * \brief Frame handling event counters.
+  * \author Sander Vanheule (Universiteit Gent)
+  */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** \defgroup led_display_telemetry Frame telemetry
+  * \ingroup led_display
+  * \brief Counters of events that cause frames to be lost or delayed.
+  * \details When a display stutters, it is hard to tell whether frames were lost because no
+  *   frame buffer was available, the frame queue was full, a remote transfer failed, or the
+  *   display was still busy writing the previous frame.
+  *   Each of these events increments a counter, which can be read over USB with
+  *   ::VENDOR_REQUEST_TELEMETRY.
+  *
+  *   Counters are 16 bit wide and wrap around. They can be incremented from any context,
+  *   without disabling interrupts on the Cortex-M4.
+  * @{
+  */
+
+/// Event counters. New counters are always appended, since the USB request uses this order.
+enum telemetry_counter_t {
+    TELEMETRY_FRAMES_DRAWN ///< Frames written to the LEDs by display_frame().
+  , TELEMETRY_DRAW_SKIPPED ///< Frames not drawn because the previous write was still busy.
+  , TELEMETRY_ALLOC_FAILED ///< create_frame() calls without a free frame buffer.
+  , TELEMETRY_PUSH_REFUSED ///< push_frame() calls refused because the frame queue was full.
+  , TELEMETRY_REMOTE_HALTED ///< Frame transfers aborted by remote_renderer_halt().
+  , TELEMETRY_FRAMES_LATE ///< Frames dropped by pop_due_frame() since they were late.
+  , TELEMETRY_FRAMES_REPLACED ///< Frames replaced by push_latest_frame() before being drawn.
+  , TELEMETRY_REFRESH_SKIPPED ///< LED refreshes skipped since the previous one was busy.
+  , TELEMETRY_COUNTER_COUNT ///< Number of counters.
+};
+
+/// Increment an event counter by one.
+void telemetry_count(enum telemetry_counter_t counter);
+
+/** \brief Copy all counters to \a counters, an array of ::TELEMETRY_COUNTER_COUNT elements.
+  * \param clear If `true`, every counter is reset to zero as it is read, so no events are lost
+  *   between reading and clearing.
+  */
+void read_telemetry(uint16_t* counters, bool clear);
+
+/// @}
+
+#endif // TELEMETRY_H
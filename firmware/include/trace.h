@@ -0,0 +1,106 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+/** \file
+  * \brief Timing trace of interrupts and frame handling.
+  * \author Sander Vanheule (Universiteit Gent)
+  */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/** \defgroup led_display_trace Timing trace
+  * \ingroup led_display
+  * \brief Timestamps of the start and end of interrupts and frame handling steps.
+  * \details When built with `TRACE`, the firmware records when interrupt handlers and the main
+  *   loop's frame handling steps start and end, in a ring buffer of ::TRACE_BUFFER_LENGTH
+  *   records. This shows where the time of every frame interval goes, without a scope probe.
+  *   The buffer can be read over USB with ::VENDOR_REQUEST_TRACE, and converted into the Chrome
+  *   trace event format by `test_usb/trace.py`.
+  *
+  *   Every record is a little-endian 32 bit word. The 24 least significant bits hold the
+  *   timestamp, bits 24-30 the ::trace_point_t, and bit 31 is set for the end of a trace point.
+  *   Timestamps are the CPU cycle counter on the Teensy, and count the 250kHz frame timer on the
+  *   ATmega. They wrap around, but the frame timer interrupt is recorded often enough to unwrap
+  *   them. Records are appended from any context, without disabling interrupts on the Cortex-M4,
+  *   so records of interrupts may be stored just before a slightly earlier record.
+  *
+  *   Without `TRACE`, TRACE_BEGIN() and TRACE_END() compile to nothing.
+  * @{
+  */
+
+/// Traced code. New points are always appended, since the USB request uses these values.
+enum trace_point_t {
+    TRACE_FRAME_TIMER_ISR ///< Frame timer interrupt, which also flags the next frame draw.
+  , TRACE_USB_ISR ///< USB interrupt.
+  , TRACE_USB_COPY ///< Copy of received remote frame data into the frame buffer.
+  , TRACE_USB_LED_ISR ///< USB activity LED timer interrupt.
+  , TRACE_REFRESH_TIMER_ISR ///< LED refresh timer interrupt.
+  , TRACE_DMA_ISR ///< DMA completion interrupt of an LED data transfer.
+  , TRACE_PDB_ISR ///< End of the LED reset delay.
+  , TRACE_POP_FRAME ///< pop_due_frame() in the main loop.
+  , TRACE_DISPLAY_FRAME ///< display_frame() in the main loop.
+  , TRACE_REFRESH_DISPLAY ///< refresh_display() in the main loop.
+  , TRACE_RENDER_FRAME ///< Local rendering of a frame in the main loop.
+  , TRACE_POINT_COUNT ///< Number of trace points.
+};
+
+/// Flag of records at the end of a trace point.
+#define TRACE_END_FLAG 0x80
+
+/// Number of bits of the record timestamps.
+#define TRACE_TIMESTAMP_BITS 24
+
+#ifndef TRACE_BUFFER_LENGTH
+/// Number of records kept in the trace buffer. Can be supplied as a compiler flag.
+#define TRACE_BUFFER_LENGTH 512
+#endif
+
+#ifndef TRACE_TIMESTAMP_FREQUENCY
+/// Rate in Hz at which the trace timestamps increment. Supplied as a compiler flag.
+#define TRACE_TIMESTAMP_FREQUENCY F_CPU
+#endif
+
+/** \brief Header of the trace buffer readout, followed by the records from oldest to newest.
+  * \details All fields are little-endian.
+  */
+struct trace_header_t {
+  uint32_t timestamp_frequency; ///< Rate in Hz at which the timestamps increment.
+  uint16_t record_count; ///< Number of records following the header.
+  uint16_t records_lost; ///< Records overwritten since the buffer was last cleared.
+} __attribute__((packed));
+
+/// Size in bytes of a full trace buffer readout.
+#define TRACE_READOUT_SIZE (sizeof(struct trace_header_t) + TRACE_BUFFER_LENGTH*sizeof(uint32_t))
+
+#if defined(DEVICE_HAS_TRACE) && DEVICE_HAS_TRACE
+/// Record the start of a trace point.
+#define TRACE_BEGIN(point) trace_record(point)
+/// Record the end of a trace point.
+#define TRACE_END(point) trace_record((point) | TRACE_END_FLAG)
+#else
+#define TRACE_BEGIN(point) ((void) 0)
+#define TRACE_END(point) ((void) 0)
+#endif
+
+/// Append a record for \a event, a ::trace_point_t optionally combined with ::TRACE_END_FLAG.
+void trace_record(uint8_t event);
+
+/** \brief Copy the trace header and as many records as fit in \a length bytes to \a buffer.
+  * \details Records are copied from oldest to newest, so a large buffer can be read in parts.
+  *   Nothing is copied if \a length is smaller than the header.
+  * \param clear If `true`, the copied records are removed from the buffer, and the count of
+  *   lost records is reset.
+  * \return The number of bytes copied.
+  */
+uint16_t read_trace(uint8_t* buffer, uint16_t length, bool clear);
+
+/** \brief Return the current trace timestamp.
+  * \details Provided by the platform's frame timer backend. Only the
+  *   ::TRACE_TIMESTAMP_BITS least significant bits have to be valid.
+  */
+uint32_t get_trace_timestamp();
+
+/// @}
+
+#endif // TRACE_H
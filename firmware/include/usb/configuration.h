@@ -6,8 +6,9 @@
   * \details Since currently only one device configuration is present, only two configurations
   *   are supported:
   *   - Configuration 0: USB default configuration
-  *   - Configuration 1: Default device configuration with the standard control endpoint
-  *     and a bulk OUT endpoint for remote frame data transfer.
+  *   - Configuration 1: Default device configuration with the standard control endpoint,
+  *     a bulk OUT endpoint for remote frame data transfer, and an interrupt IN endpoint for
+  *     frame flow status reports.
   *
   * \author Sander Vanheule (Universiteit Gent)
   */
@@ -111,13 +111,24 @@ enum control_stage_t {
 };
 
 /** Vendor specific USB control request for display status and control.
-  * Request name                        | bmRequestType | bRequest | wValue | wIndex |    wLength
-  * ------------------------------------|---------------|----------|--------|--------|-----------
-  * ::VENDOR_REQUEST_DISPLAY_PROPERTIES |  0b1_10_00000 |        2 |      0 |      0 |    2-65535
-  * ::VENDOR_REQUEST_EEPROM_WRITE       |  0b0_10_00000 |        3 |      0 | offset |     length
-  * ::VENDOR_REQUEST_EEPROM_READ        |  0b1_10_00000 |        4 |      0 | offset |     length
-  * ::VENDOR_REQUEST_FRAME_DRAW_STATUS  |  0b1_10_00000 |        5 |      0 |      0 |          4
-  * ::VENDOR_REQUEST_FRAME_DRAW_SYNC    |  0b0_10_00000 |        6 |   [ms] |      0 |          0
+  * Request name                             | bmRequestType | bRequest |  wValue | wIndex | wLength
+  * -----------------------------------------|---------------|----------|---------|--------|--------
+  * ::VENDOR_REQUEST_DISPLAY_PROPERTIES      |  0b1_10_00000 |        2 |       0 |      0 | 2-65535
+  * ::VENDOR_REQUEST_EEPROM_WRITE            |  0b0_10_00000 |        3 |       0 | offset |  length
+  * ::VENDOR_REQUEST_EEPROM_READ             |  0b1_10_00000 |        4 |       0 | offset |  length
+  * ::VENDOR_REQUEST_FRAME_DRAW_STATUS       |  0b1_10_00000 |        5 |       0 |      0 |       4
+  * ::VENDOR_REQUEST_FRAME_DRAW_SYNC         |  0b0_10_00000 |        6 |    [ms] |      0 |       0
+  * ::VENDOR_REQUEST_FRAME_PRESENTATION_TIME |  0b0_10_00000 |        7 | [frame] |      0 |       0
+  * ::VENDOR_REQUEST_REMOTE_FRAME_MODE       |  0b0_10_00000 |        8 |  [mode] |      0 |       0
+  * ::VENDOR_REQUEST_TELEMETRY               |  0b1_10_00000 |        9 | [clear] |      0 |  length
+  * ::VENDOR_REQUEST_COLOR_LUT               |  0b0_10_00000 |       10 | [flags] | offset |  length
+  * ::VENDOR_REQUEST_COLOR_LUT               |  0b1_10_00000 |       10 |       0 |      0 |       1
+  * ::VENDOR_REQUEST_TRACE                   |  0b1_10_00000 |       11 | [clear] |      0 |  length
+  * ::VENDOR_REQUEST_FRAME_BUDGET            |  0b1_10_00000 |       12 | [clear] |      0 |  length
+  * ::VENDOR_REQUEST_REMOTE_FRAME_ENCODING   |  0b0_10_00000 |       13 |   [enc] |      0 |       0
+  * ::VENDOR_REQUEST_COLOR_PALETTE           |  0b0_10_00000 |       14 |       0 | offset |  length
+  * ::VENDOR_REQUEST_EVENT_PULSES            |  0b0_10_00000 |       15 |       0 | [first]|  length
+  * ::VENDOR_REQUEST_EVENT_PLAYBACK          |  0b0_10_00000 |       16 |       0 |      0 |    0, 8
   * \see \ref usb_endpoint_control
   */
 enum vendor_request_t {
@@ -180,7 +191,96 @@ enum vendor_request_t {
     * of phase.
     * Subsequent requests can then correct the remaining offset as multiples of 40ms.
     */
-  VENDOR_REQUEST_FRAME_DRAW_SYNC = 6
+  VENDOR_REQUEST_FRAME_DRAW_SYNC = 6,
+  /** Set the display frame counter value at which the next frame received on EP1 is drawn.
+    * The unsigned 16 bit frame counter value is contained in the wValue field of the setup
+    * request, and applies to the first frame that completes after this request.
+    * The frame is kept in the frame queue until the device's display frame counter, as reported
+    * by ::VENDOR_REQUEST_FRAME_DRAW_STATUS, reaches this value.
+    * If the frame arrives late, it is dropped without being drawn.
+    *
+    * When the display frame counters of multiple segments are synchronised with
+    * ::VENDOR_REQUEST_FRAME_DRAW_SYNC, this allows all segments to switch to a new frame on the
+    * same frame timer tick.
+    * Note that frames queued after a frame with a presentation time are also held, and that the
+    * frame queue and frame buffer pool are small, so frames should be sent at most a few frame
+    * periods in advance.
+    */
+  VENDOR_REQUEST_FRAME_PRESENTATION_TIME = 7,
+  /** Select how frames received on EP1 are submitted for display.
+    * The wValue field contains a ::remote_frame_mode_t value; unknown values are stalled.
+    * With the default ::REMOTE_FRAME_MODE_QUEUE (0), frames are drawn in order and EP1 is stalled
+    * when the frame queue overflows.
+    * With ::REMOTE_FRAME_MODE_LATEST (1), a newly received frame replaces any frame that has not
+    * been drawn yet, so the display always shows the most recent frame and EP1 never stalls on
+    * a full queue. This is useful for interactive use, e.g. scrubbing through an event.
+    */
+  VENDOR_REQUEST_REMOTE_FRAME_MODE = 8,
+  /** Read the \ref led_display_telemetry "frame telemetry" counters.
+    * The response consists of unsigned 16 bit (little endian) integers, in the order defined by
+    * ::telemetry_counter_t, truncated to wLength bytes.
+    * If bit 0 of wValue is set, all counters are reset to zero when they are read.
+    * Note that the counts are lost if the response does not reach the host, so when clearing
+    * the counters, the host should poll at a fixed interval and treat failed requests as gaps.
+    */
+  VENDOR_REQUEST_TELEMETRY = 9,
+  /** Upload \ref led_display_color_lut "color correction tables".
+    * wIndex is the byte offset of the data in the tables, which consist of ::COLOR_LUT_LENGTH
+    * entries for every ::color_lut_channel_t. wIndex+wLength may not exceed ::COLOR_LUT_SIZE.
+    * wValue contains ::color_lut_flags_t: the tables are only applied if ::COLOR_LUT_ENABLE is
+    * set, and also stored in EEPROM if ::COLOR_LUT_STORE is set. A request with wLength 0 can
+    * be used to only change the flags.
+    * The new tables are applied from the next frame that is drawn.
+    *
+    * An IN request returns a single byte with the flags of the current tables, so a host can
+    * check whether the display already applies e.g. gamma correction.
+    * Devices without color correction support stall this request.
+    */
+  VENDOR_REQUEST_COLOR_LUT = 10,
+  /** Read the \ref led_display_trace "timing trace".
+    * The response consists of a ::trace_header_t, followed by as many records as fit in wLength
+    * bytes, oldest first. A full trace buffer fits in ::TRACE_READOUT_SIZE bytes.
+    * If bit 0 of wValue is set, the returned records are removed from the trace buffer, so the
+    * host can poll for new records.
+    * Devices built without `TRACE` stall this request.
+    */
+  VENDOR_REQUEST_TRACE = 11,
+  /** Read how much of the frame interval the main loop uses.
+    * The response is a ::frame_budget_t, truncated to wLength bytes.
+    * A negative ::frame_budget_t::min_slack_counts, or a non-zero
+    * ::frame_budget_t::ticks_missed, means that frame draws were missed, and the display ran
+    * below its nominal frame rate.
+    * If bit 0 of wValue is set, the statistics are reset after they are read.
+    */
+  VENDOR_REQUEST_FRAME_BUDGET = 12,
+  /** Select the encoding of the frames received on EP1.
+    * The wValue field contains a ::remote_frame_encoding_t value. Encodings that are not
+    * reported by ::DP_FRAME_ENCODINGS are stalled.
+    * The encoding only takes effect after EP1 is reset, so the host should clear the endpoint's
+    * halt feature after this request. ::SET_CONFIGURATION also resets the encoding to
+    * ::REMOTE_FRAME_ENCODING_RAW.
+    * \see \ref usb_remote_renderer
+    */
+  VENDOR_REQUEST_REMOTE_FRAME_ENCODING = 13,
+  /** Upload (part of) the \ref led_display_color_palette "color palette" used to expand frames
+    * received with ::REMOTE_FRAME_ENCODING_INDEXED.
+    * wIndex contains the byte offset of the data in the palette, i.e. the entry index times the
+    * LED size. Updates that don't fit in the palette are stalled, as are all updates on devices
+    * that don't report ::REMOTE_FRAME_ENCODING_INDEXED in ::DP_FRAME_ENCODINGS.
+    */
+  VENDOR_REQUEST_COLOR_PALETTE = 14,
+  /** Upload pulses for \ref led_display_event_playback "event playback".
+    * The data consists of ::event_pulse_t items, which are stored starting at pulse number wIndex.
+    * Any playback is stopped. Uploads that don't fit in ::DP_EVENT_PULSE_CAPACITY pulses are
+    * stalled, as are all uploads on devices that don't report this property.
+    */
+  VENDOR_REQUEST_EVENT_PULSES = 15,
+  /** Start or stop the \ref led_display_event_playback "playback" of the uploaded pulses.
+    * With a wLength of 0, the playback is stopped. Otherwise, the data is an ::event_playback_t,
+    * and the playback is (re)started from the first frame. Playback settings with more pulses
+    * than ::DP_EVENT_PULSE_CAPACITY are ignored.
+    */
+  VENDOR_REQUEST_EVENT_PLAYBACK = 16
 };
 
 /// \brief Control transfer state tracking.
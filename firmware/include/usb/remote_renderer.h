@@ -34,6 +34,38 @@
   * If the endpoint was stalled due to a transmission error, the stall should be clear using a
   * \ref CLEAR_FEATURE control request.
   *
+  * ## Frame encodings
+  * By default, the frame buffer data is transferred as is (::REMOTE_FRAME_ENCODING_RAW).
+  * Since a typical event only lights a small fraction of the LEDs, most of a frame consists of
+  * zeros. With ::REMOTE_FRAME_ENCODING_ZERO_RUN, these zeros are not transferred.
+  * The frame data is then sent as a series of runs, each starting with a header byte `h`:
+  * - `h < 0x80`: `h+1` zero bytes, without any further data.
+  * - `h >= 0x80`: `(h & 0x7f)+1` literal bytes, which follow the header byte.
+  *
+  * Runs may be split over multiple packets. The frame is complete when the runs have filled the
+  * frame buffer, which must coincide with the end of a packet. As with raw frames, a short
+  * packet that does not complete the frame, or runs beyond the end of the frame buffer, stall
+  * the endpoint.
+  *
+  * Between consecutive frames of an animation, most of the frame data is usually unchanged.
+  * With ::REMOTE_FRAME_ENCODING_DELTA, every frame starts with a frame type byte, followed by
+  * runs in the same format:
+  * - `0`: a full frame. Runs without data contain zeros, as with ::REMOTE_FRAME_ENCODING_ZERO_RUN.
+  * - `1`: a delta frame. Runs without data keep the values of the previously received frame, so
+  *   only the changed bytes have to be transferred.
+  *
+  * There is no previous frame after the endpoint has been reset, so the first frame after a
+  * reset must be a full frame. Otherwise, the endpoint is stalled. The host can pick the shorter
+  * of the two frame types for every frame.
+  *
+  * With ::REMOTE_FRAME_ENCODING_INDEXED, the frame data consists of one byte per LED, which is
+  * an index in the \ref led_display_color_palette "color palette". Every index is replaced by
+  * its palette entry when it is received, so a frame takes 3 (or 4, with APA102 LEDs) times
+  * fewer bytes. The palette should only be changed in between frames.
+  *
+  * The encodings supported by a device are reported by ::DP_FRAME_ENCODINGS, and an encoding is
+  * selected with ::VENDOR_REQUEST_REMOTE_FRAME_ENCODING.
+  *
   * \dot
   *   digraph remote_renderer_fsm {
   *     rankdir=LR;
@@ -60,13 +92,50 @@
   * @{
   */
 
+/// Ways in which completed remote frames are submitted for display.
+enum remote_frame_mode_t {
+    REMOTE_FRAME_MODE_QUEUE = 0 ///< Push frames into the queue, halt the endpoint if it is full.
+  , REMOTE_FRAME_MODE_LATEST = 1 ///< Replace any undrawn frame, see push_latest_frame().
+};
+
+/** \brief Encodings of the frame data received on EP1.
+  * \details Values are bit numbers in ::DP_FRAME_ENCODINGS, so new encodings are always appended.
+  * \see \ref usb_remote_renderer
+  */
+enum remote_frame_encoding_t {
+    REMOTE_FRAME_ENCODING_RAW = 0 ///< Frame buffer data, as is.
+  , REMOTE_FRAME_ENCODING_ZERO_RUN = 1 ///< Runs of zeros and literal bytes.
+  , REMOTE_FRAME_ENCODING_DELTA = 2 ///< Zero-run encoded full frames, or changes to the last frame.
+  , REMOTE_FRAME_ENCODING_INDEXED = 3 ///< Color palette indices, one byte per LED.
+};
+
+#if defined(DEVICE_HAS_COLOR_PALETTE) && DEVICE_HAS_COLOR_PALETTE
+#define REMOTE_FRAME_ENCODINGS_INDEXED (1 << REMOTE_FRAME_ENCODING_INDEXED)
+#else
+#define REMOTE_FRAME_ENCODINGS_INDEXED 0
+#endif
+
+/// Bit mask of the ::remote_frame_encoding_t values supported by the remote renderer.
+#define REMOTE_FRAME_ENCODINGS ( \
+    (1 << REMOTE_FRAME_ENCODING_RAW) \
+  | (1 << REMOTE_FRAME_ENCODING_ZERO_RUN) \
+  | (1 << REMOTE_FRAME_ENCODING_DELTA) \
+  | REMOTE_FRAME_ENCODINGS_INDEXED \
+)
+
 /// State of the current remote frame transfer.
 struct frame_transfer_state_t {
-  uint8_t* write_pos;
-  uint8_t* buffer_end;
+  struct frame_buffer_t* frame; ///< Frame that is being received.
+  uint8_t* write_pos; ///< Location of the next received byte.
+  uint8_t* buffer_end; ///< End of the frame's buffer.
+  /// Encoding of the received data. Received data should be passed to remote_renderer_decode(),
+  /// unless the encoding is ::REMOTE_FRAME_ENCODING_RAW.
+  enum remote_frame_encoding_t encoding;
 };
 
-/// Initialise the remote renderer internal state by acquiring a frame buffer.
+/** Initialise the remote renderer internal state by acquiring a frame buffer.
+  * The frame encoding selected by remote_renderer_set_frame_encoding() is applied.
+  */
 void remote_renderer_init();
 
 /// Stall the remote renderer's endpoint and free frame buffer resources.
@@ -83,9 +152,46 @@ struct frame_transfer_state_t* remote_renderer_get_transfer_state();
 
 /** Submit the current frame to the frame queue.
   * Will halt the endpoint if no room was available in the frame queue.
+  * In ::REMOTE_FRAME_MODE_LATEST the frame replaces the previous undrawn frame instead, and the
+  * replaced frame buffer is returned to the pool.
+  * With ::REMOTE_FRAME_ENCODING_DELTA, the next frame starts as a copy of the submitted frame.
   */
 void remote_renderer_transfer_done();
 
+/** Set the presentation time of the next frame that is completed.
+  * The frame will be kept in the frame queue until the display frame counter reaches
+  * \a display_frame_counter, or dropped if the counter has already passed this value.
+  * The presentation time is discarded if the frame transfer fails.
+  * \see ::VENDOR_REQUEST_FRAME_PRESENTATION_TIME
+  */
+void remote_renderer_set_presentation_time(uint16_t display_frame_counter);
+
+/** Select how completed frames are submitted for display.
+  * The default ::REMOTE_FRAME_MODE_QUEUE draws every frame, in order.
+  * ::REMOTE_FRAME_MODE_LATEST minimises the display latency when the host sends frames faster
+  * than they can be drawn, at the cost of skipping frames.
+  * The mode is kept when the endpoint is reset.
+  * \returns `false` if \a mode is not a valid ::remote_frame_mode_t value.
+  * \see ::VENDOR_REQUEST_REMOTE_FRAME_MODE
+  */
+bool remote_renderer_set_frame_mode(enum remote_frame_mode_t mode);
+
+/** Select the encoding of the frame data received on EP1.
+  * The new encoding is applied when the endpoint is reset, i.e. by ::SET_CONFIGURATION or by
+  * clearing the endpoint's halt feature, so a frame is never received with mixed encodings.
+  * \returns `false` if \a encoding is not supported, or if it requires a color palette that
+  *   couldn't be allocated.
+  * \see ::VENDOR_REQUEST_REMOTE_FRAME_ENCODING
+  */
+bool remote_renderer_set_frame_encoding(enum remote_frame_encoding_t encoding);
+
+/** Decode \a length bytes of encoded frame data into the current frame.
+  * The transfer state's write position is advanced over the decoded data.
+  * \returns `false` if the data does not fit in the frame buffer, or if a delta frame is received
+  *   without a previous frame, in which case the endpoint should be halted.
+  */
+bool remote_renderer_decode(const uint8_t* data, uint16_t length);
+
 /// @}
 
 #endif //USB_REMOTE_RENDERER_H
@@ -0,0 +1,78 @@
+#ifndef USB_REMOTE_STATUS_H
+#define USB_REMOTE_STATUS_H
+
+/** \file
+  * \brief Frame flow status reports on the interrupt IN endpoint.
+  * \author Sander Vanheule (Universiteit Gent)
+  */
+
+#include "telemetry.h"
+#include <stdint.h>
+#include <stdbool.h>
+
+/** \page usb_remote_status Frame flow status
+  * Without feedback from the display, the host only learns that it is sending frames too fast
+  * when a frame is refused, EP1 is stalled, and the frame is lost.
+  * Configuration 1 therefore also provides an interrupt IN endpoint (::REMOTE_STATUS_ENDPOINT),
+  * on which the display reports a ::remote_status_t once per display frame.
+  *
+  * The report is queued on the first USB SOF after the frame timer has rolled over, so it
+  * reflects the state right after a frame was drawn. If the host has not read the previous
+  * report yet, no new report is queued until the next frame timer roll-over.
+  *
+  * remote_status_t::queue_free is the number of frames the host may send before the frame queue
+  * is full. Frames that are sent after the report was queued are not included, so the host
+  * should subtract the frames it sent since. When remote_status_t::flags doesn't contain
+  * ::REMOTE_STATUS_READY, no frame buffer is available to receive the next frame, and a frame
+  * sent at that time will stall EP1.
+  * Frames pushed with ::REMOTE_FRAME_MODE_LATEST replace the queued frame, and are never refused
+  * because the queue is full.
+  *
+  * The display and USB frame counters are the values of the last frame timer roll-over, as
+  * reported by ::VENDOR_REQUEST_FRAME_DRAW_STATUS, so the host doesn't have to poll the control
+  * endpoint to track the display's frame phase.
+  */
+
+/** \defgroup usb_remote_status Frame flow status
+  * \ingroup usb_device
+  * \brief Periodic reports of the display's frame queue and counters.
+  * @{
+  */
+
+/// Endpoint number of the interrupt IN endpoint in configuration 1.
+#define REMOTE_STATUS_ENDPOINT 2
+/// Size of the status endpoint's buffers.
+#define REMOTE_STATUS_ENDPOINT_SIZE 32
+
+/// Flags of remote_status_t::flags
+enum remote_status_flags_t {
+  /// A frame buffer is ready to receive the next frame on EP1.
+  REMOTE_STATUS_READY = 1,
+  /// EP1 is stalled, and the host should clear the stall before sending more frames.
+  REMOTE_STATUS_HALTED = 2
+};
+
+/// Status report, as transmitted on ::REMOTE_STATUS_ENDPOINT.
+/// All fields are naturally aligned, so there is no padding on any platform.
+struct remote_status_t {
+  uint8_t queue_free; ///< Number of frames that can be queued before the frame queue is full.
+  uint8_t flags; ///< Combination of ::remote_status_flags_t.
+  uint16_t display_frame_counter; ///< Display frame counter at the last frame timer roll-over.
+  uint16_t usb_frame_counter; ///< USB frame counter at the last frame timer roll-over.
+  /// Telemetry counters, as reported by ::VENDOR_REQUEST_TELEMETRY, without clearing them.
+  uint16_t telemetry[TELEMETRY_COUNTER_COUNT];
+};
+
+/// Request a report on the next call to remote_status_poll(), e.g. after an endpoint reset.
+void remote_status_init();
+
+/** \brief Fill in a new status report if the frame timer rolled over since the last report.
+  * \details Should be called from the USB interrupt handler on every SOF, when the status
+  *   endpoint is ready to queue a new report.
+  * \returns `true` if \a status should be transmitted, `false` if it wasn't modified.
+  */
+bool remote_status_poll(struct remote_status_t* status);
+
+/// @}
+
+#endif // USB_REMOTE_STATUS_H
@@ -55,6 +55,7 @@ except:
     raise ImportError("Failed to load pyUSB. LED displays are not supported.")
 
 import os
+import re
 
 class DisplayLed(object):
     "Class representing the color of an RGB LED with time dependent color and brightness."
@@ -104,10 +105,32 @@ class LedAPA102(DisplayLed):
 class LedWS2811(DisplayLed):
     "WS2811/WS2812 data format: 3×8b RGB"
     DATA_LENGTH = 3
+    GAMMA = 2.2
 
     @classmethod
     def float_to_led_data(cls, rgb):
-        return [int(round(255 * (c**2.2))) for c in rgb]
+        return [int(round(255 * (c**cls.GAMMA))) for c in rgb]
+
+    @classmethod
+    def gamma_table(cls):
+        "Color correction table of a single channel, for displays that apply the gamma themselves."
+        return bytes(bytearray(int(round(255 * ((v/255.)**cls.GAMMA))) for v in range(256)))
+
+class LedWS2811Linear(LedWS2811):
+    "WS2811/WS2812 data format: 3×8b RGB, gamma corrected by the display"
+
+    @classmethod
+    def float_to_led_data(cls, rgb):
+        return [int(round(255 * c)) for c in rgb]
+
+class LedWS2811Dithered(LedWS2811):
+    "WS2811/WS2812 data format with dithering by the display: 3×16b little-endian RGB"
+    DATA_LENGTH = 6
+
+    @classmethod
+    def float_to_led_data(cls, rgb):
+        values = [int(round(0xFFFF * (c**cls.GAMMA))) for c in rgb]
+        return [byte for v in values for byte in (v & 0xFF, v >> 8)]
 
 import threading
 import struct
@@ -130,6 +153,79 @@ class DisplayController:
     __USB_VND_REQ_DISPLAY_PROPERTIES = 2
     __USB_VND_REQ_EEPROM_WRITE = 3
     __USB_VND_REQ_EEPROM_READ = 4
+    __USB_VND_REQ_FRAME_DRAW_STATUS = 5
+    __USB_VND_REQ_FRAME_PRESENTATION_TIME = 7
+    __USB_VND_REQ_REMOTE_FRAME_MODE = 8
+    __USB_VND_REQ_TELEMETRY = 9
+    __USB_VND_REQ_COLOR_LUT = 10
+    __USB_VND_REQ_TRACE = 11
+    __USB_VND_REQ_FRAME_BUDGET = 12
+    __USB_VND_REQ_REMOTE_FRAME_ENCODING = 13
+    __USB_VND_REQ_COLOR_PALETTE = 14
+    __USB_VND_REQ_EVENT_PULSES = 15
+    __USB_VND_REQ_EVENT_PLAYBACK = 16
+
+    # Remote frame modes
+    FRAME_MODE_QUEUE = 0
+    FRAME_MODE_LATEST = 1
+
+    # Frame encodings on EP1
+    FRAME_ENCODING_RAW = 0
+    FRAME_ENCODING_ZERO_RUN = 1
+    FRAME_ENCODING_DELTA = 2
+    FRAME_ENCODING_INDEXED = 3
+
+    # Frame types of FRAME_ENCODING_DELTA
+    DELTA_FRAME_FULL = 0
+    DELTA_FRAME_CHANGES = 1
+
+    # Event playback flags
+    EVENT_PLAYBACK_LOOP = 1
+    # Format of a single pulse, as uploaded to the device
+    __EVENT_PULSE_FORMAT = "<HH4B"
+    # Largest number of pulses in a single upload
+    __EVENT_PULSE_UPLOAD_COUNT = 256
+
+    # Color correction flags
+    COLOR_LUT_ENABLE = 1
+    COLOR_LUT_STORE = 2
+
+    # Telemetry counters, in the order they are reported by the device
+    TELEMETRY_COUNTERS = (
+          "frames_drawn"
+        , "draw_skipped"
+        , "alloc_failed"
+        , "push_refused"
+        , "remote_halted"
+        , "frames_late"
+        , "frames_replaced"
+        , "refresh_skipped"
+    )
+
+    # Status reports on the interrupt endpoint, sent once per display frame
+    __USB_STATUS_ENDPOINT = 0x82
+    __STATUS_FORMAT = "<BBHH{}H".format(len(TELEMETRY_COUNTERS))
+    __STATUS_SIZE = struct.calcsize(__STATUS_FORMAT)
+    STATUS_READY = 1
+    STATUS_HALTED = 2
+
+    # Trace points, in the order of their numbers in the trace records
+    TRACE_POINTS = (
+          "frame_timer_isr"
+        , "usb_isr"
+        , "usb_copy"
+        , "usb_led_isr"
+        , "refresh_timer_isr"
+        , "dma_isr"
+        , "pdb_isr"
+        , "pop_frame"
+        , "display_frame"
+        , "refresh_display"
+        , "render_frame"
+    )
+    TRACE_END_FLAG = 0x80
+    # Largest trace buffer readout, for a device with 512 records
+    __TRACE_READOUT_SIZE = 8 + 4*512
 
     # Display property types
     DP_TYPE_INFORMATION_TYPE = 1
@@ -137,6 +233,8 @@ class DisplayController:
     DP_TYPE_LED_TYPE = 3
     DP_TYPE_BUFFER_SIZE = 4
     DP_TYPE_GROUP_ID = 5
+    DP_TYPE_FRAME_ENCODINGS = 6
+    DP_TYPE_EVENT_PULSE_CAPACITY = 7
     DP_TYPE_END = 0xff
 
     # Information types
@@ -146,6 +244,7 @@ class DisplayController:
     # LED types
     LED_TYPE_APA102 = 0
     LED_TYPE_WS2811 = 1
+    LED_TYPE_WS2811_16 = 2
 
     def __init__(self, device):
         device.default_timeout = 500
@@ -157,6 +256,7 @@ class DisplayController:
         self.device = device
         self.serial_number = device.serial_number
         self.__queryController()
+        self.__selectFrameEncoding()
 
     @property
     def buffer_length(self):
@@ -165,6 +265,8 @@ class DisplayController:
             pixel_length = LedAPA102.DATA_LENGTH
         elif self.led_type == self.LED_TYPE_WS2811:
             pixel_length = LedWS2811.DATA_LENGTH
+        elif self.led_type == self.LED_TYPE_WS2811_16:
+            pixel_length = LedWS2811Dithered.DATA_LENGTH
 
         string_length = 0
         if self.data_type == self.DATA_TYPE_IT_STATION:
@@ -199,6 +301,18 @@ class DisplayController:
         self.data_ranges = list()
         self.led_type = None
         self.group = None
+        # Devices that don't report their encodings only support raw frames
+        self.frame_encodings = 1 << self.FRAME_ENCODING_RAW
+        self.frame_encoding = self.FRAME_ENCODING_RAW
+        # Last frame received by the device, on which delta frames are based
+        self.__previous_frame = None
+        # Devices that don't report a capacity can't play back events
+        self.event_pulse_capacity = 0
+        self.__event_playback = False
+        # Frames that can be sent before the device's queue is full, or None if unknown
+        self.has_status_endpoint = self.__findStatusEndpoint()
+        self.__frame_credits = None
+        self.__frame_mode = self.FRAME_MODE_QUEUE
 
         for t,l,v in self.readDisplayInfo():
             if t == self.DP_TYPE_INFORMATION_TYPE:
@@ -212,6 +326,25 @@ class DisplayController:
                 self.led_type = v[0]
             elif t == self.DP_TYPE_GROUP_ID:
                 self.group = bytes(v)
+            elif t == self.DP_TYPE_FRAME_ENCODINGS:
+                self.frame_encodings = v[0]
+            elif t == self.DP_TYPE_EVENT_PULSE_CAPACITY:
+                self.event_pulse_capacity = struct.unpack("<H", bytes(v))[0]
+
+    def __findStatusEndpoint(self):
+        try:
+            interface = self.device.get_active_configuration()[(0,0)]
+            return any(ep.bEndpointAddress == self.__USB_STATUS_ENDPOINT for ep in interface)
+        except Exception:
+            return False
+
+    def __selectFrameEncoding(self):
+        # Sparse event frames are mostly zeros, so use zero runs if possible.
+        # Delta frames include zero-run encoded frames, and are preferred.
+        if self.frame_encodings & (1 << self.FRAME_ENCODING_DELTA):
+            self.setFrameEncoding(self.FRAME_ENCODING_DELTA)
+        elif self.frame_encodings & (1 << self.FRAME_ENCODING_ZERO_RUN):
+            self.setFrameEncoding(self.FRAME_ENCODING_ZERO_RUN)
 
     @classmethod
     def findAll(cls):
@@ -274,11 +407,401 @@ class DisplayController:
         except Exception as e:
             logger.error("Could not write EEPROM to display: {}".format(e))
 
-    def transmitDisplayBuffer(self, data):
+    def readFrameDrawStatus(self):
+        """Read the display frame counter and USB frame counter of the latest frame draw.
+        :returns: A (display_frame_counter, usb_frame_counter) tuple, or None on failure."""
+        try:
+            data = self.device.ctrl_transfer(
+                  self.__USB_VND_DEV_IN
+                , self.__USB_VND_REQ_FRAME_DRAW_STATUS
+                , 0
+                , 0
+                , 4
+            )
+            return struct.unpack("<HH", bytes(data))
+        except Exception as e:
+            logger.error("Could not read frame draw status from display: {}".format(e))
+
+    def setFrameMode(self, mode):
+        """Select how the device handles frames that arrive faster than they can be drawn.
+        :param int mode: FRAME_MODE_QUEUE to draw every frame, or FRAME_MODE_LATEST to only draw
+            the most recent frame.
+        :returns: True on success, False if the device does not support the mode."""
+        try:
+            self.device.ctrl_transfer(
+                  self.__USB_VND_DEV_OUT
+                , self.__USB_VND_REQ_REMOTE_FRAME_MODE
+                , mode
+                , 0
+            )
+            self.__frame_mode = mode
+            return True
+        except Exception as e:
+            logger.error("Could not set frame mode of display: {}".format(e))
+            return False
+
+    def setFrameEncoding(self, encoding):
+        """Select the encoding of the frames sent by transmitDisplayBuffer().
+        The endpoint is reset to apply the encoding, so any partially transmitted frame is lost.
+        :param int encoding: FRAME_ENCODING_RAW, or one of the other encodings supported by the
+            device, as reported by frame_encodings.
+        :returns: True on success, False if the device does not support the encoding."""
+        try:
+            self.device.ctrl_transfer(
+                  self.__USB_VND_DEV_OUT
+                , self.__USB_VND_REQ_REMOTE_FRAME_ENCODING
+                , encoding
+                , 0
+            )
+            self.device.clear_halt(1)
+            self.frame_encoding = encoding
+            self.__previous_frame = None
+            return True
+        except Exception as e:
+            logger.error("Could not set frame encoding of display: {}".format(e))
+            return False
+
+    @staticmethod
+    def encodeZeroRuns(data):
+        """Encode frame data as runs of zeros and literal bytes, for FRAME_ENCODING_ZERO_RUN.
+        Every run starts with a header byte: n-1 for n zeros, or 0x80|(n-1) followed by n
+        literal bytes, with n at most 128.
+        :param bytes data: Frame buffer data.
+        :returns: The encoded frame, as bytes."""
+        data = bytes(data)
+        return DisplayController.__encodeRuns(data, data)
+
+    @staticmethod
+    def encodeDelta(data, previous):
+        """Encode frame data as a delta frame for FRAME_ENCODING_DELTA, with the same runs as
+        encodeZeroRuns(), but where runs without data keep the bytes of the previous frame.
+        :param bytes data: Frame buffer data.
+        :param bytes previous: Frame buffer data of the previous frame sent to the device.
+        :returns: The encoded frame, including the frame type byte, as bytes."""
+        data = bytes(data)
+        # Unchanged bytes are zero in the difference with the previous frame
+        changes = int.from_bytes(data, "big") ^ int.from_bytes(previous, "big")
+        changes = changes.to_bytes(len(data), "big")
+        return bytes((DisplayController.DELTA_FRAME_CHANGES,)) + DisplayController.__encodeRuns(data, changes)
+
+    @staticmethod
+    def __encodeRuns(data, skip):
+        # Encode data as literal runs, and runs without data where skip contains zeros
+        encoded = bytearray()
+
+        def literal(start, end):
+            while start < end:
+                count = min(end - start, 128)
+                encoded.append(0x80 | (count - 1))
+                encoded.extend(data[start:start+count])
+                start += count
+
+        # A run of fewer than three bytes is not shorter than copying them
+        position = 0
+        for zeros in re.finditer(b"\x00{3,}", skip):
+            literal(position, zeros.start())
+            count = zeros.end() - zeros.start()
+            while count:
+                run = min(count, 128)
+                encoded.append(run - 1)
+                count -= run
+            position = zeros.end()
+        literal(position, len(data))
+        return bytes(encoded)
+
+    def __encodeFrame(self, data, previous):
+        # Encode a frame with the selected encoding. Delta frames are only based on a previous
+        # frame that the device is known to have received, and only if they are shorter.
+        if self.frame_encoding == self.FRAME_ENCODING_ZERO_RUN:
+            return self.encodeZeroRuns(data)
+        elif self.frame_encoding == self.FRAME_ENCODING_DELTA:
+            encoded = bytes((self.DELTA_FRAME_FULL,)) + self.encodeZeroRuns(data)
+            if previous is not None and len(previous) == len(data):
+                delta = self.encodeDelta(data, previous)
+                if len(delta) < len(encoded):
+                    encoded = delta
+            return encoded
+        return data
+
+    def readStatus(self, timeout=None):
+        """Read a status report from the device's interrupt endpoint. A report is queued once
+        per display frame, so this waits for the next frame if the last report was already read.
+        :param int timeout: Timeout in milliseconds, or None to use the default timeout.
+        :returns: A dict with the number of frames that can be queued ("queue_free"), whether a
+            frame can be received ("ready") and whether EP1 is halted ("halted"), the counters of
+            the latest frame draw ("display_frame_counter", "usb_frame_counter"), and a dict of
+            telemetry counters by name ("telemetry"), or None if no report was received."""
+        if not self.has_status_endpoint:
+            return None
         try:
+            data = self.device.read(self.__USB_STATUS_ENDPOINT, self.__STATUS_SIZE, timeout)
+            values = struct.unpack(self.__STATUS_FORMAT, bytes(data))
+        except Exception:
+            return None
+        queue_free, flags, display_frame_counter, usb_frame_counter = values[:4]
+        return {
+              "queue_free": queue_free
+            , "ready": bool(flags & self.STATUS_READY)
+            , "halted": bool(flags & self.STATUS_HALTED)
+            , "display_frame_counter": display_frame_counter
+            , "usb_frame_counter": usb_frame_counter
+            , "telemetry": dict(zip(self.TELEMETRY_COUNTERS, values[4:]))
+        }
+
+    def __updateFrameCredits(self, status):
+        if status["halted"]:
+            # Clear the halt now, instead of losing the next frame to the stalled endpoint
+            try:
+                self.device.clear_halt(1)
+                self.__previous_frame = None
+                status["ready"] = True
+            except Exception:
+                pass
+        self.__frame_credits = status["queue_free"] if status["ready"] else 0
+
+    def __acquireFrameCredit(self):
+        # Frames are never refused without status reports, or when they replace each other
+        if not self.has_status_endpoint or self.__frame_mode == self.FRAME_MODE_LATEST:
+            return True
+        # Use any pending report, and wait for the next ones if the queue is full
+        status = self.readStatus(1)
+        if status is not None:
+            self.__updateFrameCredits(status)
+        deadline = time.time() + 2./25
+        while not self.__frame_credits:
+            remaining = int(1000*(deadline - time.time()))
+            if remaining <= 0:
+                return False
+            status = self.readStatus(remaining)
+            if status is not None:
+                self.__updateFrameCredits(status)
+        self.__frame_credits -= 1
+        return True
+
+    def readTelemetry(self, clear=False):
+        """Read the device's frame telemetry counters.
+        :param bool clear: Reset the counters on the device after reading them.
+        :returns: A dict of counter values by name, or None on failure. Counters that are not
+            supported by the device are not included."""
+        try:
+            data = self.device.ctrl_transfer(
+                  self.__USB_VND_DEV_IN
+                , self.__USB_VND_REQ_TELEMETRY
+                , 1 if clear else 0
+                , 0
+                , 2*len(self.TELEMETRY_COUNTERS)
+            )
+            values = struct.unpack("<{}H".format(len(data)//2), bytes(data[:len(data)//2*2]))
+            return dict(zip(self.TELEMETRY_COUNTERS, values))
+        except Exception as e:
+            logger.error("Could not read telemetry from display: {}".format(e))
+
+    def readFrameBudget(self, clear=False):
+        """Read how much of the frame interval the device's main loop uses.
+        :param bool clear: Reset the statistics on the device after reading them.
+        :returns: A dict with the nominal frame interval ("interval_ms"), the lowest slack to
+            the next frame timer tick ("min_slack_ms", negative if frame draws were missed), the
+            number of measured frames ("frames_measured") and of missed timer ticks
+            ("ticks_missed"), or None on failure."""
+        try:
+            data = self.device.ctrl_transfer(
+                  self.__USB_VND_DEV_IN
+                , self.__USB_VND_REQ_FRAME_BUDGET
+                , 1 if clear else 0
+                , 0
+                , 16
+            )
+            interval_us, interval_counts, min_slack, frames, missed = struct.unpack(
+                "<IIiHH", bytes(data)
+            )
+            return {
+                  "interval_ms": interval_us/1000.
+                , "min_slack_ms": min_slack*interval_us/1000./interval_counts
+                , "frames_measured": frames
+                , "ticks_missed": missed
+            }
+        except Exception as e:
+            logger.error("Could not read frame budget from display: {}".format(e))
+
+    def readTrace(self, clear=False):
+        """Read the records in the device's timing trace buffer.
+        :param bool clear: Remove the read records from the device's buffer.
+        :returns: A tuple (timestamp frequency, number of records lost, records), or None on
+            failure. Records are (timestamp, point, end) tuples, from oldest to newest, with
+            24 bit timestamps that wrap around."""
+        try:
+            data = bytes(self.device.ctrl_transfer(
+                  self.__USB_VND_DEV_IN
+                , self.__USB_VND_REQ_TRACE
+                , 1 if clear else 0
+                , 0
+                , self.__TRACE_READOUT_SIZE
+            ))
+            frequency, count, lost = struct.unpack("<IHH", data[:8])
+            words = struct.unpack("<{}I".format(count), data[8:8+4*count])
+            records = [
+                  (word & 0xffffff, (word >> 24) & 0x7f, bool((word >> 24) & self.TRACE_END_FLAG))
+                  for word in words
+            ]
+            return (frequency, lost, records)
+        except Exception as e:
+            logger.error("Could not read trace from display: {}".format(e))
+
+    def readColorLutFlags(self):
+        """Read whether the device applies color correction tables to the frame data.
+        :returns: A combination of COLOR_LUT_ENABLE and COLOR_LUT_STORE, or None if the device
+            does not support color correction."""
+        try:
+            data = self.device.ctrl_transfer(
+                  self.__USB_VND_DEV_IN
+                , self.__USB_VND_REQ_COLOR_LUT
+                , 0
+                , 0
+                , 1
+            )
+            return data[0]
+        except Exception as e:
+            logger.debug("Could not read color correction of display: {}".format(e))
+
+    def writeColorLut(self, tables, store=False):
+        """Upload color correction tables, which the device applies to every color byte.
+        :param bytes tables: 256 bytes for each of the red, green, and blue channels.
+        :param bool store: Also store the tables in the device's EEPROM.
+        :returns: True on success, False if the device does not support color correction."""
+        flags = self.COLOR_LUT_ENABLE
+        if store:
+            flags |= self.COLOR_LUT_STORE
+        try:
+            self.device.ctrl_transfer(
+                  self.__USB_VND_DEV_OUT
+                , self.__USB_VND_REQ_COLOR_LUT
+                , flags
+                , 0
+                , tables
+            )
+            return True
+        except Exception as e:
+            logger.debug("Could not write color correction to display: {}".format(e))
+            return False
+
+    def writeColorPalette(self, entries, offset=0):
+        """Upload color palette entries, used to expand frames sent with FRAME_ENCODING_INDEXED.
+        The palette should only be changed in between frames.
+        :param bytes entries: Palette entries, each in the format of a single LED in the frame
+            buffer, e.g. RGB or bRGB.
+        :param int offset: Byte offset of the entries in the palette, i.e. the index of the first
+            entry times the LED size.
+        :returns: True on success, False if the device does not support indexed frames."""
+        try:
+            self.device.ctrl_transfer(
+                  self.__USB_VND_DEV_OUT
+                , self.__USB_VND_REQ_COLOR_PALETTE
+                , 0
+                , offset
+                , entries
+            )
+            return True
+        except Exception as e:
+            logger.debug("Could not write color palette to display: {}".format(e))
+            return False
+
+    def uploadEventPulses(self, pulses):
+        """Upload the pulses of an event, to be played back by the device with
+        startEventPlayback(). Any running playback is stopped.
+        :param pulses: Sequence of (frame, led, (red, green, blue), brightness) tuples, sorted by
+            frame. `led` is the index of the LED in the frame buffer.
+        :returns: True on success, False if the device can't store the pulses."""
+        if len(pulses) > self.event_pulse_capacity:
+            logger.debug("Event has more pulses than the display can store")
+            return False
+
+        self.__event_playback = False
+        try:
+            step = self.__EVENT_PULSE_UPLOAD_COUNT
+            for first in range(0, len(pulses), step):
+                data = b"".join(
+                    struct.pack(self.__EVENT_PULSE_FORMAT, frame, led, r, g, b, brightness)
+                    for frame, led, (r, g, b), brightness in pulses[first:first+step]
+                )
+                self.device.ctrl_transfer(
+                      self.__USB_VND_DEV_OUT
+                    , self.__USB_VND_REQ_EVENT_PULSES
+                    , 0
+                    , first
+                    , data
+                )
+            return True
+        except Exception as e:
+            logger.debug("Could not upload event to display: {}".format(e))
+            return False
+
+    def startEventPlayback(self, pulse_count, duration, rise_frames=1, decay_frames=0, loop=False):
+        """Start the playback of the uploaded pulses, which is rendered by the device at its own
+        frame rate. Frames written with transmitDisplayBuffer() stop the playback.
+        :param int pulse_count: Number of uploaded pulses to play back.
+        :param int duration: Number of frames of the playback.
+        :param int rise_frames: Number of frames until a pulse reaches its peak brightness.
+        :param int decay_frames: Number of frames over which a pulse fades out, or 0 to keep
+            pulses lit until the end of the playback.
+        :param bool loop: Restart the playback after `duration` frames.
+        :returns: True on success, False if the device does not support event playback."""
+        flags = self.EVENT_PLAYBACK_LOOP if loop else 0
+        try:
+            self.device.ctrl_transfer(
+                  self.__USB_VND_DEV_OUT
+                , self.__USB_VND_REQ_EVENT_PLAYBACK
+                , 0
+                , 0
+                , struct.pack("<HHBBBB", pulse_count, duration, rise_frames, decay_frames, flags, 0)
+            )
+            self.__event_playback = True
+            return True
+        except Exception as e:
+            logger.debug("Could not start event playback: {}".format(e))
+            return False
+
+    def stopEventPlayback(self):
+        """Stop the event playback, and return to showing the frames sent by the host."""
+        try:
+            self.device.ctrl_transfer(
+                  self.__USB_VND_DEV_OUT
+                , self.__USB_VND_REQ_EVENT_PLAYBACK
+                , 0
+                , 0
+            )
+            self.__event_playback = False
+            return True
+        except Exception as e:
+            logger.debug("Could not stop event playback: {}".format(e))
+            return False
+
+    def transmitDisplayBuffer(self, data, display_frame=None):
+        """Write frame data to the device.
+        :param bytes data: Frame buffer data, or one palette index per LED with
+            FRAME_ENCODING_INDEXED.
+        :param int display_frame: Optional display frame counter value at which the frame is to
+            be drawn. See readFrameDrawStatus() for the device's current counter value."""
+        # Frames from the host would be interleaved with the played back frames
+        if self.__event_playback:
+            self.stopEventPlayback()
+        # Drop the frame instead of stalling the endpoint when the device's queue is full
+        if not self.__acquireFrameCredit():
+            logger.debug("Display {} has no room for another frame".format(self.serial_number))
+            return
+        try:
+            if display_frame is not None:
+                self.device.ctrl_transfer(
+                      self.__USB_VND_DEV_OUT
+                    , self.__USB_VND_REQ_FRAME_PRESENTATION_TIME
+                    , display_frame & 0xffff
+                    , 0
+                )
             logger.debug("Sending frame data to {}".format(self.serial_number))
+            # Until the frame is written, the device's previous frame is unknown
+            previous_frame, self.__previous_frame = self.__previous_frame, None
             # Write data to EP1
-            self.device.write(1, data, 40)
+            self.device.write(1, self.__encodeFrame(data, previous_frame), 40)
+            self.__previous_frame = bytes(data)
         except usb.core.USBError as usb_error:
             # TODO Better error handling
             logger.error(
@@ -299,6 +822,11 @@ class DisplayController:
                 try:
                     match_function = lambda d: d.serial_number == self.serial_number
                     self.device = usb.core.find(idVendor=0x1CE3, custom_match=match_function)
+                    # A reattached device starts with raw frames and an empty queue
+                    self.frame_encoding = self.FRAME_ENCODING_RAW
+                    self.__selectFrameEncoding()
+                    self.has_status_endpoint = self.__findStatusEndpoint()
+                    self.__frame_credits = None
                 except:
                     pass
         except Exception as e:
@@ -406,6 +934,10 @@ class LogicalDisplay:
             self.__led_class = LedAPA102
         elif led_type == DisplayController.LED_TYPE_WS2811:
             self.__led_class = LedWS2811
+            if all(self.__enableColorCorrection(c) for c in self.controllers.values()):
+                self.__led_class = LedWS2811Linear
+        elif led_type == DisplayController.LED_TYPE_WS2811_16:
+            self.__led_class = LedWS2811Dithered
         else:
             raise ValueError("Unknown LED type: {}".format(led_type))
             self.__led_class = None
@@ -435,6 +967,18 @@ class LogicalDisplay:
         self.__data_buffer = None
         self.__data_buffer_lock = threading.Lock()
 
+    @staticmethod
+    def __enableColorCorrection(controller):
+        """Let the controller gamma correct the frame data, unless it already applies its own
+        color correction, e.g. with a white balance correction stored in EEPROM."""
+        flags = controller.readColorLutFlags()
+        if flags is None:
+            return False
+        elif flags & DisplayController.COLOR_LUT_ENABLE:
+            return True
+        else:
+            return controller.writeColorLut(3*LedWS2811.gamma_table())
+
     def open(self):
         if self.__multithreading and self.__workers is None:
             self.__workers = list()
@@ -113,6 +113,10 @@ class VirtualController(DisplayController):
         else:
             raise ValueError("data block out of range")
 
+    def readColorLutFlags(self):
+        # Frames are rendered as received, so the host keeps applying the gamma correction
+        return None
+
     def transmitDisplayBuffer(self, data):
         if len(data) != self.buffer_length:
           raise ValueError("Invalid buffer length")
@@ -0,0 +1,93 @@
+#!/usr/bin/python3
+# -*- coding: utf-8 -*-
+#
+# Poll the frame telemetry counters of all connected displays, and plot the number of events
+# per polling interval once polling is stopped (with Ctrl-C, or after the requested duration).
+# The frame budget is polled as well: the number of missed frame timer ticks, and the lowest
+# slack to the next tick of the main loop's work on a frame during every polling interval.
+
+import logging
+logger = logging.getLogger("icecube.LedDisplay")
+logger.setLevel(logging.INFO)
+handler = logging.StreamHandler()
+logger.addHandler(handler)
+
+import time
+
+import sys, os
+sys.path.append(os.path.dirname(os.path.realpath(__file__))+"/../steamshovel")
+
+from LedDisplay import DisplayController
+
+import argparse
+parser = argparse.ArgumentParser(description="Poll and plot display frame telemetry")
+parser.add_argument("-i", "--interval", type=float, help="Polling interval in seconds. Defaults to 1.", default=1.)
+parser.add_argument("-d", "--duration", type=float, help="Polling duration in seconds. Defaults to 0, i.e. until interrupted.", default=0.)
+parser.add_argument("-o", "--output", help="Save the plot to this file instead of showing it.", default=None)
+parser.add_argument("-n", "--no-plot", action="store_true", help="Only print the counter values.", default=False)
+args = parser.parse_args(sys.argv[1:])
+
+controllers = DisplayController.findAll()
+if len(controllers) == 0:
+  print("No displays found")
+  sys.exit(1)
+
+counters = DisplayController.TELEMETRY_COUNTERS + ("ticks_missed", "min_slack_ms")
+print("{:>8} {:>16} ".format("time", "display") + " ".join("{:>15}".format(c) for c in counters))
+
+# Discard events that happened before polling started
+for controller in controllers:
+  controller.readTelemetry(clear=True)
+  controller.readFrameBudget(clear=True)
+
+# Per display: list of (time, {counter: value}) samples
+samples = {controller.serial_number: [] for controller in controllers}
+start = time.monotonic()
+next_poll = start
+
+try:
+  while args.duration <= 0 or next_poll - start < args.duration:
+    next_poll += args.interval
+    time.sleep(max(0, next_poll - time.monotonic()))
+    now = time.monotonic() - start
+    for controller in controllers:
+      values = controller.readTelemetry(clear=True)
+      if values is None:
+        # Counts of a failed request are lost, so leave a gap in the plot
+        continue
+      budget = controller.readFrameBudget(clear=True)
+      if budget is not None:
+        values["ticks_missed"] = budget["ticks_missed"]
+        if budget["frames_measured"] > 0:
+          values["min_slack_ms"] = budget["min_slack_ms"]
+      samples[controller.serial_number].append((now, values))
+      print(
+          "{:8.1f} {:>16} ".format(now, controller.serial_number)
+        + " ".join("{:15g}".format(values.get(c, 0)) for c in counters)
+      )
+except KeyboardInterrupt:
+  pass
+
+if args.no_plot:
+  sys.exit(0)
+
+if args.output:
+  import matplotlib
+  matplotlib.use("Agg")
+import matplotlib.pyplot as plt
+
+figure, axes = plt.subplots(len(counters), 1, sharex=True, figsize=(8, 1.6*len(counters)))
+for axis, counter in zip(axes, counters):
+  for serial, device_samples in samples.items():
+    times = [t for t, values in device_samples if counter in values]
+    counts = [values[counter] for t, values in device_samples if counter in values]
+    axis.plot(times, counts, marker=".", label=serial)
+  axis.set_ylabel(counter.replace("_", " "), fontsize="small")
+axes[0].legend(fontsize="small")
+axes[-1].set_xlabel("time [s]")
+figure.suptitle("Events per {} s".format(args.interval))
+
+if args.output:
+  figure.savefig(args.output)
+else:
+  plt.show()
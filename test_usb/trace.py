@@ -0,0 +1,115 @@
+#!/usr/bin/python3
+# -*- coding: utf-8 -*-
+#
+# Collect the timing trace of all connected displays, and write it in the Chrome trace event
+# format once collection is stopped (with Ctrl-C, or after the requested duration).
+# The output can be opened with chrome://tracing or https://ui.perfetto.dev.
+# The firmware has to be built with the TRACE option.
+
+import logging
+logger = logging.getLogger("icecube.LedDisplay")
+logger.setLevel(logging.INFO)
+handler = logging.StreamHandler()
+logger.addHandler(handler)
+
+import json
+import time
+
+import sys, os
+sys.path.append(os.path.dirname(os.path.realpath(__file__))+"/../steamshovel")
+
+from LedDisplay import DisplayController
+
+import argparse
+parser = argparse.ArgumentParser(description="Collect display timing traces")
+parser.add_argument("-i", "--interval", type=float, help="Polling interval in seconds. Defaults to 0.05.", default=0.05)
+parser.add_argument("-d", "--duration", type=float, help="Collection duration in seconds. Defaults to 0, i.e. until interrupted.", default=0.)
+parser.add_argument("-o", "--output", help="Trace event file to write. Defaults to trace.json.", default="trace.json")
+args = parser.parse_args(sys.argv[1:])
+
+TIMESTAMP_BITS = 24
+TIMESTAMP_MASK = (1 << TIMESTAMP_BITS) - 1
+
+# Trace points recorded from the main loop, all others are interrupts
+MAIN_LOOP_POINTS = ("pop_frame", "display_frame", "refresh_display", "render_frame")
+
+class TraceDecoder:
+  """Unwrap the record timestamps of one display, and convert them to trace events."""
+  def __init__(self, serial):
+    self.serial = serial
+    self.last_timestamp = None
+    self.resume_timestamp = 0
+    self.events = []
+    self.open_points = set()
+    self.lost = 0
+
+  def decode(self, frequency, lost, records):
+    self.lost += lost
+    if lost:
+      # Time between the remaining records and the previous ones is unknown
+      if self.last_timestamp is not None:
+        self.resume_timestamp = self.last_timestamp
+      self.last_timestamp = None
+      self.open_points.clear()
+    for timestamp, point, end in records:
+      if self.last_timestamp is None:
+        # Continue after the last known time, assuming less than one timestamp wrap was lost
+        self.last_timestamp = (self.resume_timestamp & ~TIMESTAMP_MASK) + timestamp
+        if self.last_timestamp < self.resume_timestamp:
+          self.last_timestamp += 1 << TIMESTAMP_BITS
+      # Interrupt records can be stored just before a slightly earlier record, so use the
+      # signed difference with the previous timestamp
+      delta = (timestamp - self.last_timestamp) & TIMESTAMP_MASK
+      if delta >= (1 << (TIMESTAMP_BITS - 1)):
+        delta -= 1 << TIMESTAMP_BITS
+      self.last_timestamp += delta
+
+      if point < len(DisplayController.TRACE_POINTS):
+        name = DisplayController.TRACE_POINTS[point]
+      else:
+        name = "point_{}".format(point)
+      if end:
+        if point not in self.open_points:
+          continue
+        self.open_points.discard(point)
+      else:
+        self.open_points.add(point)
+      self.events.append({
+          "name": name
+        , "ph": "E" if end else "B"
+        , "ts": 1e6*self.last_timestamp/frequency
+        , "pid": self.serial
+        , "tid": "main loop" if name in MAIN_LOOP_POINTS else "interrupts"
+      })
+
+controllers = DisplayController.findAll()
+if len(controllers) == 0:
+  print("No displays found")
+  sys.exit(1)
+
+# Discard records from before collection started
+for controller in controllers:
+  controller.readTrace(clear=True)
+
+decoders = {controller.serial_number: TraceDecoder(controller.serial_number) for controller in controllers}
+start = time.monotonic()
+next_poll = start
+
+try:
+  while args.duration <= 0 or next_poll - start < args.duration:
+    next_poll += args.interval
+    time.sleep(max(0, next_poll - time.monotonic()))
+    for controller in controllers:
+      trace = controller.readTrace(clear=True)
+      if trace is not None:
+        decoders[controller.serial_number].decode(*trace)
+except KeyboardInterrupt:
+  pass
+
+events = []
+for serial, decoder in decoders.items():
+  print("{:>16}: {:8d} events, {:6d} records lost".format(serial, len(decoder.events), decoder.lost))
+  events.extend(decoder.events)
+
+with open(args.output, "w") as output:
+  json.dump({"traceEvents": events, "displayTimeUnit": "ms"}, output)